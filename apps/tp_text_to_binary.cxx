@@ -0,0 +1,63 @@
+/**
+ * @file tp_text_to_binary.cxx Convert a text TP file to the binary TP file format read by TriggerPrimitiveMaker
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#include "CLI/CLI.hpp"
+
+#include "trigger/Issues.hpp"
+#include "trigger/TPFile.hpp"
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int
+main(int argc, char** argv)
+{
+  CLI::App app{ "Convert a text TP file to a binary TP file that TriggerPrimitiveMaker can memory-map" };
+
+  std::string input_filename;
+  std::string output_filename;
+  app.add_option("-i,--input", input_filename, "Input text TP file")->required();
+  app.add_option("-o,--output", output_filename, "Output binary TP file")->required();
+
+  CLI11_PARSE(app, argc, argv);
+
+  std::ifstream input(input_filename);
+  if (!input) {
+    std::cerr << "Could not open " << input_filename << std::endl;
+    return 1;
+  }
+
+  // Same as TriggerPrimitiveMaker, we drop TPs that are out of order
+  std::vector<triggeralgs::TriggerPrimitive> tps;
+  size_t n_unsorted = 0;
+  triggeralgs::TriggerPrimitive tp;
+  while (dunedaq::trigger::read_tp_text(input, tp)) {
+    if (tps.empty() || tp.time_start >= tps.back().time_start) {
+      tps.push_back(tp);
+    } else {
+      ++n_unsorted;
+    }
+  }
+
+  try {
+    dunedaq::trigger::write_tp_file(output_filename, tps);
+  } catch (const dunedaq::trigger::BadTPFile& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "Wrote " << tps.size() << " TPs to " << output_filename;
+  if (n_unsorted > 0) {
+    std::cout << ". Dropped " << n_unsorted << " TPs that were earlier than the TP before them";
+  }
+  std::cout << std::endl;
+  return 0;
+}
@@ -0,0 +1,294 @@
+/**
+ * @file AlgorithmDispatch.hpp
+ *
+ * Registry of typed slice processors for trigger algorithm plugins, so that
+ * TriggerGenericWorker can call a plugin's operator() without going through
+ * the virtual function table for every input object
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_ALGORITHMDISPATCH_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_ALGORITHMDISPATCH_HPP_
+
+#include "trigger/TPSliceColumns.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+#include "triggeralgs/TriggerCandidate.hpp"
+#include "triggeralgs/TriggerCandidateMaker.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief Detects whether KLASS has a batch entry point that takes a whole
+ * time slice at once, ie one of
+ *
+ *   void operator()(const A* first, const A* last, std::vector<B>& out);
+ *   void operator()(std::span<const A> slice, std::vector<B>& out); // C++20 only
+ */
+template<class KLASS, class A, class B, class = void>
+struct has_batch_call : std::false_type
+{};
+
+template<class KLASS, class A, class B>
+struct has_batch_call<
+  KLASS,
+  A,
+  B,
+  std::void_t<decltype(std::declval<KLASS&>()(std::declval<const A*>(), std::declval<const A*>(), std::declval<std::vector<B>&>()))>>
+  : std::true_type
+{};
+
+template<class KLASS, class A, class B, class = void>
+struct has_span_batch_call : std::false_type
+{};
+
+#if defined(__cpp_lib_span) && __cpp_lib_span >= 202002L
+template<class KLASS, class A, class B>
+struct has_span_batch_call<
+  KLASS,
+  A,
+  B,
+  std::void_t<decltype(std::declval<KLASS&>()(std::declval<std::span<const A>>(), std::declval<std::vector<B>&>()))>>
+  : std::true_type
+{};
+#endif
+
+/**
+ * @brief Detects whether KLASS has an entry point that takes the column view
+ * of a TriggerPrimitive slice along with the slice itself, ie
+ *
+ *   void operator()(const TPSliceColumns& columns, const A* first, const A* last, std::vector<B>& out);
+ */
+template<class KLASS, class A, class B, class = void>
+struct has_columns_call : std::false_type
+{};
+
+template<class KLASS, class A, class B>
+struct has_columns_call<KLASS,
+                        A,
+                        B,
+                        std::void_t<decltype(std::declval<KLASS&>()(std::declval<const TPSliceColumns&>(),
+                                                                    std::declval<const A*>(),
+                                                                    std::declval<const A*>(),
+                                                                    std::declval<std::vector<B>&>()))>>
+  : std::true_type
+{};
+
+/**
+ * @brief Detects whether KLASS says which of the TPSliceColumns fields its
+ * columns entry point reads, ie
+ *
+ *   TPSliceColumns::fields_t get_column_fields() const;
+ *
+ * Makers with a columns entry point and no get_column_fields are given all
+ * of the fields
+ */
+template<class KLASS, class = void>
+struct has_column_fields : std::false_type
+{};
+
+template<class KLASS>
+struct has_column_fields<KLASS, std::void_t<decltype(std::declval<const KLASS&>().get_column_fields())>>
+  : std::true_type
+{};
+
+/**
+ * @brief The TPSliceColumns fields that a maker whose concrete class is
+ * KLASS reads, or none if it doesn't take columns
+ */
+template<class KLASS, class BASE, class A, class B>
+TPSliceColumns::fields_t
+column_fields_typed(const BASE& maker)
+{
+  if constexpr (!has_columns_call<KLASS, A, B>::value) {
+    return 0;
+  } else if constexpr (has_column_fields<KLASS>::value) {
+    return static_cast<const KLASS&>(maker).get_column_fields();
+  } else {
+    return TPSliceColumns::s_all_fields;
+  }
+}
+
+/**
+ * @brief Runs a whole time slice through a maker whose concrete class is
+ * KLASS. If KLASS has a columns entry point and `columns` is given, the slice
+ * and its columns are passed to it in one call. Otherwise, if KLASS has a
+ * batch entry point, the slice is passed to that. Otherwise, KLASS's
+ * operator() is called for each object, and the qualified call is not
+ * virtual, so the compiler can inline the algorithm into the loop
+ */
+template<class KLASS, class BASE, class A, class B>
+void
+process_slice_typed(BASE& maker, const A* first, const A* last, const TPSliceColumns* columns, std::vector<B>& out)
+{
+  KLASS& typed_maker = static_cast<KLASS&>(maker);
+  if constexpr (has_columns_call<KLASS, A, B>::value) {
+    if (columns) {
+      typed_maker(*columns, first, last, out);
+      return;
+    }
+  }
+  if constexpr (has_batch_call<KLASS, A, B>::value) {
+    typed_maker(first, last, out);
+#if defined(__cpp_lib_span) && __cpp_lib_span >= 202002L
+  } else if constexpr (has_span_batch_call<KLASS, A, B>::value) {
+    typed_maker(std::span<const A>(first, last), out);
+#endif
+  } else {
+    for (; first != last; ++first) {
+      typed_maker.KLASS::operator()(*first, out);
+    }
+  }
+}
+
+/**
+ * @brief Map from the concrete class of a maker to the process_slice_typed
+ * instantiation for that class. There is one registry for each of the
+ * TriggerActivityMaker and TriggerCandidateMaker interfaces, shared by all
+ * of the plugins that are loaded
+ */
+template<class BASE, class A, class B>
+class SliceProcessorRegistry
+{
+public:
+  using processor_t = void (*)(BASE&, const A*, const A*, const TPSliceColumns*, std::vector<B>&);
+  using column_fields_t = TPSliceColumns::fields_t (*)(const BASE&);
+
+  static SliceProcessorRegistry& get();
+
+  void add(const std::type_info& type, processor_t processor, column_fields_t column_fields)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_processors[std::type_index(type)] = Entry{ processor, column_fields };
+  }
+
+  // Returns nullptr if no processor is registered for the concrete class of `maker`
+  processor_t find(const BASE& maker) const
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    auto it = m_processors.find(std::type_index(typeid(maker)));
+    return it == m_processors.end() ? nullptr : it->second.processor;
+  }
+
+  // The TPSliceColumns fields that `maker` reads through its processor, or none
+  TPSliceColumns::fields_t column_fields(const BASE& maker) const
+  {
+    column_fields_t column_fields = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      auto it = m_processors.find(std::type_index(typeid(maker)));
+      if (it != m_processors.end()) {
+        column_fields = it->second.column_fields;
+      }
+    }
+    return column_fields ? column_fields(maker) : 0;
+  }
+
+private:
+  SliceProcessorRegistry() = default;
+
+  struct Entry
+  {
+    processor_t processor;
+    column_fields_t column_fields;
+  };
+
+  mutable std::mutex m_mutex;
+  std::map<std::type_index, Entry> m_processors;
+};
+
+using TASliceProcessorRegistry = SliceProcessorRegistry<triggeralgs::TriggerActivityMaker,
+                                                        triggeralgs::TriggerPrimitive,
+                                                        triggeralgs::TriggerActivity>;
+using TCSliceProcessorRegistry = SliceProcessorRegistry<triggeralgs::TriggerCandidateMaker,
+                                                        triggeralgs::TriggerActivity,
+                                                        triggeralgs::TriggerCandidate>;
+
+// The registries live in the trigger library, so that plugins and the
+// modules that load them see the same ones
+extern template class SliceProcessorRegistry<triggeralgs::TriggerActivityMaker,
+                                             triggeralgs::TriggerPrimitive,
+                                             triggeralgs::TriggerActivity>;
+extern template class SliceProcessorRegistry<triggeralgs::TriggerCandidateMaker,
+                                             triggeralgs::TriggerActivity,
+                                             triggeralgs::TriggerCandidate>;
+
+/**
+ * @brief Register the typed slice processor for KLASS. Called from
+ * DEFINE_DUNE_TA_MAKER and DEFINE_DUNE_TC_MAKER when the plugin is loaded
+ */
+template<class BASE, class A, class B, class KLASS>
+bool
+register_slice_processor()
+{
+  static_assert(std::is_base_of_v<BASE, KLASS>, "Plugin class must derive from the maker interface");
+  SliceProcessorRegistry<BASE, A, B>::get().add(
+    typeid(KLASS), &process_slice_typed<KLASS, BASE, A, B>, &column_fields_typed<KLASS, BASE, A, B>);
+  return true;
+}
+
+/**
+ * @brief Find the typed slice processor for the concrete class of `maker`.
+ * Returns nullptr if there isn't one, in which case the caller should fall
+ * back to calling maker's virtual operator() for each object
+ */
+template<class MAKER, class A, class B>
+auto
+find_slice_processor(const MAKER& maker) -> void (*)(MAKER&, const A*, const A*, const TPSliceColumns*, std::vector<B>&)
+{
+  if constexpr (std::is_same_v<SliceProcessorRegistry<MAKER, A, B>, TASliceProcessorRegistry> ||
+                std::is_same_v<SliceProcessorRegistry<MAKER, A, B>, TCSliceProcessorRegistry>) {
+    return SliceProcessorRegistry<MAKER, A, B>::get().find(maker);
+  } else {
+    return nullptr;
+  }
+}
+
+/**
+ * @brief The TPSliceColumns fields that the typed slice processor for the
+ * concrete class of `maker` reads from each slice. The caller only needs to
+ * fill these, and none at all if this is zero. Ask again after the maker is
+ * configured, since it may depend on the configuration
+ */
+template<class MAKER, class A, class B>
+TPSliceColumns::fields_t
+slice_processor_column_fields(const MAKER& maker)
+{
+  if constexpr (std::is_same_v<SliceProcessorRegistry<MAKER, A, B>, TASliceProcessorRegistry>) {
+    return SliceProcessorRegistry<MAKER, A, B>::get().column_fields(maker);
+  } else {
+    return 0;
+  }
+}
+
+/**
+ * @brief Whether the typed slice processor for the concrete class of `maker`
+ * wants the TPSliceColumns of each slice
+ */
+template<class MAKER, class A, class B>
+bool
+slice_processor_uses_columns(const MAKER& maker)
+{
+  return slice_processor_column_fields<MAKER, A, B>(maker) != 0;
+}
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_ALGORITHMDISPATCH_HPP_
@@ -11,6 +11,8 @@
 #ifndef TRIGGER_INCLUDE_TRIGGER_ALGORITHMPLUGINS_HPP_
 #define TRIGGER_INCLUDE_TRIGGER_ALGORITHMPLUGINS_HPP_
 
+#include "trigger/AlgorithmDispatch.hpp"
+
 #include "triggeralgs/TriggerActivityMaker.hpp"
 #include "triggeralgs/TriggerCandidateMaker.hpp"
 #include "triggeralgs/TriggerDecisionMaker.hpp"
@@ -21,7 +23,8 @@
 #include <string>
 
 /**
- * @brief Declare the function that will be called by the plugin loader
+ * @brief Declare the function that will be called by the plugin loader, and
+ * register the typed slice processor for the class when the plugin is loaded
  * @param klass Class to be defined as a DUNE TAMaker module
  */
 // NOLINTNEXTLINE(build/define_used)
@@ -32,6 +35,13 @@
     {                                                                                                                  \
       return std::shared_ptr<triggeralgs::TriggerActivityMaker>(new klass());                                            \
     }                                                                                                                  \
+  }                                                                                                                    \
+  namespace {                                                                                                          \
+  [[maybe_unused]] const bool dune_ta_maker_registered =                                                               \
+    dunedaq::trigger::register_slice_processor<triggeralgs::TriggerActivityMaker,                                      \
+                                               triggeralgs::TriggerPrimitive,                                          \
+                                               triggeralgs::TriggerActivity,                                           \
+                                               klass>();                                                               \
   }
 
 namespace dunedaq::trigger {
@@ -53,7 +63,8 @@ make_ta_maker(std::string const& plugin_name)
 } // namespace dunedaq::trigger
 
 /**
- * @brief Declare the function that will be called by the plugin loader
+ * @brief Declare the function that will be called by the plugin loader, and
+ * register the typed slice processor for the class when the plugin is loaded
  * @param klass Class to be defined as a DUNE TCMaker module
  */
 // NOLINTNEXTLINE(build/define_used)
@@ -64,6 +75,13 @@ make_ta_maker(std::string const& plugin_name)
     {                                                                                                                  \
       return std::shared_ptr<triggeralgs::TriggerCandidateMaker>(new klass());                                           \
     }                                                                                                                  \
+  }                                                                                                                    \
+  namespace {                                                                                                          \
+  [[maybe_unused]] const bool dune_tc_maker_registered =                                                               \
+    dunedaq::trigger::register_slice_processor<triggeralgs::TriggerCandidateMaker,                                     \
+                                               triggeralgs::TriggerActivity,                                           \
+                                               triggeralgs::TriggerCandidate,                                          \
+                                               klass>();                                                               \
   }
 
 namespace dunedaq::trigger {
@@ -35,6 +35,18 @@ ERS_DECLARE_ISSUE(trigger, TriggerEndOfRun, "End of run " << runno, ((int64_t)ru
 
 ERS_DECLARE_ISSUE(trigger, UnknownGeoID, "Unknown GeoID: " << geo_id, ((daqdataformats::GeoID)geo_id))
 ERS_DECLARE_ISSUE(trigger, InvalidSystemType, "Unknown system type " << type, ((std::string)type))
+ERS_DECLARE_ISSUE(trigger,
+                  BadTPFile,
+                  "Problem with TP file " << filename << ": " << reason,
+                  ((std::string)filename)((std::string)reason))
+ERS_DECLARE_ISSUE(trigger,
+                  BadTapFile,
+                  "Problem with tap file " << filename << ": " << reason,
+                  ((std::string)filename)((std::string)reason))
+ERS_DECLARE_ISSUE(trigger,
+                  BadSetOverlay,
+                  "Invalid Set overlay buffer: " << reason,
+                  ((std::string)reason))
 
 ERS_DECLARE_ISSUE_BASE(trigger,
                        SignalTypeError,
@@ -50,6 +62,13 @@ ERS_DECLARE_ISSUE_BASE(trigger,
                        ((std::string)name),
                        ((std::string)queueType))
 
+ERS_DECLARE_ISSUE_BASE(trigger,
+                       UnknownOutputQueue,
+                       appfwk::GeneralDAQModuleIssue,
+                       "The configuration names an output queue " << queue << " that the module was not given.",
+                       ((std::string)name),
+                       ((std::string)queue))
+
 ERS_DECLARE_ISSUE_BASE(trigger,
                        AlgorithmFatalError,
                        appfwk::GeneralDAQModuleIssue,
@@ -131,6 +150,13 @@ ERS_DECLARE_ISSUE_BASE(trigger,
                        ((std::string)name),
                        ((std::string)filename))
 
+ERS_DECLARE_ISSUE_BASE(trigger,
+                       NoTimeSyncSource,
+                       appfwk::GeneralDAQModuleIssue,
+                       "No time_sync_source queue was given, so the system clock will be used to estimate the timestamp.",
+                       ((std::string)name),
+                       ERS_EMPTY)
+
 ERS_DECLARE_ISSUE_BASE(trigger,
                        UnsortedTP,
                        appfwk::GeneralDAQModuleIssue,
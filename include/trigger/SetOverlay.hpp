@@ -0,0 +1,354 @@
+/**
+ * @file SetOverlay.hpp Flat binary layout for Sets of TriggerActivity and TriggerCandidate
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_SETOVERLAY_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_SETOVERLAY_HPP_
+
+#include "trigger/Issues.hpp"
+#include "trigger/Set.hpp"
+
+#include "detdataformats/trigger/TriggerActivity.hpp"
+#include "detdataformats/trigger/TriggerCandidate.hpp"
+#include "serialization/Serialization.hpp"
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerCandidate.hpp"
+#include "triggeralgs/TriggerObjectOverlay.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief The overlay struct from detdataformats that each object type in a
+ * Set is written as by triggeralgs' write_overlay
+ */
+template<class T>
+struct SetOverlayTraits;
+
+template<>
+struct SetOverlayTraits<triggeralgs::TriggerActivity>
+{
+  using overlay_t = detdataformats::trigger::TriggerActivity;
+};
+
+template<>
+struct SetOverlayTraits<triggeralgs::TriggerCandidate>
+{
+  using overlay_t = detdataformats::trigger::TriggerCandidate;
+};
+
+template<class T, class = void>
+struct has_set_overlay : std::false_type
+{};
+
+template<class T>
+struct has_set_overlay<T, std::void_t<typename SetOverlayTraits<T>::overlay_t>> : std::true_type
+{};
+
+template<class T>
+inline constexpr bool has_set_overlay_v = has_set_overlay<T>::value;
+
+/**
+ * @brief A Set<T> overlay is one contiguous buffer: a SetOverlayHeader,
+ * then the offset of each object from the start of the buffer, then the
+ * objects themselves, each written by triggeralgs' write_overlay with its
+ * inputs inline, and starting on an 8-byte boundary.
+ *
+ * A receiver can read the objects in place through a SetOverlayView,
+ * without building any vectors. Building a Set<T> from the buffer with
+ * read_set_overlay is a copy per object, with no per-field decoding.
+ */
+struct SetOverlayHeader
+{
+  static constexpr uint32_t s_magic = 0x31544553; // "SET1" // NOLINT(build/unsigned)
+  static constexpr uint32_t s_version = 1;        // NOLINT(build/unsigned)
+  static constexpr size_t s_alignment = 8;
+
+  uint32_t magic{ s_magic };        // NOLINT(build/unsigned)
+  uint32_t version{ s_version };    // NOLINT(build/unsigned)
+  uint64_t seqno{ 0 };              // NOLINT(build/unsigned)
+  uint16_t origin_system_type{ 0 }; // NOLINT(build/unsigned)
+  uint16_t origin_region_id{ 0 };   // NOLINT(build/unsigned)
+  uint32_t origin_element_id{ 0 };  // NOLINT(build/unsigned)
+  uint32_t type{ 0 };               // NOLINT(build/unsigned)
+  uint32_t reserved{ 0 };           // NOLINT(build/unsigned)
+  uint64_t start_time{ 0 };         // NOLINT(build/unsigned)
+  uint64_t end_time{ 0 };           // NOLINT(build/unsigned)
+  uint64_t n_objects{ 0 };          // NOLINT(build/unsigned)
+  uint64_t nbytes{ 0 };             // NOLINT(build/unsigned)
+};
+
+namespace set_overlay_detail {
+inline constexpr size_t
+aligned(size_t n)
+{
+  return (n + SetOverlayHeader::s_alignment - 1) / SetOverlayHeader::s_alignment * SetOverlayHeader::s_alignment;
+}
+} // namespace set_overlay_detail
+
+// The number of bytes that write_set_overlay will write for `set`
+template<class T, class = std::enable_if_t<has_set_overlay_v<T>>>
+size_t
+get_set_overlay_nbytes(const Set<T>& set)
+{
+  size_t nbytes = sizeof(SetOverlayHeader) + set_overlay_detail::aligned(set.objects.size() * sizeof(uint64_t));
+  for (const T& obj : set.objects) {
+    nbytes += set_overlay_detail::aligned(get_overlay_nbytes(obj));
+  }
+  return nbytes;
+}
+
+// Write `set` to `buffer`, which must be get_set_overlay_nbytes(set) long and 8-byte aligned
+template<class T, class = std::enable_if_t<has_set_overlay_v<T>>>
+void
+write_set_overlay(const Set<T>& set, void* buffer)
+{
+  const size_t nbytes = get_set_overlay_nbytes(set);
+  char* out = static_cast<char*>(buffer);
+
+  SetOverlayHeader header;
+  header.seqno = set.seqno;
+  header.origin_system_type = static_cast<uint16_t>(set.origin.system_type); // NOLINT(build/unsigned)
+  header.origin_region_id = set.origin.region_id;
+  header.origin_element_id = set.origin.element_id;
+  header.type = static_cast<uint32_t>(set.type); // NOLINT(build/unsigned)
+  header.start_time = set.start_time;
+  header.end_time = set.end_time;
+  header.n_objects = set.objects.size();
+  header.nbytes = nbytes;
+  std::memcpy(out, &header, sizeof(header));
+
+  uint64_t* offsets = reinterpret_cast<uint64_t*>(out + sizeof(header)); // NOLINT
+  size_t offset = sizeof(header) + set_overlay_detail::aligned(set.objects.size() * sizeof(uint64_t));
+  for (size_t i = 0; i < set.objects.size(); ++i) {
+    const size_t object_nbytes = get_overlay_nbytes(set.objects[i]);
+    offsets[i] = offset;
+    write_overlay(set.objects[i], out + offset);
+    // Zero the padding, so that the same Set always gives the same bytes
+    std::memset(out + offset + object_nbytes, 0, set_overlay_detail::aligned(object_nbytes) - object_nbytes);
+    offset += set_overlay_detail::aligned(object_nbytes);
+  }
+}
+
+/**
+ * @brief Read-only access to a Set<T> overlay in place. The buffer must
+ * outlive the view. Throws BadSetOverlay if the buffer isn't a consistent
+ * overlay, or isn't 8-byte aligned
+ */
+template<class T>
+class SetOverlayView
+{
+public:
+  static_assert(has_set_overlay_v<T>, "SetOverlayView is only defined for TriggerActivity and TriggerCandidate");
+  using overlay_t = typename SetOverlayTraits<T>::overlay_t;
+
+  SetOverlayView(const void* buffer, size_t size)
+    : m_buffer(static_cast<const char*>(buffer))
+  {
+    if (reinterpret_cast<uintptr_t>(buffer) % SetOverlayHeader::s_alignment != 0) { // NOLINT
+      throw BadSetOverlay(ERS_HERE, "buffer is not 8-byte aligned");
+    }
+    if (size < sizeof(SetOverlayHeader)) {
+      throw BadSetOverlay(ERS_HERE, "buffer of " + std::to_string(size) + " bytes is too short for the header");
+    }
+    const SetOverlayHeader& h = header();
+    if (h.magic != SetOverlayHeader::s_magic) {
+      throw BadSetOverlay(ERS_HERE, "bad magic number");
+    }
+    if (h.version != SetOverlayHeader::s_version) {
+      throw BadSetOverlay(ERS_HERE, "unsupported version " + std::to_string(h.version));
+    }
+    if (h.nbytes != size || h.n_objects > (size - sizeof(SetOverlayHeader)) / sizeof(uint64_t)) {
+      throw BadSetOverlay(ERS_HERE, "size in header doesn't match buffer of " + std::to_string(size) + " bytes");
+    }
+    // Objects must lie between the offsets table and the end of the buffer. The
+    // offsets are compared without adding to them, so garbage can't overflow
+    const size_t objects_begin =
+      sizeof(SetOverlayHeader) + set_overlay_detail::aligned(h.n_objects * sizeof(uint64_t));
+    for (size_t i = 0; i < h.n_objects; ++i) {
+      uint64_t offset = offsets()[i]; // NOLINT(build/unsigned)
+      if (offset % SetOverlayHeader::s_alignment != 0 || offset < objects_begin || size < sizeof(overlay_t) ||
+          offset > size - sizeof(overlay_t) ||
+          (*this)[i].n_inputs > (size - offset - sizeof(overlay_t)) / sizeof((*this)[i].inputs[0])) {
+        throw BadSetOverlay(ERS_HERE, "object " + std::to_string(i) + " is outside the buffer");
+      }
+    }
+  }
+
+  const SetOverlayHeader& header() const { return *reinterpret_cast<const SetOverlayHeader*>(m_buffer); } // NOLINT
+
+  typename Set<T>::seqno_t seqno() const { return header().seqno; }
+  typename Set<T>::origin_t origin() const
+  {
+    return typename Set<T>::origin_t(static_cast<daqdataformats::GeoID::SystemType>(header().origin_system_type),
+                                     header().origin_region_id,
+                                     header().origin_element_id);
+  }
+  typename Set<T>::Type type() const { return static_cast<typename Set<T>::Type>(header().type); }
+  daqdataformats::timestamp_t start_time() const { return header().start_time; }
+  daqdataformats::timestamp_t end_time() const { return header().end_time; }
+
+  size_t size() const { return header().n_objects; }
+  bool empty() const { return size() == 0; }
+
+  const overlay_t& operator[](size_t i) const
+  {
+    return *reinterpret_cast<const overlay_t*>(m_buffer + offsets()[i]); // NOLINT
+  }
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = overlay_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const overlay_t*;
+    using reference = const overlay_t&;
+
+    const_iterator(const SetOverlayView* view, size_t index)
+      : m_view(view)
+      , m_index(index)
+    {}
+
+    reference operator*() const { return (*m_view)[m_index]; }
+    pointer operator->() const { return &(*m_view)[m_index]; }
+    const_iterator& operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator ret(*this);
+      ++m_index;
+      return ret;
+    }
+    const_iterator& operator+=(difference_type n)
+    {
+      m_index += n;
+      return *this;
+    }
+    const_iterator operator+(difference_type n) const { return const_iterator(m_view, m_index + n); }
+    difference_type operator-(const const_iterator& other) const
+    {
+      return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+    }
+    bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+    bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+  private:
+    const SetOverlayView* m_view;
+    size_t m_index;
+  };
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  // Build the Set<T>, copying each object out of the buffer
+  Set<T> read() const
+  {
+    Set<T> set;
+    set.seqno = seqno();
+    set.origin = origin();
+    set.type = type();
+    set.start_time = start_time();
+    set.end_time = end_time();
+    set.objects.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+      set.objects.push_back(triggeralgs::read_overlay_from_buffer<T>(m_buffer + offsets()[i]));
+    }
+    return set;
+  }
+
+private:
+  const uint64_t* offsets() const // NOLINT(build/unsigned)
+  {
+    return reinterpret_cast<const uint64_t*>(m_buffer + sizeof(SetOverlayHeader)); // NOLINT
+  }
+
+  const char* m_buffer;
+};
+
+/**
+ * @brief Build a Set<T> from an overlay in `buffer`. Unlike SetOverlayView,
+ * `buffer` needn't be aligned: it is copied to an aligned one if it isn't,
+ * as can happen when it's inside a received message
+ */
+template<class T>
+Set<T>
+read_set_overlay(const void* buffer, size_t size)
+{
+  if (reinterpret_cast<uintptr_t>(buffer) % SetOverlayHeader::s_alignment == 0) { // NOLINT
+    return SetOverlayView<T>(buffer, size).read();
+  }
+  std::vector<uint64_t> aligned((size + sizeof(uint64_t) - 1) / sizeof(uint64_t)); // NOLINT(build/unsigned)
+  std::memcpy(aligned.data(), buffer, size);
+  return SetOverlayView<T>(aligned.data(), size).read();
+}
+
+} // namespace dunedaq::trigger
+
+// Sets of TAs and TCs are packed for msgpack (and so for the network queue
+// adapters) as a single bin holding their overlay, instead of as nested
+// arrays of objects and their inputs, which are slow to pack and unpack
+namespace msgpack {
+MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
+{
+  namespace adaptor {
+
+  template<class T>
+  struct pack<dunedaq::trigger::Set<T>, std::enable_if_t<dunedaq::trigger::has_set_overlay_v<T>>>
+  {
+    template<typename Stream>
+    packer<Stream>& operator()(msgpack::packer<Stream>& o, const dunedaq::trigger::Set<T>& set) const
+    {
+      const size_t nbytes = dunedaq::trigger::get_set_overlay_nbytes(set);
+      std::vector<uint64_t> buffer((nbytes + sizeof(uint64_t) - 1) / sizeof(uint64_t)); // NOLINT(build/unsigned)
+      dunedaq::trigger::write_set_overlay(set, buffer.data());
+      o.pack_bin(nbytes);
+      o.pack_bin_body(reinterpret_cast<const char*>(buffer.data()), nbytes); // NOLINT
+      return o;
+    }
+  };
+
+  template<class T>
+  struct convert<dunedaq::trigger::Set<T>, std::enable_if_t<dunedaq::trigger::has_set_overlay_v<T>>>
+  {
+    msgpack::object const& operator()(msgpack::object const& o, dunedaq::trigger::Set<T>& set) const
+    {
+      if (o.type == msgpack::type::ARRAY && o.via.array.size == 6) {
+        // The per-field encoding that sets had before the overlay, as in
+        // version 1 tap files and from senders built before it
+        const msgpack::object* fields = o.via.array.ptr;
+        set.seqno = fields[0].as<typename dunedaq::trigger::Set<T>::seqno_t>();
+        set.origin = fields[1].as<typename dunedaq::trigger::Set<T>::origin_t>();
+        set.type = fields[2].as<typename dunedaq::trigger::Set<T>::Type>();
+        set.start_time = fields[3].as<dunedaq::daqdataformats::timestamp_t>();
+        set.end_time = fields[4].as<dunedaq::daqdataformats::timestamp_t>();
+        set.objects = fields[5].as<std::vector<T>>();
+        return o;
+      }
+      if (o.type != msgpack::type::BIN) {
+        throw msgpack::type_error();
+      }
+      set = dunedaq::trigger::read_set_overlay<T>(o.via.bin.ptr, o.via.bin.size);
+      return o;
+    }
+  };
+
+  } // namespace adaptor
+} // MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
+} // namespace msgpack
+
+#endif // TRIGGER_INCLUDE_TRIGGER_SETOVERLAY_HPP_
@@ -12,6 +12,7 @@
 #include "dfmessages/GeoID_serialization.hpp"
 #include "serialization/Serialization.hpp"
 #include "trigger/Set.hpp"
+#include "trigger/SetOverlay.hpp"
 #include "trigger/TriggerCandidate_serialization.hpp"
 #include "triggeralgs/TriggerCandidate.hpp"
 
@@ -22,6 +23,10 @@ using TCSet = Set<triggeralgs::TriggerCandidate>;
 } // namespace dunedaq::trigger
 
 MSGPACK_ADD_ENUM(dunedaq::trigger::TCSet::Type)
-DUNE_DAQ_SERIALIZE_NON_INTRUSIVE(dunedaq::trigger, TCSet, seqno, origin, type, start_time, end_time, objects)
+
+// The msgpack packing is the overlay from SetOverlay.hpp, so only JSON is declared here
+namespace dunedaq::trigger {
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(TCSet, seqno, origin, type, start_time, end_time, objects)
+} // namespace dunedaq::trigger
 
 #endif // TRIGGER_INCLUDE_TRIGGER_TCSET_HPP_
@@ -0,0 +1,197 @@
+/**
+ * @file TPSliceColumns.hpp
+ *
+ * Structure-of-arrays view of a time slice of TriggerPrimitives
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_TPSLICECOLUMNS_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_TPSLICECOLUMNS_HPP_
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief Minimal allocator that returns storage aligned to ALIGN bytes
+ */
+template<class T, std::size_t ALIGN>
+struct AlignedAllocator
+{
+  using value_type = T;
+
+  template<class U>
+  struct rebind
+  {
+    using other = AlignedAllocator<U, ALIGN>;
+  };
+
+  AlignedAllocator() = default;
+  template<class U>
+  AlignedAllocator(const AlignedAllocator<U, ALIGN>& /*other*/) // NOLINT(runtime/explicit)
+  {}
+
+  T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGN))); }
+  void deallocate(T* p, std::size_t /*n*/) { ::operator delete(p, std::align_val_t(ALIGN)); }
+
+  template<class U>
+  bool operator==(const AlignedAllocator<U, ALIGN>& /*other*/) const
+  {
+    return true;
+  }
+  template<class U>
+  bool operator!=(const AlignedAllocator<U, ALIGN>& /*other*/) const
+  {
+    return false;
+  }
+};
+
+/**
+ * @brief The fields of a time slice of TriggerPrimitives, one array per
+ * field, each starting on a cache line.
+ *
+ * Algorithms that only read a few fields of each TriggerPrimitive (eg
+ * time_start and channel) can scan the corresponding columns and touch a
+ * fraction of the memory they would by reading the full objects.
+ *
+ * Only the selected fields are filled, so that a consumer that reads two
+ * columns doesn't pay for writing seven. The columns of the other fields are
+ * left empty, and their accessors must not be read.
+ *
+ * The columns keep their storage when the object is refilled, so a
+ * TPSliceColumns that is reused for every slice stops allocating once it has
+ * seen the largest slice.
+ */
+class TPSliceColumns
+{
+public:
+  using TriggerPrimitive = triggeralgs::TriggerPrimitive;
+
+  static constexpr std::size_t s_alignment = 64;
+
+  template<class T>
+  using column_t = std::vector<T, AlignedAllocator<T, s_alignment>>;
+
+  using time_t = decltype(TriggerPrimitive::time_start);
+  using channel_t = decltype(TriggerPrimitive::channel);
+  using adc_integral_t = decltype(TriggerPrimitive::adc_integral);
+  using adc_peak_t = decltype(TriggerPrimitive::adc_peak);
+  using detid_t = decltype(TriggerPrimitive::detid);
+
+  // Bit mask of the fields to fill
+  using fields_t = uint32_t; // NOLINT(build/unsigned)
+  enum Field : fields_t
+  {
+    kTimeStart = 1 << 0,
+    kTimePeak = 1 << 1,
+    kTimeOverThreshold = 1 << 2,
+    kChannel = 1 << 3,
+    kAdcIntegral = 1 << 4,
+    kAdcPeak = 1 << 5,
+    kDetId = 1 << 6
+  };
+  static constexpr fields_t s_all_fields = (1 << 7) - 1;
+
+  TPSliceColumns() = default;
+  explicit TPSliceColumns(fields_t fields)
+    : m_fields(fields)
+  {}
+
+  // Choose the fields to fill. This empties the columns
+  void set_fields(fields_t fields)
+  {
+    m_fields = fields;
+    resize(0);
+  }
+
+  fields_t get_fields() const { return m_fields; }
+
+  /**
+   * Replace the contents with the fields of the TriggerPrimitives in [first, last)
+   */
+  void assign(const TriggerPrimitive* first, const TriggerPrimitive* last)
+  {
+    const std::size_t n = last - first;
+    resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      set(i, first[i]);
+    }
+  }
+
+  // Make the columns `n` long, for the caller to fill with set(). The
+  // storage is kept when `n` shrinks
+  void resize(std::size_t n)
+  {
+    m_size = n;
+    m_time_start.resize(m_fields & kTimeStart ? n : 0);
+    m_time_peak.resize(m_fields & kTimePeak ? n : 0);
+    m_time_over_threshold.resize(m_fields & kTimeOverThreshold ? n : 0);
+    m_channel.resize(m_fields & kChannel ? n : 0);
+    m_adc_integral.resize(m_fields & kAdcIntegral ? n : 0);
+    m_adc_peak.resize(m_fields & kAdcPeak ? n : 0);
+    m_detid.resize(m_fields & kDetId ? n : 0);
+  }
+
+  // Fill row `i` with the selected fields of `tp`
+  void set(std::size_t i, const TriggerPrimitive& tp)
+  {
+    if (m_fields & kTimeStart) {
+      m_time_start[i] = tp.time_start;
+    }
+    if (m_fields & kTimePeak) {
+      m_time_peak[i] = tp.time_peak;
+    }
+    if (m_fields & kTimeOverThreshold) {
+      m_time_over_threshold[i] = tp.time_over_threshold;
+    }
+    if (m_fields & kChannel) {
+      m_channel[i] = tp.channel;
+    }
+    if (m_fields & kAdcIntegral) {
+      m_adc_integral[i] = tp.adc_integral;
+    }
+    if (m_fields & kAdcPeak) {
+      m_adc_peak[i] = tp.adc_peak;
+    }
+    if (m_fields & kDetId) {
+      m_detid[i] = tp.detid;
+    }
+  }
+
+  // Empty the columns, keeping their storage for the next slice
+  void clear() { resize(0); }
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  const time_t* time_start() const { return m_time_start.data(); }
+  const time_t* time_peak() const { return m_time_peak.data(); }
+  const time_t* time_over_threshold() const { return m_time_over_threshold.data(); }
+  const channel_t* channel() const { return m_channel.data(); }
+  const adc_integral_t* adc_integral() const { return m_adc_integral.data(); }
+  const adc_peak_t* adc_peak() const { return m_adc_peak.data(); }
+  const detid_t* detid() const { return m_detid.data(); }
+
+private:
+  fields_t m_fields{ s_all_fields };
+  std::size_t m_size{ 0 };
+  column_t<time_t> m_time_start;
+  column_t<time_t> m_time_peak;
+  column_t<time_t> m_time_over_threshold;
+  column_t<channel_t> m_channel;
+  column_t<adc_integral_t> m_adc_integral;
+  column_t<adc_peak_t> m_adc_peak;
+  column_t<detid_t> m_detid;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_TPSLICECOLUMNS_HPP_
@@ -8,6 +8,12 @@
 
 #include "FakeTPCreatorHeartbeatMaker.hpp"
 
+#include "trigger/InterruptibleSource.hpp"
+
+#include "timinglibs/TimestampEstimatorSystem.hpp"
+
+#include <algorithm>
+#include <limits>
 #include <string>
 
 namespace dunedaq {
@@ -32,6 +38,11 @@ FakeTPCreatorHeartbeatMaker::init(const nlohmann::json& iniobj)
   try {
     m_input_queue.reset(new source_t(appfwk::queue_inst(iniobj, "tpset_source")));
     m_output_queue.reset(new sink_t(appfwk::queue_inst(iniobj, "tpset_sink")));
+    // Only needed for timer heartbeats with the kTimeSync timestamp method
+    auto queues = appfwk::queue_index(iniobj);
+    if (queues.count("time_sync_source")) {
+      m_time_sync_source.reset(new appfwk::DAQSource<dfmessages::TimeSync>(queues["time_sync_source"].inst));
+    }
   } catch (const ers::Issue& excpt) {
     throw dunedaq::trigger::InvalidQueueFatalError(ERS_HERE, get_name(), "input/output", excpt);
   }
@@ -45,6 +56,9 @@ FakeTPCreatorHeartbeatMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/
   i.tpset_received_count = m_tpset_received_count.load();
   i.tpset_sent_count = m_tpset_sent_count.load();
   i.heartbeats_sent = m_heartbeats_sent.load();
+  i.timer_heartbeats_sent = m_timer_heartbeats_sent.load();
+  i.heartbeats_dropped = m_heartbeats_dropped.load();
+  i.late_tpset_count = m_late_tpset_count.load();
 
   ci.add(i);
 }
@@ -52,13 +66,34 @@ FakeTPCreatorHeartbeatMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/
 void
 FakeTPCreatorHeartbeatMaker::do_conf(const nlohmann::json& conf)
 {
-  m_heartbeat_interval = conf.get<dunedaq::trigger::faketpcreatorheartbeatmaker::Conf>().heartbeat_interval;
+  m_conf = conf.get<dunedaq::trigger::faketpcreatorheartbeatmaker::Conf>();
+  m_heartbeat_interval = m_conf.heartbeat_interval;
+  // Timer heartbeats are due when no heartbeat has been sent for one
+  // heartbeat interval of wall-clock time
+  uint64_t interval_ms = // NOLINT(build/unsigned)
+    m_conf.clock_frequency_hz ? m_heartbeat_interval * 1000 / m_conf.clock_frequency_hz : 0;
+  m_timer_interval = std::chrono::milliseconds(std::max<uint64_t>(interval_ms, 1)); // NOLINT(build/unsigned)
   TLOG_DEBUG(2) << get_name() + " configured.";
 }
 
 void
 FakeTPCreatorHeartbeatMaker::do_start(const nlohmann::json&)
 {
+  if (m_conf.timer_heartbeats) {
+    if (m_conf.timestamp_method == faketpcreatorheartbeatmaker::timestamp_estimation::kTimeSync &&
+        !m_time_sync_source) {
+      ers::warning(NoTimeSyncSource(ERS_HERE, get_name()));
+    }
+    if (m_conf.timestamp_method == faketpcreatorheartbeatmaker::timestamp_estimation::kTimeSync && m_time_sync_source) {
+      TLOG_DEBUG(0) << "Creating TimestampEstimator";
+      m_timestamp_estimator.reset(new timinglibs::TimestampEstimator(m_time_sync_source, m_conf.clock_frequency_hz));
+    } else {
+      TLOG_DEBUG(0) << "Creating TimestampEstimatorSystem";
+      m_timestamp_estimator.reset(new timinglibs::TimestampEstimatorSystem(m_conf.clock_frequency_hz));
+    }
+  }
+
+  m_stop_signal.reset();
   m_thread.start_working_thread("heartbeater");
   TLOG_DEBUG(2) << get_name() + " successfully started.";
 }
@@ -66,7 +101,9 @@ FakeTPCreatorHeartbeatMaker::do_start(const nlohmann::json&)
 void
 FakeTPCreatorHeartbeatMaker::do_stop(const nlohmann::json&)
 {
+  m_stop_signal.request_stop();
   m_thread.stop_working_thread();
+  m_timestamp_estimator.reset(nullptr); // Calls TimestampEstimator dtor
   TLOG_DEBUG(2) << get_name() + " successfully stopped.";
 }
 
@@ -75,60 +112,77 @@ FakeTPCreatorHeartbeatMaker::do_scrap(const nlohmann::json&)
 {}
 
 void
-FakeTPCreatorHeartbeatMaker::do_work(std::atomic<bool>& running_flag)
+FakeTPCreatorHeartbeatMaker::do_work(std::atomic<bool>& /*running_flag*/)
 {
+  using Status = InterruptibleSource<TPSet>::Status;
+
   // OpMon.
   m_tpset_received_count.store(0);
   m_tpset_sent_count.store(0);
   m_heartbeats_sent.store(0);
+  m_timer_heartbeats_sent.store(0);
+  m_heartbeats_dropped.store(0);
+  m_late_tpset_count.store(0);
 
   bool is_first_tpset_received = true;
 
-  daqdataformats::timestamp_t last_sent_heartbeat_time;
+  daqdataformats::timestamp_t last_sent_heartbeat_time = 0;
+  auto last_heartbeat_wall_time = std::chrono::steady_clock::now();
 
+  InterruptibleSource<TPSet> input(*m_input_queue, m_stop_signal);
+
+  // The condition to exit the loop is that we've been stopped and
+  // there's nothing left on the input queue
+  TPSet tpset;
   while (true) {
-    TPSet tpset;
-    try {
-      m_input_queue->pop(tpset, m_queue_timeout);
-      m_tpset_received_count++;
-    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-      // The condition to exit the loop is that we've been stopped and
-      // there's nothing left on the input queue
-      if (!running_flag.load()) {
-        break;
-      } else {
-        continue;
+    Status status;
+    if (m_conf.timer_heartbeats) {
+      // Wait no longer than until the next timer heartbeat is due
+      auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        last_heartbeat_wall_time + m_timer_interval - std::chrono::steady_clock::now());
+      status = input.pop(tpset, std::max(wait, std::chrono::milliseconds(0)));
+    } else {
+      status = input.pop(tpset) ? Status::kData : Status::kStopped;
+    }
+
+    if (status == Status::kStopped) {
+      break;
+    }
+
+    if (status == Status::kTimeout) {
+      // No heartbeat for a whole interval, so the link is quiet. Heartbeat
+      // from the timestamp estimate instead of from the data
+      daqdataformats::timestamp_t heartbeat_time = get_timer_heartbeat_time();
+      if (heartbeat_time > last_sent_heartbeat_time && send_heartbeat(heartbeat_time)) {
+        m_timer_heartbeats_sent++;
+        last_sent_heartbeat_time = heartbeat_time;
+        is_first_tpset_received = false;
       }
+      last_heartbeat_wall_time = std::chrono::steady_clock::now();
+      continue;
     }
 
+    m_tpset_received_count++;
+
     TLOG_DEBUG(2) << "Activity received.";
 
     daqdataformats::timestamp_t current_tpset_start_time = tpset.start_time;
 
-    bool send_heartbeat =
-      should_send_heartbeat(last_sent_heartbeat_time, current_tpset_start_time, is_first_tpset_received);
+    if (!is_first_tpset_received && current_tpset_start_time < last_sent_heartbeat_time) {
+      // A timer heartbeat got ahead of the data. max_data_delay is too small
+      m_late_tpset_count++;
+      TLOG_DEBUG(1) << "TPSet with start time " << current_tpset_start_time << " is behind the last heartbeat, at "
+                    << last_sent_heartbeat_time;
+    }
+
+    if (should_send_heartbeat(last_sent_heartbeat_time, current_tpset_start_time, is_first_tpset_received) &&
+        send_heartbeat(current_tpset_start_time)) {
+      last_sent_heartbeat_time = current_tpset_start_time;
+      last_heartbeat_wall_time = std::chrono::steady_clock::now();
+      is_first_tpset_received = false;
+    }
 
     bool successfully_sent_real_tpset = false;
-    bool successfully_sent_heartbeat = false;
-
-    if (send_heartbeat) {
-      TPSet tpset_heartbeat;
-      get_heartbeat(tpset_heartbeat, current_tpset_start_time);
-      while (!successfully_sent_heartbeat) {
-        try {
-          m_output_queue->push(tpset_heartbeat, m_queue_timeout);
-          successfully_sent_heartbeat = true;
-          m_heartbeats_sent++;
-          last_sent_heartbeat_time = current_tpset_start_time;
-          is_first_tpset_received = false;
-        } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-          std::ostringstream oss_warn;
-          oss_warn << "push to output queue \"" << m_output_queue->get_name() << "\"";
-          ers::warning(
-            dunedaq::appfwk::QueueTimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
-        }
-      }
-    }
     while (!successfully_sent_real_tpset) {
       try {
         m_output_queue->push(tpset, m_queue_timeout);
@@ -144,10 +198,46 @@ FakeTPCreatorHeartbeatMaker::do_work(std::atomic<bool>& running_flag)
   }
 
   TLOG() << "Received " << m_tpset_received_count << " and sent " << m_tpset_sent_count << " real TPSets. Sent "
-         << m_heartbeats_sent << " fake heartbeats." << std::endl;
+         << m_heartbeats_sent << " fake heartbeats, " << m_timer_heartbeats_sent << " of them from the timer."
+         << std::endl;
   TLOG_DEBUG(2) << "Exiting do_work() method";
 }
 
+bool
+FakeTPCreatorHeartbeatMaker::send_heartbeat(daqdataformats::timestamp_t const& heartbeat_time)
+{
+  TPSet tpset_heartbeat;
+  get_heartbeat(tpset_heartbeat, heartbeat_time);
+  try {
+    m_output_queue->push(tpset_heartbeat, m_queue_timeout);
+  } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+    std::ostringstream oss_warn;
+    oss_warn << "push heartbeat to output queue \"" << m_output_queue->get_name() << "\"";
+    ers::warning(dunedaq::appfwk::QueueTimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
+    m_heartbeats_dropped++;
+    return false;
+  }
+  m_heartbeats_sent++;
+  return true;
+}
+
+daqdataformats::timestamp_t
+FakeTPCreatorHeartbeatMaker::get_timer_heartbeat_time() const
+{
+  if (!m_timestamp_estimator) {
+    return 0;
+  }
+  // Treat the estimators' invalid-timestamp marker, and anything too early to
+  // subtract the delay from, as no estimate
+  dfmessages::timestamp_t estimate = m_timestamp_estimator->get_timestamp_estimate();
+  if (estimate == std::numeric_limits<dfmessages::timestamp_t>::max() || estimate <= m_conf.max_data_delay) {
+    return 0;
+  }
+  // TPSets may still arrive for times up to max_data_delay before the
+  // estimate, so that is as far as a heartbeat can vouch for
+  return estimate - m_conf.max_data_delay;
+}
+
 bool
 FakeTPCreatorHeartbeatMaker::should_send_heartbeat(daqdataformats::timestamp_t const& last_sent_heartbeat_time,
                                                    daqdataformats::timestamp_t const& current_tpset_start_time,
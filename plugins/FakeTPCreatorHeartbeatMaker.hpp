@@ -13,9 +13,12 @@
 #include "appfwk/DAQModuleHelper.hpp"
 #include "appfwk/DAQSink.hpp"
 #include "appfwk/DAQSource.hpp"
+#include "dfmessages/TimeSync.hpp"
+#include "timinglibs/TimestampEstimator.hpp"
 #include "utilities/WorkerThread.hpp"
 
 #include "trigger/Issues.hpp"
+#include "trigger/StopSignal.hpp"
 #include "trigger/TPSet.hpp"
 
 #include "trigger/faketpcreatorheartbeatmaker/Nljs.hpp"
@@ -54,7 +57,15 @@ private:
                              bool const& is_first_tpset_received);
   void get_heartbeat(TPSet& tpset_heartbeat, daqdataformats::timestamp_t const& current_tpset_start_time);
 
+  // Try once to push a heartbeat. A heartbeat that can't be pushed is
+  // dropped rather than retried, since the next one supersedes it anyway
+  bool send_heartbeat(daqdataformats::timestamp_t const& heartbeat_time);
+
+  // The time for a timer heartbeat, or zero if there is no valid timestamp estimate yet
+  daqdataformats::timestamp_t get_timer_heartbeat_time() const;
+
   dunedaq::utilities::WorkerThread m_thread;
+  StopSignal m_stop_signal;
 
   using source_t = dunedaq::appfwk::DAQSource<TPSet>;
   std::unique_ptr<source_t> m_input_queue;
@@ -65,11 +76,20 @@ private:
 
   triggeralgs::timestamp_t m_heartbeat_interval;
 
+  // For heartbeats when no TPSets arrive
+  faketpcreatorheartbeatmaker::Conf m_conf;
+  std::chrono::milliseconds m_timer_interval;
+  std::unique_ptr<appfwk::DAQSource<dfmessages::TimeSync>> m_time_sync_source;
+  std::unique_ptr<timinglibs::TimestampEstimatorBase> m_timestamp_estimator;
+
   // Opmon variables
   using metric_counter_type = decltype(faketpcreatorheartbeatmakerinfo::Info::tpset_received_count);
   std::atomic<metric_counter_type> m_tpset_received_count{ 0 };
   std::atomic<metric_counter_type> m_tpset_sent_count{ 0 };
   std::atomic<metric_counter_type> m_heartbeats_sent{ 0 };
+  std::atomic<metric_counter_type> m_timer_heartbeats_sent{ 0 };
+  std::atomic<metric_counter_type> m_heartbeats_dropped{ 0 };
+  std::atomic<metric_counter_type> m_late_tpset_count{ 0 };
 };
 } // namespace trigger
 } // namespace dunedaq
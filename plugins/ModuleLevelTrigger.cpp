@@ -17,6 +17,7 @@
 #include "dfmessages/Types.hpp"
 #include "logging/Logging.hpp"
 
+#include "trigger/InterruptibleSource.hpp"
 #include "trigger/Issues.hpp"
 #include "trigger/moduleleveltrigger/Nljs.hpp"
 
@@ -28,6 +29,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
 #include <pthread.h>
 #include <random>
 #include <string>
@@ -69,8 +71,21 @@ ModuleLevelTrigger::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   i.td_inhibited_count = m_td_inhibited_count.load();
   i.td_paused_count = m_td_paused_count.load();
   i.td_total_count = m_td_total_count.load();
+  i.td_merged_count = m_td_merged_count.load();
+  i.td_trimmed_count = m_td_trimmed_count.load();
 
   ci.add(i);
+
+  for (auto const& [type, counters] : m_scheduler.get_counters()) {
+    moduleleveltriggerinfo::TCTypeInfo type_info;
+    type_info.accepted_count = counters.accepted;
+    type_info.dropped_count = counters.dropped;
+    type_info.merged_count = counters.merged;
+
+    opmonlib::InfoCollector type_ci;
+    type_ci.add(type_info);
+    ci.add("tc_type_" + std::to_string(static_cast<std::underlying_type_t<decltype(type)>>(type)), type_ci);
+  }
 }
 
 void
@@ -86,6 +101,18 @@ ModuleLevelTrigger::do_configure(const nlohmann::json& confobj)
   m_trigger_decision_connection = params.dfo_connection;
   m_inhibit_connection = params.dfo_busy_connection;
 
+  std::map<TCScheduler::tc_type_t, TCScheduler::TypeConfig> type_configs;
+  for (auto const& type_conf : params.tc_types) {
+    TCScheduler::TypeConfig config;
+    config.priority = type_conf.priority;
+    config.rate_limit_hz = type_conf.rate_limit_hz;
+    config.burst = type_conf.burst;
+    config.prescale = type_conf.prescale;
+    type_configs[static_cast<TCScheduler::tc_type_t>(type_conf.tc_type)] = config;
+  }
+  m_scheduler.configure(type_configs, params.max_pending_tcs, std::chrono::milliseconds(params.pending_timeout_ms));
+  m_decision_windows.configure(params.merge_history_ticks);
+
   networkmanager::NetworkManager::get().start_listening(m_inhibit_connection);
   m_configured_flag.store(true);
 }
@@ -97,6 +124,7 @@ ModuleLevelTrigger::do_start(const nlohmann::json& startobj)
 
   m_paused.store(true);
   m_running_flag.store(true);
+  m_stop_signal.reset();
   m_dfo_is_busy.store(false);
 
   networkmanager::NetworkManager::get().register_callback(
@@ -111,6 +139,7 @@ void
 ModuleLevelTrigger::do_stop(const nlohmann::json& /*stopobj*/)
 {
   m_running_flag.store(false);
+  m_stop_signal.request_stop();
   m_send_trigger_decisions_thread.join();
 
   networkmanager::NetworkManager::get().clear_callback(m_inhibit_connection);
@@ -164,12 +193,58 @@ ModuleLevelTrigger::create_decision(const triggeralgs::TriggerCandidate& tc)
   return decision;
 }
 
+void
+ModuleLevelTrigger::send_pending_decisions(const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed)
+{
+  triggeralgs::TriggerCandidate tc;
+  while (!m_dfo_is_busy.load() && m_scheduler.next(tc, TCScheduler::clock_t::now(), on_shed)) {
+
+    dfmessages::TriggerDecision decision = create_decision(tc);
+
+    auto merge_result = m_decision_windows.apply(decision.components);
+    if (merge_result == DecisionWindowIndex::Result::kMerged) {
+      // Everything this candidate would read out is already covered by an
+      // earlier decision, so there's nothing to send
+      TLOG_DEBUG(1) << "Candidate with timestamp " << tc.time_candidate
+                    << " is covered by earlier decisions. Not sending a TriggerDecision";
+      ++m_td_merged_count;
+      m_scheduler.merged(tc.type);
+      continue;
+    } else if (merge_result == DecisionWindowIndex::Result::kTrimmed) {
+      ++m_td_trimmed_count;
+    }
+
+    TLOG_DEBUG(1) << "Sending a decision with triggernumber " << decision.trigger_number << " timestamp "
+                  << decision.trigger_timestamp << " number of links " << decision.components.size()
+                  << " based on TC of type " << static_cast<std::underlying_type_t<decltype(tc.type)>>(tc.type);
+
+    try {
+      auto serialised_decision = serialization::serialize(decision, serialization::kMsgPack);
+      networkmanager::NetworkManager::get().send_to(m_trigger_decision_connection,
+                                                    static_cast<const void*>(serialised_decision.data()),
+                                                    serialised_decision.size(),
+                                                    std::chrono::milliseconds(1));
+      m_td_sent_count++;
+      m_last_trigger_number++;
+      m_scheduler.accepted(tc.type);
+      m_decision_windows.record(decision.components);
+    } catch (const ers::Issue& e) {
+      ers::error(e);
+      TLOG_DEBUG(1) << "The network is misbehaving: it accepted TD but the send failed for " << tc.time_candidate;
+      m_td_queue_timeout_expired_err_count++;
+      m_scheduler.dropped(tc.type);
+    }
+  }
+}
+
 void
 ModuleLevelTrigger::send_trigger_decisions()
 {
 
   // We get here at start of run, so reset the trigger number
   m_last_trigger_number = 0;
+  m_scheduler.reset();
+  m_decision_windows.reset();
 
   // OpMon.
   m_tc_received_count.store(0);
@@ -177,61 +252,65 @@ ModuleLevelTrigger::send_trigger_decisions()
   m_td_inhibited_count.store(0);
   m_td_paused_count.store(0);
   m_td_total_count.store(0);
+  m_td_merged_count.store(0);
+  m_td_trimmed_count.store(0);
+
+  auto inhibit = [this](const triggeralgs::TriggerCandidate& shed_tc) {
+    ers::warning(TriggerInhibited(ERS_HERE, m_run_number));
+    TLOG_DEBUG(1) << "The DFO is busy. Not sending a TriggerDecision for candidate timestamp "
+                  << shed_tc.time_candidate;
+    m_td_inhibited_count++;
+  };
+
+  // Wake up at least this often to send candidates that were held while the DFO was busy
+  const std::chrono::milliseconds pending_interval(100);
+  using tc_source_t = InterruptibleSource<triggeralgs::TriggerCandidate>;
+  tc_source_t input(*m_candidate_source, m_stop_signal);
 
   while (true) {
     triggeralgs::TriggerCandidate tc;
-    try {
-      m_candidate_source->pop(tc, std::chrono::milliseconds(100));
-      ++m_tc_received_count;
-    } catch (appfwk::QueueTimeoutExpired&) {
-      // The condition to exit the loop is that we've been stopped and
-      // there's nothing left on the input queue
-      if (!m_running_flag.load()) {
-        break;
-      } else {
-        continue;
-      }
+    auto status = input.pop(tc, pending_interval);
+    // The condition to exit the loop is that we've been stopped and
+    // there's nothing left on the input queue
+    if (status == tc_source_t::Status::kStopped) {
+      break;
     }
 
-    if (!m_paused.load() && !m_dfo_is_busy.load() ) {
-
-      dfmessages::TriggerDecision decision = create_decision(tc);
-
-      TLOG_DEBUG(1) << "Sending a decision with triggernumber " << decision.trigger_number << " timestamp "
-                    << decision.trigger_timestamp << " number of links " << decision.components.size()
-                    << " based on TC of type " << static_cast<std::underlying_type_t<decltype(tc.type)>>(tc.type);
-
-      try {
-        auto serialised_decision = serialization::serialize(decision, serialization::kMsgPack);
-        networkmanager::NetworkManager::get().send_to(m_trigger_decision_connection,
-                                                      static_cast<const void*>(serialised_decision.data()),
-                                                      serialised_decision.size(),
-                                                      std::chrono::milliseconds(1));
-        m_td_sent_count++;
-        m_last_trigger_number++;
-      } catch (const ers::Issue& e) {
-	ers::error(e);
-        TLOG_DEBUG(1) << "The network is misbehaving: it accepted TD but the send failed for "
-                      << tc.time_candidate;
-        m_td_queue_timeout_expired_err_count++;
+    if (status == tc_source_t::Status::kData) {
+      ++m_tc_received_count;
+      if (m_paused.load()) {
+        ++m_td_paused_count;
+        m_scheduler.dropped(tc.type);
+        TLOG_DEBUG(1) << "Triggers are paused. Not sending a TriggerDecision ";
+      } else if (!m_scheduler.add(tc)) {
+        TLOG_DEBUG(1) << "Candidate of type " << static_cast<std::underlying_type_t<decltype(tc.type)>>(tc.type)
+                      << " with timestamp " << tc.time_candidate << " was prescaled or rate limited";
       }
+      m_td_total_count++;
+    }
 
-    } else if (m_paused.load()) {
-      ++m_td_paused_count;
-      TLOG_DEBUG(1) << "Triggers are paused. Not sending a TriggerDecision ";
+    if (m_paused.load()) {
+      // Anything held from before the pause is stale by the time we resume
+      m_scheduler.shed(0, TCScheduler::clock_t::now(), [this](const triggeralgs::TriggerCandidate&) {
+        ++m_td_paused_count;
+      });
     } else {
-      ers::warning(TriggerInhibited(ERS_HERE, m_run_number));
-      TLOG_DEBUG(1) << "The DFO is busy. Not sending a TriggerDecision for candidate timestamp "
-                    << tc.time_candidate;
-      m_td_inhibited_count++;
+      // Send what we can, then trim whatever is left to the configured
+      // depth. With the default depth of zero, this drops every candidate
+      // that arrives while the DFO is busy
+      send_pending_decisions(inhibit);
+      m_scheduler.shed_to_limit(TCScheduler::clock_t::now(), inhibit);
     }
-    m_td_total_count++;
   }
 
+  // Anything still pending at the end of the run will never be sent
+  m_scheduler.shed(0, TCScheduler::clock_t::now(), inhibit);
+
   TLOG() << "Run " << m_run_number << ": "
          << "Received " << m_tc_received_count << " TCs. Sent " << m_td_sent_count.load() << " TDs. "
-         << m_td_paused_count << " TDs were created during pause, and " << m_td_inhibited_count.load()
-         << " TDs were inhibited.";
+         << m_td_paused_count << " TDs were created during pause, " << m_td_inhibited_count.load()
+         << " TDs were inhibited. " << m_td_merged_count.load() << " TDs were merged into earlier ones, and "
+         << m_td_trimmed_count.load() << " were trimmed.";
 }
 
 void
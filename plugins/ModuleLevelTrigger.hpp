@@ -14,6 +14,9 @@
 #ifndef TRIGGER_PLUGINS_MODULELEVELTRIGGER_HPP_
 #define TRIGGER_PLUGINS_MODULELEVELTRIGGER_HPP_
 
+#include "trigger/DecisionWindowIndex.hpp"
+#include "trigger/StopSignal.hpp"
+#include "trigger/TCScheduler.hpp"
 #include "trigger/TokenManager.hpp"
 #include "trigger/moduleleveltriggerinfo/InfoNljs.hpp"
 
@@ -32,6 +35,7 @@
 #include "appfwk/DAQSink.hpp"
 #include "appfwk/DAQSource.hpp"
 
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
@@ -78,6 +82,10 @@ private:
   // Create the next trigger decision
   dfmessages::TriggerDecision create_decision(const triggeralgs::TriggerCandidate& tc);
 
+  // Send a trigger decision for each pending candidate, highest priority
+  // first. Candidates that timed out while pending are passed to `on_shed`
+  void send_pending_decisions(const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed);
+
   void dfo_busy_callback(ipm::Receiver::Response message);
 
   // Queue sources and sinks
@@ -85,6 +93,12 @@ private:
 
   std::vector<dfmessages::GeoID> m_links;
 
+  // Decides which candidates become decisions, and in which order
+  TCScheduler m_scheduler;
+
+  // Readout windows of recently sent decisions, to avoid reading out the same data twice
+  DecisionWindowIndex m_decision_windows;
+
   int m_repeat_trigger_count{ 1 };
 
   // paused state, in which we don't send triggers
@@ -99,6 +113,8 @@ private:
 
   // Are we in the RUNNING state?
   std::atomic<bool> m_running_flag{ false };
+  // Wakes the decision thread when we're stopped
+  StopSignal m_stop_signal;
   // Are we in a configured state, ie after conf and before scrap?
   std::atomic<bool> m_configured_flag{ false };
 
@@ -110,6 +126,8 @@ private:
   std::atomic<metric_counter_type> m_td_paused_count{ 0 };
   std::atomic<metric_counter_type> m_td_total_count{ 0 };
   std::atomic<metric_counter_type> m_td_queue_timeout_expired_err_count{ 0 };
+  std::atomic<metric_counter_type> m_td_merged_count{ 0 };
+  std::atomic<metric_counter_type> m_td_trimmed_count{ 0 };
 };
 } // namespace trigger
 } // namespace dunedaq
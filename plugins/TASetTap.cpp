@@ -0,0 +1,12 @@
+/**
+ * @file TASetTap.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TASetTap.hpp"
+#include "appfwk/DAQModuleHelper.hpp"
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::trigger::TASetTap)
@@ -0,0 +1,20 @@
+/**
+ * @file TASetTap.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_PLUGINS_TASETTAP_HPP_
+#define TRIGGER_PLUGINS_TASETTAP_HPP_
+
+#include "TriggerTap.hpp"
+#include "trigger/TASet.hpp"
+
+namespace dunedaq::trigger {
+
+using TASetTap = TriggerTap<TASet>;
+
+} // namespace dunedaq::trigger
+#endif // TRIGGER_PLUGINS_TASETTAP_HPP_
@@ -0,0 +1,20 @@
+/**
+ * @file TCTap.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_PLUGINS_TCTAP_HPP_
+#define TRIGGER_PLUGINS_TCTAP_HPP_
+
+#include "TriggerTap.hpp"
+#include "trigger/TriggerCandidate_serialization.hpp"
+
+namespace dunedaq::trigger {
+
+using TCTap = TriggerTap<triggeralgs::TriggerCandidate>;
+
+} // namespace dunedaq::trigger
+#endif // TRIGGER_PLUGINS_TCTAP_HPP_
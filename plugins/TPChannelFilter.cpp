@@ -0,0 +1,70 @@
+/**
+ * @file TPChannelFilter.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TPChannelFilter.hpp"
+
+#include "trigger/tpchannelfilter/Nljs.hpp"
+#include "trigger/tpchannelfilterinfo/InfoNljs.hpp"
+
+#include <memory>
+#include <string>
+
+namespace dunedaq::trigger {
+
+void
+TPChannelFilter::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  // The masker in use, rather than one staged by a reconfigure and not yet swapped in
+  auto masker = get_maker();
+  if (!masker) {
+    return;
+  }
+
+  auto masked_channels = masker->get_masked_channels();
+
+  tpchannelfilterinfo::Info i;
+  i.tp_passed_count = masker->get_n_passed();
+  i.tp_dropped_count = masker->get_n_dropped();
+  i.mask_count = masker->get_n_mask_events();
+  i.masked_channel_count = masked_channels.size();
+  ci.add(i);
+
+  for (auto const& masked : masked_channels) {
+    tpchannelfilterinfo::ChannelInfo channel_info;
+    channel_info.rate_hz = masked.rate_hz;
+    channel_info.masked_until = masked.masked_until;
+
+    opmonlib::InfoCollector channel_ci;
+    channel_ci.add(channel_info);
+    ci.add("channel_" + std::to_string(masked.channel), channel_ci);
+  }
+}
+
+std::shared_ptr<ChannelRateMasker>
+TPChannelFilter::make_maker(const nlohmann::json& obj)
+{
+  auto params = obj.get<tpchannelfilter::Conf>();
+  set_algorithm_name("ChannelRateMasker");
+  set_geoid(params.geoid_region, params.geoid_element);
+  set_windowing(params.window_time, params.buffer_time);
+
+  ChannelRateMasker::Config config;
+  config.max_rate_hz = params.max_rate_hz;
+  config.rate_interval = params.rate_interval;
+  config.cooldown = params.cooldown;
+  config.clock_frequency_hz = params.clock_frequency_hz;
+  config.max_channel = params.max_channel;
+
+  auto masker = std::make_shared<ChannelRateMasker>();
+  masker->configure(config);
+  return masker;
+}
+
+} // namespace dunedaq::trigger
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::trigger::TPChannelFilter)
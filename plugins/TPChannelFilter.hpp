@@ -0,0 +1,51 @@
+/**
+ * @file TPChannelFilter.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_PLUGINS_TPCHANNELFILTER_HPP_
+#define TRIGGER_PLUGINS_TPCHANNELFILTER_HPP_
+
+#include "trigger/ChannelRateMasker.hpp"
+#include "trigger/TriggerGenericMaker.hpp"
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <memory>
+#include <string>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief TPChannelFilter passes TPSets through, dropping the TPs from
+ * channels that are producing TPs at too high a rate (see ChannelRateMasker).
+ * It is meant to sit in front of the TriggerActivityMaker, so that noisy
+ * channels don't load the rest of the chain
+ */
+class TPChannelFilter
+  : public TriggerGenericMaker<Set<triggeralgs::TriggerPrimitive>,
+                               Set<triggeralgs::TriggerPrimitive>,
+                               ChannelRateMasker>
+{
+public:
+  explicit TPChannelFilter(const std::string& name)
+    : TriggerGenericMaker(name)
+  {}
+
+  TPChannelFilter(const TPChannelFilter&) = delete;
+  TPChannelFilter& operator=(const TPChannelFilter&) = delete;
+  TPChannelFilter(TPChannelFilter&&) = delete;
+  TPChannelFilter& operator=(TPChannelFilter&&) = delete;
+
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
+
+private:
+  std::shared_ptr<ChannelRateMasker> make_maker(const nlohmann::json& obj) override;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_PLUGINS_TPCHANNELFILTER_HPP_
@@ -9,6 +9,7 @@
 
 //#include "CommonIssues.hpp"
 #include "TPSetBufferCreator.hpp"
+#include "trigger/InterruptibleSource.hpp"
 #include "trigger/Issues.hpp"
 
 #include "daqdataformats/FragmentHeader.hpp"
@@ -73,6 +74,7 @@ TPSetBufferCreator::do_configure(const nlohmann::json& obj)
 void
 TPSetBufferCreator::do_start(const nlohmann::json& /*args*/)
 {
+  m_stop_signal.reset();
   m_thread.start_working_thread("buffer-man");
   TLOG() << get_name() << " successfully started";
 }
@@ -80,6 +82,7 @@ TPSetBufferCreator::do_start(const nlohmann::json& /*args*/)
 void
 TPSetBufferCreator::do_stop(const nlohmann::json& /*args*/)
 {
+  m_stop_signal.request_stop();
   m_thread.stop_working_thread();
 
 
@@ -216,15 +219,20 @@ TPSetBufferCreator::do_work(std::atomic<bool>& running_flag)
 
   bool first = true;
 
+  InterruptibleSource<trigger::TPSet> tps_input(*m_input_queue_tps, m_stop_signal);
+  InterruptibleSource<dfmessages::DataRequest> dr_input(*m_input_queue_dr, m_stop_signal);
+
   while (running_flag.load()) {
 
     trigger::TPSet input_tpset;
     dfmessages::DataRequest input_data_request;
     TPSetBuffer::DataRequestOutput requested_tpset;
 
+    // Don't wait for TPSets when there's already a data request to serve
+    auto tps_timeout = m_input_queue_dr->can_pop() ? std::chrono::milliseconds(0) : m_queueTimeout;
+
     // Block that receives TPSets and add them in buffer and check for pending data requests
-    try {
-      m_input_queue_tps->pop(input_tpset, m_queueTimeout);
+    if (tps_input.pop(input_tpset, tps_timeout) == InterruptibleSource<trigger::TPSet>::Status::kData) {
       if (first) {
         TLOG() << get_name() << ": Got first TPSet, with start_time=" << input_tpset.start_time
                << " and end_time=" << input_tpset.end_time;
@@ -281,13 +289,10 @@ TPSetBufferCreator::do_work(std::atomic<bool>& running_flag)
           it++;
         }
       } // end if(!m_dr_on_hold.empty())
-
-    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
     }
 
     // Block that receives data requests and return fragments from buffer
-    try {
-      m_input_queue_dr->pop(input_data_request, std::chrono::milliseconds(0));
+    if (dr_input.try_pop(input_data_request)) {
       requested_tpset = m_tps_buffer->get_txsets_in_window(input_data_request.request_information.window_begin,
                                                            input_data_request.request_information.window_end);
       ++requestedCount;
@@ -325,10 +330,6 @@ TPSetBufferCreator::do_work(std::atomic<bool>& running_flag)
         default:
           TLOG() << get_name() << ": Data request failed!";
       }
-
-    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-      // skip if no data request in the queue
-      continue;
     }
   } // end while(running_flag.load())
 
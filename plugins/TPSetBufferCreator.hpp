@@ -13,6 +13,7 @@
 #include "dfmessages/DataRequest.hpp"
 #include "dfmessages/HSIEvent.hpp"
 
+#include "trigger/StopSignal.hpp"
 #include "trigger/TPSet.hpp"
 #include "trigger/TPSetBuffer.hpp"
 #include "trigger/tpsetbuffercreator/Nljs.hpp"
@@ -63,6 +64,7 @@ private:
 
   // Threading
   dunedaq::utilities::WorkerThread m_thread;
+  StopSignal m_stop_signal;
   void do_work(std::atomic<bool>&);
 
   // Configuration
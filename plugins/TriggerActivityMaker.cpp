@@ -9,22 +9,79 @@
 #include "TriggerActivityMaker.hpp"
 
 #include "trigger/AlgorithmPlugins.hpp"
+#include "trigger/TriggerActivityMakerComposite.hpp"
 #include "trigger/triggeractivitymaker/Nljs.hpp"
+#include "trigger/triggeractivitymakerinfo/InfoNljs.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace dunedaq::trigger {
 
+void
+TriggerActivityMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  triggeractivitymakerinfo::Info i;
+  i.received_count = get_received_count();
+  i.sent_count = get_sent_count();
+  i.tardy_count = get_tardy_count();
+  i.buffer_time = get_current_buffer_time();
+  ci.add(i);
+}
+
 std::shared_ptr<triggeralgs::TriggerActivityMaker>
 TriggerActivityMaker::make_maker(const nlohmann::json& obj)
 {
   auto params = obj.get<triggeractivitymaker::Conf>();
-  set_algorithm_name(params.activity_maker);
   set_geoid(params.geoid_region, params.geoid_element);
   set_windowing(params.window_time, params.buffer_time);
-  std::shared_ptr<triggeralgs::TriggerActivityMaker> maker = make_ta_maker(params.activity_maker);
-  maker->configure(params.activity_maker_config);
-  return maker;
+
+  AdaptiveBufferTime adaptive_buffer;
+  adaptive_buffer.enabled = params.adaptive_buffer;
+  adaptive_buffer.percentile = params.buffer_percentile;
+  adaptive_buffer.margin = params.buffer_margin;
+  adaptive_buffer.min_buffer_time = params.buffer_time_min;
+  adaptive_buffer.max_buffer_time = params.buffer_time_max;
+  adaptive_buffer.update_interval = params.buffer_update_interval;
+  set_adaptive_buffer(adaptive_buffer);
+
+  if (params.activity_makers.empty()) {
+    set_algorithm_name(params.activity_maker);
+    set_output_queues({});
+    std::shared_ptr<triggeralgs::TriggerActivityMaker> maker = make_ta_maker(params.activity_maker);
+    maker->configure(params.activity_maker_config);
+    return maker;
+  }
+
+  // Several makers share this module's input buffering and sorting. Makers
+  // with an output other than the main one are routed to it, one route per
+  // distinct output
+  std::string algorithm_name;
+  std::vector<std::shared_ptr<triggeralgs::TriggerActivityMaker>> makers;
+  std::vector<size_t> routes;
+  std::vector<std::string> outputs;
+  for (auto const& maker_conf : params.activity_makers) {
+    std::shared_ptr<triggeralgs::TriggerActivityMaker> maker = make_ta_maker(maker_conf.activity_maker);
+    maker->configure(maker_conf.activity_maker_config);
+    makers.push_back(maker);
+    algorithm_name += (algorithm_name.empty() ? "" : "+") + maker_conf.activity_maker;
+
+    size_t route = 0;
+    if (!maker_conf.output.empty() && maker_conf.output != "output") {
+      auto output = std::find(outputs.begin(), outputs.end(), maker_conf.output);
+      route = std::distance(outputs.begin(), output) + 1;
+      if (output == outputs.end()) {
+        outputs.push_back(maker_conf.output);
+      }
+    }
+    routes.push_back(route);
+  }
+  set_algorithm_name(algorithm_name);
+  set_output_queues(outputs);
+  return std::make_shared<TriggerActivityMakerComposite>(makers, params.parallel, routes);
 }
 
 } // namespace dunedaq::trigger
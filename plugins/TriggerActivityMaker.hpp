@@ -35,6 +35,8 @@ public:
   TriggerActivityMaker(TriggerActivityMaker&&) = delete;
   TriggerActivityMaker& operator=(TriggerActivityMaker&&) = delete;
 
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
+
 private:
   virtual std::shared_ptr<triggeralgs::TriggerActivityMaker> make_maker(const nlohmann::json& obj);
 };
@@ -7,6 +7,8 @@
  */
 
 #include "trigger/AlgorithmPlugins.hpp"
-#include "triggeralgs/ADCSimpleWindow/TriggerActivityMakerADCSimpleWindow.hpp"
+#include "trigger/TriggerActivityMakerADCSimpleWindowFast.hpp"
 
-DEFINE_DUNE_TA_MAKER(triggeralgs::TriggerActivityMakerADCSimpleWindow)
+// Behaves exactly like triggeralgs::TriggerActivityMakerADCSimpleWindow
+// unless "fast_path" is set in the algorithm configuration
+DEFINE_DUNE_TA_MAKER(dunedaq::trigger::TriggerActivityMakerADCSimpleWindowFast)
@@ -0,0 +1,12 @@
+/**
+ * @file TriggerActivityMakerChannelClusterPlugin.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/AlgorithmPlugins.hpp"
+#include "trigger/TriggerActivityMakerChannelCluster.hpp"
+
+DEFINE_DUNE_TA_MAKER(dunedaq::trigger::TriggerActivityMakerChannelCluster)
@@ -18,8 +18,13 @@
 #include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <queue>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 using namespace triggeralgs;
@@ -28,8 +33,8 @@ namespace dunedaq::trigger {
 
 TriggerPrimitiveMaker::TriggerPrimitiveMaker(const std::string& name)
   : dunedaq::appfwk::DAQModule(name)
-  , m_thread(std::bind(&TriggerPrimitiveMaker::do_work, this, std::placeholders::_1))
-  , m_tpset_sink()
+  , m_first_tpset_start_time(0)
+  , m_input_duration(0)
   , m_queue_timeout(100)
 {
   register_command("conf", &TriggerPrimitiveMaker::do_configure);
@@ -41,74 +46,141 @@ TriggerPrimitiveMaker::TriggerPrimitiveMaker(const std::string& name)
 void
 TriggerPrimitiveMaker::init(const nlohmann::json& obj)
 {
-  m_tpset_sink.reset(new appfwk::DAQSink<TPSet>(appfwk::queue_inst(obj, "tpset_sink")));
+  // tpset_sink is only needed when the streams aren't given in the
+  // configuration, since each stream names its own queue
+  auto queues = appfwk::queue_index(obj);
+  if (queues.count("tpset_sink")) {
+    m_tpset_sink_instance = queues["tpset_sink"].inst;
+  }
 }
 
-void
-TriggerPrimitiveMaker::do_configure(const nlohmann::json& obj)
+std::shared_ptr<const TriggerPrimitiveMaker::TPSource>
+TriggerPrimitiveMaker::load_tps(const std::string& filename)
 {
-  m_conf = obj.get<triggerprimitivemaker::ConfParams>();
+  auto tps = std::make_shared<TPSource>();
+
+  // Binary TP files (made by tp_text_to_binary) are memory-mapped, so that
+  // large files don't have to be read before the run starts
+  if (TPFileReader::is_tp_file(filename)) {
+    try {
+      tps->file.reset(new TPFileReader(filename));
+    } catch (const BadTPFile& excpt) {
+      throw BadTPInputFile(ERS_HERE, get_name(), filename, excpt);
+    }
+    TLOG() << get_name() << ": Mapped " << tps->file->size() << " TPs from binary file " << filename;
+    return tps;
+  }
 
-  std::ifstream file(m_conf.filename);
+  std::ifstream file(filename);
   if (!file || file.bad()) {
-    throw BadTPInputFile(ERS_HERE, get_name(), m_conf.filename);
+    throw BadTPInputFile(ERS_HERE, get_name(), filename);
   }
 
   TriggerPrimitive tp;
-  TPSet tpset;
-
-  uint64_t prev_tpset_number = 0; // NOLINT(build/unsigned)
-  uint32_t seqno = 0;             // NOLINT(build/unsigned)
-  uint64_t old_time_start = 0;    // NOLINT(build/unsigned)
-
-  // Read in the file and place the TPs in TPSets. TPSets have time
-  // boundaries ( n*tpset_time_width + tpset_time_offset ), and TPs are placed
-  // in TPSets based on the TP start time
-  //
-  // This loop assumes the input file is sorted by TP start time
-  while (file >> tp.time_start >> tp.time_over_threshold >> tp.time_peak >> tp.channel >> tp.adc_integral >>
-         tp.adc_peak >> tp.detid >> tp.type) {
-    if (tp.time_start >= old_time_start) {
-      // NOLINTNEXTLINE(build/unsigned)
-      uint64_t current_tpset_number = (tp.time_start + m_conf.tpset_time_offset) / m_conf.tpset_time_width;
-      old_time_start = tp.time_start;
-
-      // If we crossed a time boundary, push the current TPSet and reset it
-      if (current_tpset_number > prev_tpset_number) {
-        if (!tpset.objects.empty()) {
-          // We don't send empty TPSets, so there's no point creating them
-          m_tpsets.push_back(tpset);
-        }
-        prev_tpset_number = current_tpset_number;
+  while (read_tp_text(file, tp)) {
+    if (tps->text_tps.empty() || tp.time_start >= tps->text_tps.back().time_start) {
+      tps->text_tps.push_back(tp);
+    } else {
+      ers::warning(UnsortedTP(ERS_HERE, get_name(), tp.time_start));
+    }
+  }
+  return tps;
+}
 
-        tpset.start_time = current_tpset_number * m_conf.tpset_time_width + m_conf.tpset_time_offset;
-        tpset.end_time = tpset.start_time + m_conf.tpset_time_width;
-        tpset.seqno = seqno;
-        ++seqno;
+void
+TriggerPrimitiveMaker::do_configure(const nlohmann::json& obj)
+{
+  m_conf = obj.get<triggerprimitivemaker::ConfParams>();
+  if (m_conf.replay_speed < 0) {
+    throw InvalidConfiguration(ERS_HERE);
+  }
 
-        // 12-Jul-2021, KAB: setting origin fields from configuration
-        tpset.origin.region_id = m_conf.region_id;
-        tpset.origin.element_id = m_conf.element_id;
+  m_threads.clear();
+  m_streams.clear();
 
-        tpset.type = TPSet::Type::kPayload;
-        tpset.objects.clear();
-      }
-      tpset.objects.push_back(tp);
-    } else {
-      ers::warning(UnsortedTP(ERS_HERE, get_name(), tp.time_start));
+  std::map<std::string, std::shared_ptr<const TPSource>> sources;
+  auto get_tps = [&](const std::string& filename) {
+    auto& tps = sources[filename];
+    if (!tps) {
+      tps = load_tps(filename);
     }
+    return tps;
+  };
+
+  if (m_conf.streams.empty()) {
+    // A single stream, configured as TriggerPrimitiveMaker always has been
+    if (m_tpset_sink_instance.empty()) {
+      throw InvalidQueueFatalError(ERS_HERE, get_name(), "tpset_sink");
+    }
+    m_streams.push_back(Stream{ get_tps(m_conf.filename),
+                                m_conf.region_id,
+                                m_conf.element_id,
+                                std::make_unique<appfwk::DAQSink<TPSet>>(m_tpset_sink_instance) });
   }
-  if (!tpset.objects.empty()) {
-    // We don't send empty TPSets, so there's no point creating them
-    m_tpsets.push_back(tpset);
+  for (auto const& stream_conf : m_conf.streams) {
+    std::unique_ptr<appfwk::DAQSink<TPSet>> sink;
+    try {
+      sink.reset(new appfwk::DAQSink<TPSet>(stream_conf.queue_instance));
+    } catch (const ers::Issue& excpt) {
+      throw InvalidQueueFatalError(ERS_HERE, get_name(), stream_conf.queue_instance, excpt);
+    }
+    m_streams.push_back(
+      Stream{ get_tps(stream_conf.filename), stream_conf.region_id, stream_conf.element_id, std::move(sink) });
   }
+
+  size_t n_threads = std::clamp<size_t>(m_conf.number_of_threads, 1, m_streams.size());
+  for (size_t i = 0; i < n_threads; ++i) {
+    m_threads.emplace_back(std::make_unique<utilities::WorkerThread>(
+      std::bind(&TriggerPrimitiveMaker::do_work, this, std::placeholders::_1, i)));
+  }
+
+  TLOG() << get_name() << ": Replaying " << m_streams.size() << " streams from " << sources.size() << " files with "
+         << n_threads << " threads at "
+         << (m_conf.replay_speed > 0 ? std::to_string(m_conf.replay_speed) + "x real time" : "maximum throughput");
+}
+
+void
+TriggerPrimitiveMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  triggerprimitivemakerinfo::Info i;
+  i.tpset_sent_count = m_tpset_sent_count.load();
+  i.tp_sent_count = m_tp_sent_count.load();
+  i.push_failed_count = m_push_failed_count.load();
+  ci.add(i);
 }
 
 void
 TriggerPrimitiveMaker::do_start(const nlohmann::json& /*args*/)
 {
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_start() method";
-  m_thread.start_working_thread("tpmaker");
+
+  // TPSets have time boundaries ( n*tpset_time_width + tpset_time_offset ),
+  // and TPs are placed in TPSets based on the TP start time. Loops over the
+  // input are shifted by the span of all the streams together, so the
+  // streams stay aligned
+  auto tpset_number = [this](const TriggerPrimitive& tp) {
+    return (tp.time_start + m_conf.tpset_time_offset) / m_conf.tpset_time_width;
+  };
+  uint64_t first_tpset_number = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+  uint64_t last_tpset_number = 0;                                      // NOLINT(build/unsigned)
+  for (auto const& stream : m_streams) {
+    if (stream.tps->begin() != stream.tps->end()) {
+      first_tpset_number = std::min(first_tpset_number, tpset_number(*stream.tps->begin()));
+      last_tpset_number = std::max(last_tpset_number, tpset_number(*(stream.tps->end() - 1)));
+    }
+  }
+  if (last_tpset_number >= first_tpset_number) {
+    m_first_tpset_start_time = first_tpset_number * m_conf.tpset_time_width + m_conf.tpset_time_offset;
+    m_input_duration = (last_tpset_number - first_tpset_number + 1) * m_conf.tpset_time_width;
+  }
+  m_tpset_sent_count = 0;
+  m_tp_sent_count = 0;
+  m_push_failed_count = 0;
+  m_run_start_time = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < m_threads.size(); ++i) {
+    m_threads[i]->start_working_thread("tpmaker-" + std::to_string(i));
+  }
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_start() method";
 }
 
@@ -116,7 +188,9 @@ void
 TriggerPrimitiveMaker::do_stop(const nlohmann::json& /*args*/)
 {
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_stop() method";
-  m_thread.stop_working_thread();
+  for (auto& thread : m_threads) {
+    thread->stop_working_thread();
+  }
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
 }
 
@@ -124,99 +198,179 @@ void
 TriggerPrimitiveMaker::do_scrap(const nlohmann::json& /*args*/)
 {
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
-  m_tpsets.clear();
+  m_threads.clear();
+  m_streams.clear();
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
 }
 
+bool
+TriggerPrimitiveMaker::wait_until(std::chrono::steady_clock::time_point time, std::atomic<bool>& running_flag) const
+{
+  // check running_flag periodically
+  auto slice_period = std::chrono::microseconds(m_conf.maximum_wait_time_us);
+  while (std::chrono::steady_clock::now() + slice_period < time) {
+    if (!running_flag.load()) {
+      TLOG() << "while waiting to send next TP, negative running flag detected.";
+      return false;
+    }
+    std::this_thread::sleep_for(slice_period);
+  }
+  std::this_thread::sleep_until(time);
+  return running_flag.load();
+}
+
 void
-TriggerPrimitiveMaker::do_work(std::atomic<bool>& running_flag)
+TriggerPrimitiveMaker::do_work(std::atomic<bool>& running_flag, size_t thread_index)
 {
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_work() method";
-  uint64_t current_iteration = 0; // NOLINT(build/unsigned)
   size_t generated_count = 0;
   size_t push_failed_count = 0;
   size_t generated_tp_count = 0;
+  size_t queue_full_count = 0;
+
+  auto tpset_number = [this](const TriggerPrimitive& tp) {
+    return (tp.time_start + m_conf.tpset_time_offset) / m_conf.tpset_time_width;
+  };
+  // Ticks of data time per second of replay
+  double replay_ticks_per_s = m_conf.clock_frequency_hz * m_conf.replay_speed;
+
+  // Where we are in each of this thread's streams
+  struct Cursor
+  {
+    Stream* stream;
+    const TriggerPrimitive* next;
+    uint64_t iteration;       // NOLINT(build/unsigned)
+    uint32_t seqno;           // NOLINT(build/unsigned)
+    uint64_t next_start_time; // NOLINT(build/unsigned)
+  };
+  std::vector<Cursor> cursors;
+  for (size_t i = thread_index; i < m_streams.size(); i += m_threads.size()) {
+    auto& stream = m_streams[i];
+    if (stream.tps->begin() != stream.tps->end()) {
+      cursors.push_back(Cursor{ &stream,
+                                stream.tps->begin(),
+                                0,
+                                0,
+                                tpset_number(*stream.tps->begin()) * m_conf.tpset_time_width +
+                                  m_conf.tpset_time_offset });
+    }
+  }
 
-  uint64_t prev_tpset_start_time = 0; // NOLINT(build/unsigned)
-  auto prev_tpset_send_time = std::chrono::steady_clock::now();
-
-  auto input_file_duration = m_tpsets.back().start_time - m_tpsets.front().start_time + m_conf.tpset_time_width;
+  // Send the earliest next TPSet from any of our streams first
+  auto later = [](const Cursor* a, const Cursor* b) { return a->next_start_time > b->next_start_time; };
+  std::priority_queue<Cursor*, std::vector<Cursor*>, decltype(later)> pending(later);
+  for (auto& cursor : cursors) {
+    pending.push(&cursor);
+  }
 
   auto run_start_time = std::chrono::steady_clock::now();
 
-  uint32_t seqno = 0; // NOLINT(build/unsigned)
-
-  while (running_flag.load()) {
-    if (m_conf.number_of_loops > 0 && current_iteration >= m_conf.number_of_loops) {
-      break;
+  while (running_flag.load() && !pending.empty()) {
+    Cursor* cursor = pending.top();
+    pending.pop();
+    const TPSource& tps = *cursor->stream->tps;
+
+    // Timestamps are shifted on each loop so they don't repeat when we do
+    // multiple loops over the file
+    uint64_t loop_offset = cursor->iteration * m_input_duration; // NOLINT(build/unsigned)
+
+    // The TPs are sorted, so this TPSet is everything up to the first TP with a different TPSet number. We don't
+    // send empty TPSets, so there's no point creating them
+    uint64_t current_tpset_number = tpset_number(*cursor->next); // NOLINT(build/unsigned)
+    const TriggerPrimitive* tpset_end = std::find_if(
+      cursor->next, tps.end(), [&](const TriggerPrimitive& tp) { return tpset_number(tp) != current_tpset_number; });
+
+    TPSet tpset;
+    tpset.start_time = cursor->next_start_time;
+    tpset.end_time = tpset.start_time + m_conf.tpset_time_width;
+    tpset.seqno = cursor->seqno;
+    ++cursor->seqno;
+
+    // 12-Jul-2021, KAB: setting origin fields from configuration
+    tpset.origin.region_id = cursor->stream->region_id;
+    tpset.origin.element_id = cursor->stream->element_id;
+
+    tpset.type = TPSet::Type::kPayload;
+    // The TPs have to be copied into the TPSet anyway, so shift them as
+    // they're copied, rather than in a separate pass
+    if (loop_offset == 0) {
+      tpset.objects.assign(cursor->next, tpset_end);
+    } else {
+      tpset.objects.resize(tpset_end - cursor->next);
+      std::transform(cursor->next, tpset_end, tpset.objects.begin(), [loop_offset](TriggerPrimitive tp) {
+        tp.time_start += loop_offset;
+        tp.time_peak += loop_offset;
+        return tp;
+      });
     }
-
-    for (auto& tpset : m_tpsets) {
-
-      if (!running_flag.load()) {
+    size_t n_tps = tpset.objects.size();
+
+    if (replay_ticks_per_s > 0) {
+      // All the streams share one clock, so TPSets are sent in data-time order across streams and threads. The first
+      // TPSet of the input goes out right away, and each one after that is spaced from it by its start time
+      std::chrono::duration<double> send_delay((tpset.start_time - m_first_tpset_start_time) / replay_ticks_per_s);
+      auto send_time =
+        m_run_start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(send_delay);
+      if (!wait_until(send_time, running_flag)) {
         break;
       }
 
-      // We send out the first TPSet right away. After that we space each TPSet in time by their start time
-      auto wait_time_us = 0;
-      if (prev_tpset_start_time == 0) {
-        wait_time_us = 0;
-      } else {
-        auto clocks_per_us = m_conf.clock_frequency_hz / 1'000'000;
-        wait_time_us = (tpset.start_time - prev_tpset_start_time) / clocks_per_us;
-      }
-
-      auto next_tpset_send_time = prev_tpset_send_time + std::chrono::microseconds(wait_time_us);
-      // check running_flag periodically using lambda
-      auto slice_period = std::chrono::microseconds(m_conf.maximum_wait_time_us);
-      auto next_slice_send_time = prev_tpset_send_time + slice_period;
-      bool break_flag = false;
-      while (next_tpset_send_time > next_slice_send_time + slice_period) {
-        if (!running_flag.load()) {
-          TLOG() << "while waiting to send next TP, negative running flag detected.";
-          break_flag = true;
-          break;
-        }
-        std::this_thread::sleep_until(next_slice_send_time);
-        next_slice_send_time = next_slice_send_time + slice_period;
-      }
-      if (break_flag == false) {
-        std::this_thread::sleep_until(next_tpset_send_time);
-      }
-      prev_tpset_send_time = next_tpset_send_time;
-      prev_tpset_start_time = tpset.start_time;
-
-      ++generated_count;
-      generated_tp_count += tpset.objects.size();
       try {
-        m_tpset_sink->push(tpset, m_queue_timeout);
+        cursor->stream->sink->push(std::move(tpset), m_queue_timeout);
+        ++generated_count;
+        generated_tp_count += n_tps;
+        ++m_tpset_sent_count;
+        m_tp_sent_count += n_tps;
       } catch (const dunedaq::appfwk::QueueTimeoutExpired& e) {
         ers::warning(e);
         ++push_failed_count;
+        ++m_push_failed_count;
       }
-
-      // Increase seqno and the timestamps in the TPSet and TPs so they don't
-      // repeat when we do multiple loops over the file
-      tpset.start_time += input_file_duration;
-      tpset.end_time += input_file_duration;
-      for (auto& tp : tpset.objects) {
-        tp.time_start += input_file_duration;
-        tp.time_peak += input_file_duration;
+    } else {
+      // Unpaced: send as fast as the queue accepts, so a full queue slows us down rather than losing TPSets. The
+      // appfwk queues (StdDeQueue, FollySPSCQueue) only move from the object once it is in the queue, and leave it
+      // alone when the push times out, so the same TPSet can be moved again on the next attempt
+      bool pushed = false;
+      while (!pushed && running_flag.load()) {
+        try {
+          cursor->stream->sink->push(std::move(tpset), m_queue_timeout);
+          pushed = true;
+        } catch (const dunedaq::appfwk::QueueTimeoutExpired&) {
+          ++queue_full_count;
+        }
       }
-      tpset.seqno = seqno;
-      ++seqno;
-
-    } // end loop over tpsets
-    ++current_iteration;
+      if (!pushed) {
+        break;
+      }
+      ++generated_count;
+      generated_tp_count += n_tps;
+      ++m_tpset_sent_count;
+      m_tp_sent_count += n_tps;
+    }
 
-  } // end while(running_flag.load())
+    cursor->next = tpset_end;
+    if (cursor->next == tps.end()) {
+      ++cursor->iteration;
+      if (m_conf.number_of_loops > 0 && cursor->iteration >= m_conf.number_of_loops) {
+        continue;
+      }
+      cursor->next = tps.begin();
+    }
+    cursor->next_start_time = tpset_number(*cursor->next) * m_conf.tpset_time_width + m_conf.tpset_time_offset +
+                              cursor->iteration * m_input_duration;
+    pending.push(cursor);
+  }
 
   auto run_end_time = std::chrono::steady_clock::now();
   auto time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(run_end_time - run_start_time).count();
-  float rate_hz = 1e3 * static_cast<float>(generated_count) / time_ms;
-
-  TLOG() << "Generated " << generated_count << " TP sets (" << generated_tp_count << " TPs) in " << time_ms << " ms. ("
-         << rate_hz << " TPSets/s). " << push_failed_count << " failed to push";
+  std::chrono::duration<double> time_s = run_end_time - run_start_time;
+  double rate_hz = generated_count / time_s.count();
+  double tp_rate_hz = generated_tp_count / time_s.count();
+
+  TLOG() << "Thread " << thread_index << " generated " << generated_count << " TP sets (" << generated_tp_count
+         << " TPs) from " << cursors.size() << " streams in " << time_ms << " ms. (" << rate_hz << " TPSets/s, "
+         << tp_rate_hz << " TPs/s). " << push_failed_count << " failed to push, " << queue_full_count
+         << " push attempts found the queue full";
 
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
 }
@@ -16,9 +16,13 @@
 #include "appfwk/DAQSource.hpp"
 #include "utilities/WorkerThread.hpp"
 
+#include "trigger/TPFile.hpp"
 #include "trigger/TPSet.hpp"
 #include "trigger/triggerprimitivemaker/Nljs.hpp"
+#include "trigger/triggerprimitivemakerinfo/InfoNljs.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -41,6 +45,7 @@ public:
   TriggerPrimitiveMaker& operator=(TriggerPrimitiveMaker&&) = delete; ///< TriggerPrimitiveMaker is not move-assignable
 
   void init(const nlohmann::json& obj) override;
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
 
 private:
   // Commands
@@ -49,16 +54,57 @@ private:
   void do_stop(const nlohmann::json& obj);
   void do_scrap(const nlohmann::json& obj);
 
-  // Threading
-  dunedaq::utilities::WorkerThread m_thread;
-  void do_work(std::atomic<bool>&);
+  // The TPs from one input file, sorted by time_start. Binary TP files are
+  // memory-mapped, and text files are read into `text_tps`. Streams that
+  // name the same file share one TPSource
+  struct TPSource
+  {
+    std::unique_ptr<TPFileReader> file;
+    std::vector<triggeralgs::TriggerPrimitive> text_tps;
+
+    const triggeralgs::TriggerPrimitive* begin() const { return file ? file->begin() : text_tps.data(); }
+    const triggeralgs::TriggerPrimitive* end() const { return file ? file->end() : text_tps.data() + text_tps.size(); }
+  };
+  std::shared_ptr<const TPSource> load_tps(const std::string& filename);
+
+  // One replayed link: TPSets are made from the TPs as they're sent
+  struct Stream
+  {
+    std::shared_ptr<const TPSource> tps;
+    uint16_t region_id;  // NOLINT(build/unsigned)
+    uint32_t element_id; // NOLINT(build/unsigned)
+    std::unique_ptr<appfwk::DAQSink<TPSet>> sink;
+  };
+
+  // Threading. Each worker replays the streams whose index modulo the
+  // number of workers is its own index
+  std::vector<std::unique_ptr<dunedaq::utilities::WorkerThread>> m_threads;
+  void do_work(std::atomic<bool>&, size_t thread_index);
+
+  // Sleep until `time`, checking the running flag every maximum_wait_time_us.
+  // Returns false if we were stopped first
+  bool wait_until(std::chrono::steady_clock::time_point time, std::atomic<bool>& running_flag) const;
 
   // Configuration
   triggerprimitivemaker::ConfParams m_conf;
-  std::unique_ptr<appfwk::DAQSink<TPSet>> m_tpset_sink;
-  std::vector<TPSet> m_tpsets;
+  std::string m_tpset_sink_instance;
+  std::vector<Stream> m_streams;
+
+  // The clock shared by all streams, so that TPSets from different streams
+  // are sent in data-time order. TPSet start time m_first_tpset_start_time
+  // is sent at m_run_start_time, and timestamps are shifted by
+  // m_input_duration on each loop over the input
+  uint64_t m_first_tpset_start_time; // NOLINT(build/unsigned)
+  uint64_t m_input_duration;         // NOLINT(build/unsigned)
+  std::chrono::steady_clock::time_point m_run_start_time;
 
   std::chrono::milliseconds m_queue_timeout;
+
+  // Opmon variables, summed over all the workers
+  using metric_counter_type = decltype(triggerprimitivemakerinfo::Info::tpset_sent_count);
+  std::atomic<metric_counter_type> m_tpset_sent_count{ 0 };
+  std::atomic<metric_counter_type> m_tp_sent_count{ 0 };
+  std::atomic<metric_counter_type> m_push_failed_count{ 0 };
 };
 } // namespace trigger
 } // namespace dunedaq
@@ -0,0 +1,309 @@
+/**
+ * @file TriggerTap.hpp TriggerTap is an appfwk::DAQModule that records the objects passing between two queues
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_PLUGINS_TRIGGERTAP_HPP_
+#define TRIGGER_PLUGINS_TRIGGERTAP_HPP_
+
+#include "trigger/InterruptibleSource.hpp"
+#include "trigger/Issues.hpp"
+#include "trigger/Set.hpp"
+#include "trigger/StopSignal.hpp"
+#include "trigger/TapFile.hpp"
+#include "trigger/triggertap/Nljs.hpp"
+#include "trigger/triggertapinfo/InfoNljs.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/DAQModuleHelper.hpp"
+#include "appfwk/DAQSink.hpp"
+#include "appfwk/DAQSource.hpp"
+#include "daqdataformats/Types.hpp"
+#include "logging/Logging.hpp"
+#include "serialization/Serialization.hpp"
+#include "triggeralgs/TriggerCandidate.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+// The times under which an object is indexed in a tap file
+template<class T>
+std::pair<daqdataformats::timestamp_t, daqdataformats::timestamp_t>
+tap_times(const Set<T>& set)
+{
+  return { set.start_time, set.end_time };
+}
+
+inline std::pair<daqdataformats::timestamp_t, daqdataformats::timestamp_t>
+tap_times(const triggeralgs::TriggerCandidate& tc)
+{
+  return { tc.time_start, tc.time_end };
+}
+
+/**
+ * @brief TriggerTap passes each object from its input queue to its output
+ * queue unchanged, and records a copy to a series of tap files, so that
+ * the real input to a maker or zipper can be replayed offline.
+ *
+ * Recording must not slow the data path down, so the data thread only
+ * copies each object into one of two buffers. A writer thread serializes
+ * and writes the other buffer. When both are full, objects are dropped
+ * from the recording, and counted, but are still sent on.
+ */
+template<class T>
+class TriggerTap : public dunedaq::appfwk::DAQModule
+{
+public:
+  using source_t = appfwk::DAQSource<T>;
+  using sink_t = appfwk::DAQSink<T>;
+  using cfg_t = triggertap::ConfParams;
+
+  explicit TriggerTap(const std::string& name)
+    : DAQModule(name)
+  {
+    // clang-format off
+    register_command("conf",  &TriggerTap<T>::do_configure);
+    register_command("start", &TriggerTap<T>::do_start);
+    register_command("stop",  &TriggerTap<T>::do_stop);
+    register_command("scrap", &TriggerTap<T>::do_scrap);
+    // clang-format on
+  }
+
+  TriggerTap(const TriggerTap&) = delete;
+  TriggerTap& operator=(const TriggerTap&) = delete;
+  TriggerTap(TriggerTap&&) = delete;
+  TriggerTap& operator=(TriggerTap&&) = delete;
+
+  void init(const nlohmann::json& ini) override
+  {
+    try {
+      m_input.reset(new source_t(appfwk::queue_inst(ini, "input")));
+    } catch (const ers::Issue& excpt) {
+      throw InvalidQueueFatalError(ERS_HERE, get_name(), "input", excpt);
+    }
+    try {
+      m_output.reset(new sink_t(appfwk::queue_inst(ini, "output")));
+    } catch (const ers::Issue& excpt) {
+      throw InvalidQueueFatalError(ERS_HERE, get_name(), "output", excpt);
+    }
+  }
+
+  void get_info(opmonlib::InfoCollector& ci, int /*level*/) override
+  {
+    triggertapinfo::Info i;
+    i.received_count = m_received_count.load();
+    i.sent_count = m_sent_count.load();
+    i.push_failed_count = m_push_failed_count.load();
+    i.recorded_count = m_recorded_count.load();
+    i.dropped_count = m_dropped_count.load();
+    i.bytes_written = m_bytes_written.load();
+    ci.add(i);
+  }
+
+private:
+  void do_configure(const nlohmann::json& obj)
+  {
+    m_cfg = obj.get<cfg_t>();
+    if (m_cfg.enabled && (m_cfg.buffer_size == 0 || m_cfg.max_file_size_mb == 0)) {
+      throw InvalidConfiguration(ERS_HERE);
+    }
+  }
+
+  void do_scrap(const nlohmann::json& /*obj*/) { m_cfg = cfg_t{}; }
+
+  void do_start(const nlohmann::json& obj)
+  {
+    m_received_count = 0;
+    m_sent_count = 0;
+    m_push_failed_count = 0;
+    m_recorded_count = 0;
+    m_dropped_count = 0;
+    m_bytes_written = 0;
+    m_stop_signal.reset();
+    m_filling.clear();
+    m_full.clear();
+    m_full_pending = false;
+    m_write_failed = false;
+
+    if (m_cfg.enabled) {
+      auto run_number = obj.value<dunedaq::daqdataformats::run_number_t>("run", 0);
+      m_file_writer.reset(new TapFileWriter(m_cfg.output_prefix + "_run" + std::to_string(run_number),
+                                            m_cfg.max_file_size_mb << 20,
+                                            m_cfg.max_files,
+                                            m_cfg.index_stride));
+      m_filling.reserve(m_cfg.buffer_size);
+      m_full.reserve(m_cfg.buffer_size);
+      m_writing = true;
+      m_write_thread = std::thread(&TriggerTap<T>::do_write, this);
+      pthread_setname_np(m_write_thread.native_handle(), "tap-write");
+    }
+    m_data_thread = std::thread(&TriggerTap<T>::do_work, this);
+    pthread_setname_np(m_data_thread.native_handle(), "tap-data");
+  }
+
+  void do_stop(const nlohmann::json& /*obj*/)
+  {
+    m_stop_signal.request_stop();
+    m_data_thread.join();
+    if (m_write_thread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lk(m_buffer_mutex);
+        m_writing = false;
+      }
+      m_buffer_cv.notify_one();
+      m_write_thread.join();
+      m_file_writer.reset();
+    }
+    TLOG() << get_name() << ": Received " << m_received_count << " objects, sent " << m_sent_count << ", recorded "
+           << m_recorded_count << " (" << m_bytes_written << " bytes). " << m_dropped_count
+           << " were dropped from the recording, and " << m_push_failed_count << " from the output";
+  }
+
+  // The data path: pass each object on, and copy it for recording
+  void do_work()
+  {
+    InterruptibleSource<T> input(*m_input, m_stop_signal);
+    const std::chrono::milliseconds queue_timeout(m_cfg.queue_timeout_ms);
+    while (true) {
+      T obj;
+      auto status = input.pop(obj, std::chrono::milliseconds(100));
+      if (status == InterruptibleSource<T>::Status::kStopped) {
+        break;
+      }
+      if (status == InterruptibleSource<T>::Status::kTimeout) {
+        continue;
+      }
+      ++m_received_count;
+      if (m_cfg.enabled) {
+        record(obj);
+      }
+      try {
+        m_output->push(std::move(obj), queue_timeout);
+        ++m_sent_count;
+      } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+        ers::warning(excpt);
+        ++m_push_failed_count;
+      }
+    }
+  }
+
+  // Copy `obj` into the filling buffer. If that's full, hand it to the
+  // writer thread and start on the other one, unless the writer hasn't
+  // finished with it yet, in which case `obj` is dropped
+  void record(const T& obj)
+  {
+    std::lock_guard<std::mutex> lk(m_buffer_mutex);
+    if (m_filling.size() >= m_cfg.buffer_size) {
+      if (m_full_pending) {
+        ++m_dropped_count;
+        return;
+      }
+      std::swap(m_filling, m_full);
+      m_full_pending = true;
+      m_buffer_cv.notify_one();
+    }
+    m_filling.push_back(obj);
+  }
+
+  // The writer thread. Writes each full buffer as it's handed over, and
+  // the partly full one every flush interval and at stop
+  void do_write()
+  {
+    std::vector<T> to_write;
+    to_write.reserve(m_cfg.buffer_size);
+    const std::chrono::milliseconds flush_interval(m_cfg.flush_interval_ms);
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lk(m_buffer_mutex);
+        m_buffer_cv.wait_for(lk, flush_interval, [this]() { return m_full_pending || !m_writing; });
+        if (m_full_pending) {
+          std::swap(to_write, m_full);
+          m_full_pending = false;
+        } else if (!m_filling.empty()) {
+          std::swap(to_write, m_filling);
+        } else if (!m_writing) {
+          break;
+        }
+      }
+      write(to_write);
+      to_write.clear();
+    }
+    try {
+      m_file_writer->close();
+      m_bytes_written = m_file_writer->get_bytes_written();
+    } catch (const BadTapFile& excpt) {
+      ers::error(excpt);
+    }
+  }
+
+  void write(const std::vector<T>& objs)
+  {
+    if (m_write_failed) {
+      m_dropped_count += objs.size();
+      return;
+    }
+    try {
+      for (const T& obj : objs) {
+        auto times = tap_times(obj);
+        auto bytes = dunedaq::serialization::serialize(obj, dunedaq::serialization::kMsgPack);
+        m_file_writer->write(times.first, times.second, reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        ++m_recorded_count;
+      }
+      m_bytes_written = m_file_writer->get_bytes_written();
+    } catch (const BadTapFile& excpt) {
+      // Keep taking buffers from the data thread, so that it never waits for us, but stop writing them
+      ers::error(excpt);
+      m_write_failed = true;
+      m_dropped_count += objs.size();
+    }
+  }
+
+  std::unique_ptr<source_t> m_input;
+  std::unique_ptr<sink_t> m_output;
+  cfg_t m_cfg;
+
+  std::thread m_data_thread;
+  std::thread m_write_thread;
+  StopSignal m_stop_signal;
+
+  // The data thread fills m_filling. When it's full, it's swapped with
+  // m_full, and m_full_pending is set until the writer thread takes it
+  std::mutex m_buffer_mutex;
+  std::condition_variable m_buffer_cv;
+  std::vector<T> m_filling;
+  std::vector<T> m_full;
+  bool m_full_pending{ false };
+  bool m_writing{ false };
+
+  // Only used by the writer thread
+  std::unique_ptr<TapFileWriter> m_file_writer;
+  bool m_write_failed{ false };
+
+  // Opmon variables
+  using metric_counter_type = decltype(triggertapinfo::Info::received_count);
+  std::atomic<metric_counter_type> m_received_count{ 0 };
+  std::atomic<metric_counter_type> m_sent_count{ 0 };
+  std::atomic<metric_counter_type> m_push_failed_count{ 0 };
+  std::atomic<metric_counter_type> m_recorded_count{ 0 };
+  std::atomic<metric_counter_type> m_dropped_count{ 0 };
+  std::atomic<metric_counter_type> m_bytes_written{ 0 };
+};
+
+} // namespace dunedaq::trigger
+
+/// Need one of these in a .cpp for each concrete T
+// DEFINE_DUNE_DAQ_MODULE(dunedaq::trigger::TriggerTap<T>)
+
+#endif // TRIGGER_PLUGINS_TRIGGERTAP_HPP_
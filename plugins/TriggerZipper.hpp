@@ -9,7 +9,9 @@
 #ifndef TRIGGER_PLUGINS_TRIGGERZIPPER_HPP_
 #define TRIGGER_PLUGINS_TRIGGERZIPPER_HPP_
 
+#include "trigger/InterruptibleSource.hpp"
 #include "trigger/Issues.hpp"
+#include "trigger/StopSignal.hpp"
 #include "trigger/triggerzipper/Nljs.hpp"
 #include "zipper.hpp"
 
@@ -21,7 +23,9 @@
 #include "daqdataformats/GeoID.hpp"
 #include <logging/Logging.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -78,6 +82,7 @@ public:
 
   std::thread m_thread;
   std::atomic<bool> m_running{ false };
+  StopSignal m_stop_signal;
 
   // We store input TSETs in a list and send iterator though the
   // zipper as payload so as to not suffer copy overhead.
@@ -89,6 +94,20 @@ public:
   size_t m_n_tardy{ 0 };
   std::map<daqdataformats::GeoID, size_t> m_tardy_counts;
 
+  // When coalescing heartbeats, input heartbeats aren't sent on. Instead,
+  // each one updates its stream's guaranteed time, and a heartbeat is sent
+  // for the smallest guaranteed time across streams whenever that advances
+  struct HeartbeatStream
+  {
+    ordering_type guaranteed{ 0 };
+    std::chrono::steady_clock::time_point last_seen;
+  };
+  std::map<identity_type, HeartbeatStream> m_heartbeat_streams;
+  std::chrono::steady_clock::time_point m_start_time;
+  ordering_type m_watermark{ 0 };
+  size_t m_n_heartbeats_received{ 0 };
+  size_t m_n_heartbeats_sent{ 0 };
+
   explicit TriggerZipper(const std::string& name)
     : DAQModule(name)
     , m_zm()
@@ -128,17 +147,27 @@ public:
     m_n_sent = 0;
     m_n_tardy = 0;
     m_tardy_counts.clear();
+    m_heartbeat_streams.clear();
+    m_start_time = std::chrono::steady_clock::now();
+    m_watermark = 0;
+    m_n_heartbeats_received = 0;
+    m_n_heartbeats_sent = 0;
     m_running.store(true);
+    m_stop_signal.reset();
     m_thread = std::thread(&TriggerZipper::worker, this);
   }
 
   void do_stop(const nlohmann::json& /*stopobj*/)
   {
     m_running.store(false);
+    m_stop_signal.request_stop();
     m_thread.join();
     flush();
     m_zm.clear();
     TLOG() << "Received " << m_n_received << " Sets. Sent " << m_n_sent << " Sets. " << m_n_tardy << " were tardy";
+    if (m_cfg.coalesce_heartbeats) {
+      TLOG() << "Coalesced " << m_n_heartbeats_received << " input heartbeats into " << m_n_heartbeats_sent;
+    }
     std::stringstream ss;
     ss << std::endl;
     for (auto& [id, n] : m_tardy_counts) {
@@ -150,32 +179,45 @@ public:
   // thread worker
   void worker()
   {
+    // With a latency bound we need to wake up regularly to drain the zipper
+    // even when no input arrives. Without one, only input can make the
+    // zipper produce output
+    using input_t = InterruptibleSource<TSET>;
+    const std::chrono::milliseconds timeout(m_cfg.max_latency_ms ? 10 : 100);
+    input_t input(*m_inq, m_stop_signal);
+
+    // Once we've received a stop command, keep reading the input
+    // queue until there's nothing left on it
     while (true) {
-      // Once we've received a stop command, keep reading the input
-      // queue until there's nothing left on it
-      if (!proc_one() && !m_running.load()) {
-        break;
+      m_cache.emplace_front(); // to be filled
+      auto status = input.pop(m_cache.front(), timeout);
+      if (status != input_t::Status::kData) {
+        m_cache.pop_front(); // vestigial
+        drain();
+        if (status == input_t::Status::kStopped) {
+          break;
+        }
+        continue;
       }
+      proc_one();
     }
   }
 
-  bool proc_one()
+  // Feed the set at the front of the cache to the zipper
+  void proc_one()
   {
-    m_cache.emplace_front(); // to be filled
     auto& tset = m_cache.front();
-    try {
-      m_inq->pop(tset, std::chrono::milliseconds(10));
-      ++m_n_received;
-    } catch (appfwk::QueueTimeoutExpired&) {
-      m_cache.pop_front(); // vestigial
-      drain();
-      return false;
-    }
+    ++m_n_received;
 
     if (!m_tardy_counts.count(tset.origin))
       m_tardy_counts[tset.origin] = 0;
 
-    bool accepted = m_zm.feed(m_cache.begin(), tset.start_time, zipper_stream_id(tset.origin));
+    auto stream_id = zipper_stream_id(tset.origin);
+    if (m_cfg.coalesce_heartbeats) {
+      m_heartbeat_streams[stream_id].last_seen = std::chrono::steady_clock::now();
+    }
+
+    bool accepted = m_zm.feed(m_cache.begin(), tset.start_time, stream_id);
 
     if (!accepted) {
       ++m_n_tardy;
@@ -186,7 +228,6 @@ public:
       m_cache.pop_front(); // vestigial
     }
     drain();
-    return true;
   }
 
   void send_out(std::vector<node_type>& got)
@@ -195,6 +236,12 @@ public:
       payload_type lit = node.payload;
       auto& tset = *lit; // list iterator
 
+      if (m_cfg.coalesce_heartbeats && tset.type == TSET::Type::kHeartbeat && !advance_watermark(node, tset)) {
+        // heartbeat is absorbed
+        m_cache.erase(lit);
+        continue;
+      }
+
       // tell consumer "where" the set was produced
       tset.origin.region_id = m_cfg.region_id;
       tset.origin.element_id = m_cfg.element_id;
@@ -213,6 +260,42 @@ public:
     }
   }
 
+  // Record the heartbeat `tset` from `node`'s stream. Returns true, having
+  // set `tset`'s times to the new watermark, if the watermark advanced.
+  // Nodes come out of the zipper in time order, so every set before the
+  // watermark has already been sent by the time it advances
+  bool advance_watermark(const node_type& node, TSET& tset)
+  {
+    ++m_n_heartbeats_received;
+    auto& stream = m_heartbeat_streams[node.identity];
+    stream.guaranteed = std::max(stream.guaranteed, node.ordering);
+
+    // With a latency bound, the zipper stops waiting for streams that have
+    // gone quiet, so don't let them hold the watermark back either. That
+    // includes streams not heard from at all since the start. Without one,
+    // wait until every stream has been heard from
+    auto now = std::chrono::steady_clock::now();
+    const std::chrono::milliseconds max_latency(m_cfg.max_latency_ms);
+    if (m_heartbeat_streams.size() < m_cfg.cardinality && (!m_cfg.max_latency_ms || now - m_start_time < max_latency)) {
+      return false;
+    }
+    ordering_type watermark = std::numeric_limits<ordering_type>::max();
+    for (auto const& [id, hb_stream] : m_heartbeat_streams) {
+      if (m_cfg.max_latency_ms && id != node.identity && now - hb_stream.last_seen > max_latency) {
+        continue;
+      }
+      watermark = std::min(watermark, hb_stream.guaranteed);
+    }
+    if (watermark <= m_watermark) {
+      return false;
+    }
+    m_watermark = watermark;
+    tset.start_time = watermark;
+    tset.end_time = watermark;
+    ++m_n_heartbeats_sent;
+    return true;
+  }
+
   // Maybe drain and send to out queue
   void drain()
   {
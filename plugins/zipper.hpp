@@ -130,6 +130,7 @@ public:
     drain_full(std::back_inserter(got));
     streams.clear();
     origin = 0;
+    first_seen = timepoint_t::min();
   }
 
   /**
@@ -144,6 +145,9 @@ public:
     if (node.ordering < origin) {
       return false;
     }
+    if (streams.empty()) {
+      first_seen = node.debut;
+    }
     auto& s = streams[node.identity];
     s.occupancy += 1;
     s.last_seen = node.debut;
@@ -308,7 +312,14 @@ public:
       ++completeness;
     }
 
-    return completeness >= cardinality;
+    if (completeness >= cardinality) {
+      return true;
+    }
+
+    // Every stream seen so far is represented or stale. Streams never
+    // seen at all are stale too once the latency has passed since the
+    // first node was fed.
+    return latency != duration_t::zero() && now != timepoint_t::min() && now - first_seen >= latency;
   }
 
 private:
@@ -321,6 +332,7 @@ private:
     timepoint_t last_seen{ duration_t::min() };
   };
   std::unordered_map<identity_t, Stream> streams;
+  timepoint_t first_seen{ timepoint_t::min() };
 };
 
 } // namespace zipper
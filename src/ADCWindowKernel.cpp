@@ -0,0 +1,177 @@
+/**
+ * @file ADCWindowKernel.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/ADCWindowKernel.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TRIGGER_ADCWINDOW_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define TRIGGER_ADCWINDOW_HAVE_AVX2 0
+#endif
+
+namespace dunedaq::trigger::adcwindow {
+
+namespace {
+
+// How far to scan linearly before switching to a binary search. Windows are
+// usually only a handful of primitives long, so the answer is usually close
+constexpr size_t s_linear_search_length = 32;
+
+void
+prefix_sum_scalar(const uint32_t* adc, size_t n, uint64_t* prefix) // NOLINT(build/unsigned)
+{
+  for (size_t i = 0; i < n; ++i) {
+    prefix[i + 1] = prefix[i] + adc[i];
+  }
+}
+
+size_t
+find_first_at_least_scalar(const uint64_t* times, size_t from, size_t to, uint64_t value) // NOLINT(build/unsigned)
+{
+  size_t linear_end = std::min(to, from + s_linear_search_length);
+  for (size_t i = from; i < linear_end; ++i) {
+    if (times[i] >= value) {
+      return i;
+    }
+  }
+  return std::lower_bound(times + linear_end, times + to, value) - times;
+}
+
+#if TRIGGER_ADCWINDOW_HAVE_AVX2
+
+__attribute__((target("avx2"))) void
+prefix_sum_avx2(const uint32_t* adc, size_t n, uint64_t* prefix) // NOLINT(build/unsigned)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i carry = _mm256_set1_epi64x(static_cast<int64_t>(prefix[0]));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    // Widen four 32-bit ADC sums to 64 bits, then do an in-register
+    // inclusive scan: x += x shifted by one lane, then by two lanes
+    __m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(adc + i)));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), zero, 0x03));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x40), zero, 0x0f));
+    x = _mm256_add_epi64(x, carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(prefix + i + 1), x);
+    // Broadcast the last lane to carry into the next block
+    carry = _mm256_permute4x64_epi64(x, 0xff);
+  }
+  prefix_sum_scalar(adc + i, n - i, prefix + i);
+}
+
+__attribute__((target("avx2"))) size_t
+find_first_at_least_avx2(const uint64_t* times, size_t from, size_t to, uint64_t value) // NOLINT(build/unsigned)
+{
+  // AVX2 only has signed 64-bit comparisons, so flip the sign bits to
+  // compare unsigned values
+  const __m256i bias = _mm256_set1_epi64x(static_cast<int64_t>(0x8000000000000000ULL));
+  // times[i] >= value  <=>  !(value > times[i])
+  const __m256i v = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(value)), bias);
+
+  size_t linear_end = std::min(to, from + s_linear_search_length);
+  size_t i = from;
+  for (; i + 4 <= linear_end; i += 4) {
+    __m256i t = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(times + i)), bias);
+    int below = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, t)));
+    if (below != 0xf) {
+      // Times are sorted, so the first lane that isn't below `value` is the answer
+      return i + __builtin_ctz(~below & 0xf);
+    }
+  }
+  for (; i < linear_end; ++i) {
+    if (times[i] >= value) {
+      return i;
+    }
+  }
+  return std::lower_bound(times + linear_end, times + to, value) - times;
+}
+
+#endif
+
+} // namespace
+
+bool
+simd_available()
+{
+#if TRIGGER_ADCWINDOW_HAVE_AVX2
+  static const bool s_available = __builtin_cpu_supports("avx2");
+  return s_available;
+#else
+  return false;
+#endif
+}
+
+void
+prefix_sum(const uint32_t* adc, size_t n, uint64_t* prefix, bool use_simd) // NOLINT(build/unsigned)
+{
+#if TRIGGER_ADCWINDOW_HAVE_AVX2
+  if (use_simd && simd_available()) {
+    prefix_sum_avx2(adc, n, prefix);
+    return;
+  }
+#endif
+  (void)use_simd;
+  prefix_sum_scalar(adc, n, prefix);
+}
+
+size_t
+find_first_at_least(const uint64_t* times, size_t from, size_t to, uint64_t value, bool use_simd) // NOLINT(build/unsigned)
+{
+#if TRIGGER_ADCWINDOW_HAVE_AVX2
+  if (use_simd && simd_available()) {
+    return find_first_at_least_avx2(times, from, to, value);
+  }
+#endif
+  (void)use_simd;
+  return find_first_at_least_scalar(times, from, to, value);
+}
+
+size_t
+scan(const uint64_t* times,  // NOLINT(build/unsigned)
+     const uint64_t* prefix, // NOLINT(build/unsigned)
+     size_t begin,
+     size_t first,
+     size_t n,
+     uint64_t window_length, // NOLINT(build/unsigned)
+     uint64_t threshold,     // NOLINT(build/unsigned)
+     bool use_simd,
+     std::vector<Window>& windows)
+{
+  size_t current = first;
+  while (current < n) {
+    if (begin == current) {
+      // Empty window: the current primitive starts a new one
+      ++current;
+      continue;
+    }
+
+    // Every primitive that starts within window_length of the start of the
+    // window is simply added to it, so skip straight to the first one that
+    // doesn't fit
+    current = find_first_at_least(times, current, n, times[begin] + window_length, use_simd);
+    if (current == n) {
+      break;
+    }
+
+    if (prefix[current] - prefix[begin] > threshold) {
+      windows.push_back(Window{ begin, current });
+      begin = current;
+    } else {
+      // Drop primitives from the front of the window until the current one
+      // fits. This can empty the window, leaving just the current primitive
+      begin = find_first_at_least(times, begin, current, times[current] - window_length + 1, use_simd);
+    }
+    ++current;
+  }
+  return begin;
+}
+
+} // namespace dunedaq::trigger::adcwindow
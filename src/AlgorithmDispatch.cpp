@@ -0,0 +1,28 @@
+/**
+ * @file AlgorithmDispatch.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/AlgorithmDispatch.hpp"
+
+namespace dunedaq::trigger {
+
+template<class BASE, class A, class B>
+SliceProcessorRegistry<BASE, A, B>&
+SliceProcessorRegistry<BASE, A, B>::get()
+{
+  static SliceProcessorRegistry s_registry;
+  return s_registry;
+}
+
+template class SliceProcessorRegistry<triggeralgs::TriggerActivityMaker,
+                                      triggeralgs::TriggerPrimitive,
+                                      triggeralgs::TriggerActivity>;
+template class SliceProcessorRegistry<triggeralgs::TriggerCandidateMaker,
+                                      triggeralgs::TriggerActivity,
+                                      triggeralgs::TriggerCandidate>;
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,142 @@
+/**
+ * @file ChannelRateMasker.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/ChannelRateMasker.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+void
+ChannelRateMasker::configure(const Config& config)
+{
+  m_config = config;
+  m_config.rate_interval = std::max<triggeralgs::timestamp_t>(m_config.rate_interval, 1);
+  m_config.clock_frequency_hz = std::max<uint64_t>(m_config.clock_frequency_hz, 1); // NOLINT(build/unsigned)
+
+  // Number of TPs in one bin that corresponds to the maximum rate
+  m_max_count = 0;
+  if (m_config.max_rate_hz > 0) {
+    double max_count = m_config.max_rate_hz * m_config.rate_interval / m_config.clock_frequency_hz;
+    m_max_count = std::max<uint64_t>(static_cast<uint64_t>(max_count), 1); // NOLINT(build/unsigned)
+  }
+
+  m_channels.clear();
+  m_sparse_channels.clear();
+  m_masked.clear();
+  m_n_passed = 0;
+  m_n_dropped = 0;
+  m_n_mask_events = 0;
+  update_snapshot();
+}
+
+void
+ChannelRateMasker::operator()(const triggeralgs::TriggerPrimitive& input,
+                              std::vector<triggeralgs::TriggerPrimitive>& output)
+{
+  if (m_max_count == 0) {
+    output.push_back(input);
+    ++m_n_passed;
+    return;
+  }
+
+  const triggeralgs::timestamp_t time = input.time_start;
+  ChannelState& ch = state(input.channel);
+  roll(ch, time);
+  ++ch.count;
+
+  if (ch.masked && (time < ch.masked_until || end_cooldown(input.channel, ch, time))) {
+    ++m_n_dropped;
+    return;
+  }
+
+  if (ch.count > m_max_count) {
+    ch.masked = true;
+    ch.masked_until = time + m_config.cooldown;
+    m_masked.push_back(input.channel);
+    ++m_n_mask_events;
+    ++m_n_dropped;
+    update_snapshot();
+    return;
+  }
+
+  output.push_back(input);
+  ++m_n_passed;
+}
+
+void
+ChannelRateMasker::flush(triggeralgs::timestamp_t time, std::vector<triggeralgs::TriggerPrimitive>& /*output*/)
+{
+  if (m_masked.empty()) {
+    return;
+  }
+  for (channel_t channel : std::vector<channel_t>(m_masked)) {
+    ChannelState& ch = state(channel);
+    if (ch.masked && time >= ch.masked_until) {
+      roll(ch, time);
+      end_cooldown(channel, ch, time);
+    }
+  }
+  update_snapshot();
+}
+
+std::vector<ChannelRateMasker::MaskedChannel>
+ChannelRateMasker::get_masked_channels() const
+{
+  std::lock_guard<std::mutex> lk(m_snapshot_mutex);
+  return m_snapshot;
+}
+
+void
+ChannelRateMasker::roll(ChannelState& state, triggeralgs::timestamp_t time) const
+{
+  const uint64_t bin = time / m_config.rate_interval; // NOLINT(build/unsigned)
+  if (bin != state.bin) {
+    // A gap of more than one bin means the last full bin was empty
+    state.last_count = (bin == state.bin + 1) ? state.count : 0;
+    state.count = 0;
+    state.bin = bin;
+  }
+}
+
+double
+ChannelRateMasker::rate_hz(const ChannelState& state) const
+{
+  return static_cast<double>(std::max(state.last_count, state.count)) * m_config.clock_frequency_hz /
+         m_config.rate_interval;
+}
+
+bool
+ChannelRateMasker::end_cooldown(channel_t channel, ChannelState& state, triggeralgs::timestamp_t time)
+{
+  if (std::max(state.last_count, state.count) > m_max_count) {
+    // Still noisy: go round again
+    state.masked_until = time + m_config.cooldown;
+    return true;
+  }
+  state.masked = false;
+  m_masked.erase(std::remove(m_masked.begin(), m_masked.end(), channel), m_masked.end());
+  update_snapshot();
+  return false;
+}
+
+void
+ChannelRateMasker::update_snapshot()
+{
+  std::vector<MaskedChannel> snapshot;
+  snapshot.reserve(m_masked.size());
+  for (channel_t channel : m_masked) {
+    const ChannelState& ch = state(channel);
+    snapshot.push_back(MaskedChannel{ channel, rate_hz(ch), ch.masked_until });
+  }
+  std::lock_guard<std::mutex> lk(m_snapshot_mutex);
+  m_snapshot.swap(snapshot);
+}
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,109 @@
+/**
+ * @file DecisionWindowIndex.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/DecisionWindowIndex.hpp"
+
+#include <algorithm>
+
+namespace dunedaq::trigger {
+
+void
+DecisionWindowIndex::expire(std::deque<Window>& windows, daqdataformats::timestamp_t begin) const
+{
+  if (begin < m_history_ticks) {
+    return;
+  }
+  const daqdataformats::timestamp_t cutoff = begin - m_history_ticks;
+  windows.erase(std::remove_if(windows.begin(), windows.end(), [cutoff](const Window& w) { return w.end < cutoff; }),
+                windows.end());
+}
+
+DecisionWindowIndex::Result
+DecisionWindowIndex::apply(std::vector<daqdataformats::ComponentRequest>& components)
+{
+  if (!enabled() || components.empty()) {
+    return Result::kNew;
+  }
+
+  bool changed = false;
+  for (auto it = components.begin(); it != components.end();) {
+    auto windows_it = m_windows.find(it->component);
+    if (windows_it == m_windows.end()) {
+      ++it;
+      continue;
+    }
+    auto& windows = windows_it->second;
+    expire(windows, it->window_begin);
+
+    // Trimming against one window can create an overlap with another that
+    // we've already looked at, so go round until nothing changes
+    bool covered = false;
+    bool trimmed = true;
+    while (trimmed && !covered) {
+      trimmed = false;
+      for (auto const& w : windows) {
+        if (w.end <= it->window_begin || w.begin >= it->window_end) {
+          // No overlap
+          continue;
+        }
+        if (w.begin <= it->window_begin && w.end >= it->window_end) {
+          covered = true;
+          break;
+        }
+        if (w.begin <= it->window_begin) {
+          // Overlaps the start of the request
+          it->window_begin = w.end;
+          trimmed = true;
+        } else if (w.end >= it->window_end) {
+          // Overlaps the end of the request
+          it->window_end = w.begin;
+          trimmed = true;
+        }
+        // Otherwise the recorded window is strictly inside the request, and we keep the whole request
+      }
+      changed |= trimmed;
+    }
+
+    if (covered) {
+      it = components.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
+
+  if (components.empty()) {
+    return Result::kMerged;
+  }
+  return changed ? Result::kTrimmed : Result::kNew;
+}
+
+void
+DecisionWindowIndex::record(const std::vector<daqdataformats::ComponentRequest>& components)
+{
+  if (!enabled()) {
+    return;
+  }
+  for (auto const& request : components) {
+    auto& windows = m_windows[request.component];
+    expire(windows, request.window_begin);
+    windows.push_back(Window{ request.window_begin, request.window_end });
+  }
+}
+
+size_t
+DecisionWindowIndex::get_n_windows() const
+{
+  size_t n = 0;
+  for (auto const& [link, windows] : m_windows) {
+    n += windows.size();
+  }
+  return n;
+}
+
+} // namespace dunedaq::trigger
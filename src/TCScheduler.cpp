@@ -0,0 +1,244 @@
+/**
+ * @file TCScheduler.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCScheduler.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+void
+TCScheduler::configure(const std::map<tc_type_t, TypeConfig>& type_configs,
+                       size_t max_pending,
+                       std::chrono::milliseconds pending_timeout)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_type_configs = type_configs;
+  m_max_pending = max_pending;
+  m_pending_timeout = pending_timeout;
+  m_type_states.clear();
+  m_pending.clear();
+  m_n_pending = 0;
+}
+
+void
+TCScheduler::reset()
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_type_states.clear();
+  m_pending.clear();
+  m_n_pending = 0;
+}
+
+TCScheduler::TypeState&
+TCScheduler::state_for(tc_type_t type)
+{
+  auto it = m_type_states.find(type);
+  if (it == m_type_states.end()) {
+    TypeState state;
+    auto conf_it = m_type_configs.find(type);
+    if (conf_it != m_type_configs.end()) {
+      state.config = conf_it->second;
+    }
+    // Start with a full bucket
+    state.tokens = static_cast<double>(std::max<uint64_t>(state.config.burst, 1)); // NOLINT(build/unsigned)
+    state.last_refill = clock_t::now();
+    it = m_type_states.emplace(type, state).first;
+  }
+  return it->second;
+}
+
+bool
+TCScheduler::take_token(TypeState& state, clock_t::time_point now)
+{
+  if (state.config.rate_limit_hz <= 0) {
+    return true;
+  }
+  const double depth = static_cast<double>(std::max<uint64_t>(state.config.burst, 1)); // NOLINT(build/unsigned)
+  if (now > state.last_refill) {
+    std::chrono::duration<double> elapsed = now - state.last_refill;
+    state.tokens = std::min(depth, state.tokens + elapsed.count() * state.config.rate_limit_hz);
+    state.last_refill = now;
+  }
+  if (state.tokens >= 1.0) {
+    state.tokens -= 1.0;
+    return true;
+  }
+  return false;
+}
+
+bool
+TCScheduler::add(const triggeralgs::TriggerCandidate& tc, clock_t::time_point now)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  TypeState& state = state_for(tc.type);
+
+  // Prescale first, so that prescaled-away candidates don't use up tokens
+  const uint64_t prescale = std::max<uint64_t>(state.config.prescale, 1); // NOLINT(build/unsigned)
+  if (state.n_seen++ % prescale != 0 || !take_token(state, now)) {
+    ++state.counters.dropped;
+    return false;
+  }
+
+  m_pending[state.config.priority].push_back(Pending{ tc, now });
+  ++m_n_pending;
+  return true;
+}
+
+bool
+TCScheduler::next(triggeralgs::TriggerCandidate& tc,
+                  clock_t::time_point now,
+                  const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed)
+{
+  std::vector<triggeralgs::TriggerCandidate> shed_tcs;
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    while (!found && !m_pending.empty()) {
+      auto level = m_pending.begin();
+      Pending p = std::move(level->second.front());
+      level->second.pop_front();
+      if (level->second.empty()) {
+        m_pending.erase(level);
+      }
+      --m_n_pending;
+
+      if (expired(p, now)) {
+        shed_tcs.push_back(std::move(p.tc));
+      } else {
+        tc = std::move(p.tc);
+        found = true;
+      }
+    }
+    count_shed(shed_tcs);
+  }
+
+  report_shed(shed_tcs, on_shed);
+  return found;
+}
+
+size_t
+TCScheduler::shed(size_t depth,
+                  clock_t::time_point now,
+                  const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed)
+{
+  return shed_pending(depth, now, on_shed);
+}
+
+size_t
+TCScheduler::shed_to_limit(clock_t::time_point now,
+                           const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed)
+{
+  return shed_pending(std::nullopt, now, on_shed);
+}
+
+size_t
+TCScheduler::shed_pending(std::optional<size_t> depth,
+                          clock_t::time_point now,
+                          const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed)
+{
+  std::vector<triggeralgs::TriggerCandidate> shed_tcs;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    const size_t max_pending = depth.value_or(m_max_pending);
+
+    // Timed-out candidates go first, whatever their priority
+    if (m_pending_timeout.count() > 0) {
+      for (auto level = m_pending.begin(); level != m_pending.end();) {
+        auto& queue = level->second;
+        while (!queue.empty() && expired(queue.front(), now)) {
+          shed_tcs.push_back(std::move(queue.front().tc));
+          queue.pop_front();
+          --m_n_pending;
+        }
+        level = queue.empty() ? m_pending.erase(level) : std::next(level);
+      }
+    }
+
+    // Then the lowest priority, oldest first
+    while (m_n_pending > max_pending) {
+      auto level = std::prev(m_pending.end());
+      shed_tcs.push_back(std::move(level->second.front().tc));
+      level->second.pop_front();
+      if (level->second.empty()) {
+        m_pending.erase(level);
+      }
+      --m_n_pending;
+    }
+
+    count_shed(shed_tcs);
+  }
+
+  report_shed(shed_tcs, on_shed);
+  return shed_tcs.size();
+}
+
+void
+TCScheduler::count_shed(const std::vector<triggeralgs::TriggerCandidate>& shed_tcs)
+{
+  for (auto const& tc : shed_tcs) {
+    ++state_for(tc.type).counters.dropped;
+  }
+}
+
+void
+TCScheduler::report_shed(const std::vector<triggeralgs::TriggerCandidate>& shed_tcs,
+                         const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed)
+{
+  if (on_shed) {
+    for (auto const& tc : shed_tcs) {
+      on_shed(tc);
+    }
+  }
+}
+
+void
+TCScheduler::accepted(tc_type_t type)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  ++state_for(type).counters.accepted;
+}
+
+void
+TCScheduler::merged(tc_type_t type)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  ++state_for(type).counters.merged;
+}
+
+void
+TCScheduler::dropped(tc_type_t type)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  ++state_for(type).counters.dropped;
+}
+
+size_t
+TCScheduler::get_n_pending() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_n_pending;
+}
+
+std::map<TCScheduler::tc_type_t, TCScheduler::TypeCounters>
+TCScheduler::get_counters() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  std::map<tc_type_t, TypeCounters> ret;
+  for (auto const& [type, state] : m_type_states) {
+    ret[type] = state.counters;
+  }
+  return ret;
+}
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,123 @@
+/**
+ * @file TPFile.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPFile.hpp"
+
+#include "trigger/Issues.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using triggeralgs::TriggerPrimitive;
+
+namespace dunedaq::trigger {
+
+bool
+read_tp_text(std::istream& in, TriggerPrimitive& tp)
+{
+  return static_cast<bool>(in >> tp.time_start >> tp.time_over_threshold >> tp.time_peak >> tp.channel >>
+                           tp.adc_integral >> tp.adc_peak >> tp.detid >> tp.type);
+}
+
+void
+write_tp_file(const std::string& filename, const std::vector<TriggerPrimitive>& tps)
+{
+  TPFileHeader header;
+  header.tp_size = sizeof(TriggerPrimitive);
+  header.n_tps = tps.size();
+
+  for (size_t i = 1; i < tps.size(); ++i) {
+    if (tps[i].time_start < tps[i - 1].time_start) {
+      throw BadTPFile(ERS_HERE, filename, "TPs are not sorted by time_start at position " + std::to_string(i));
+    }
+  }
+
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw BadTPFile(ERS_HERE, filename, "could not open for writing");
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));                          // NOLINT
+  out.write(reinterpret_cast<const char*>(tps.data()), tps.size() * sizeof(TriggerPrimitive)); // NOLINT
+  out.close();
+  if (!out) {
+    throw BadTPFile(ERS_HERE, filename, "write failed");
+  }
+}
+
+TPFileReader::TPFileReader(const std::string& filename)
+  : m_filename(filename)
+{
+  m_fd = ::open(filename.c_str(), O_RDONLY); // NOLINT
+  if (m_fd < 0) {
+    throw BadTPFile(ERS_HERE, filename, std::strerror(errno));
+  }
+
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TPFileHeader)) {
+    ::close(m_fd);
+    throw BadTPFile(ERS_HERE, filename, "file is too short to contain a header");
+  }
+  m_map_size = st.st_size;
+
+  m_map = ::mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (m_map == MAP_FAILED) { // NOLINT
+    std::string reason = std::strerror(errno);
+    ::close(m_fd);
+    throw BadTPFile(ERS_HERE, filename, "mmap failed: " + reason);
+  }
+  // TPs are replayed front to back, so let the kernel read ahead
+  ::madvise(m_map, m_map_size, MADV_SEQUENTIAL);
+
+  auto base = static_cast<const char*>(m_map);
+  m_header = reinterpret_cast<const TPFileHeader*>(base); // NOLINT
+
+  std::string reason;
+  if (m_header->magic != TPFileHeader::s_magic) {
+    reason = "not a binary TP file";
+  } else if (m_header->version != TPFileHeader::s_version) {
+    reason = "unsupported version " + std::to_string(m_header->version);
+  } else if (m_header->tp_size != sizeof(TriggerPrimitive)) {
+    reason = "TPs are " + std::to_string(m_header->tp_size) + " bytes, but this build's are " +
+             std::to_string(sizeof(TriggerPrimitive));
+  } else if (m_header->n_tps > (m_map_size - sizeof(TPFileHeader)) / sizeof(TriggerPrimitive)) {
+    // Compare the count, rather than its size in bytes, which could overflow
+    reason = "file is truncated";
+  }
+  if (!reason.empty()) {
+    ::munmap(m_map, m_map_size);
+    ::close(m_fd);
+    throw BadTPFile(ERS_HERE, filename, reason);
+  }
+
+  m_tps = reinterpret_cast<const TriggerPrimitive*>(base + sizeof(TPFileHeader)); // NOLINT
+}
+
+TPFileReader::~TPFileReader()
+{
+  ::munmap(m_map, m_map_size);
+  ::close(m_fd);
+}
+
+bool
+TPFileReader::is_tp_file(const std::string& filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  uint64_t magic = 0; // NOLINT(build/unsigned)
+  in.read(reinterpret_cast<char*>(&magic), sizeof(magic)); // NOLINT
+  return in && magic == TPFileHeader::s_magic;
+}
+
+} // namespace dunedaq::trigger
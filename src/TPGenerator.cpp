@@ -0,0 +1,167 @@
+/**
+ * @file TPGenerator.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPGenerator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using triggeralgs::timestamp_t;
+using triggeralgs::TriggerPrimitive;
+
+namespace dunedaq::trigger {
+
+namespace {
+bool
+earlier(const TriggerPrimitive& a, const TriggerPrimitive& b)
+{
+  return a.time_start < b.time_start;
+}
+} // namespace
+
+void
+TPGenerator::configure(const Config& config, timestamp_t start_time)
+{
+  m_config = config;
+  m_config.n_channels = std::max<channel_t>(m_config.n_channels, 1);
+  m_config.track_length_channels = std::clamp<channel_t>(m_config.track_length_channels, 1, m_config.n_channels);
+  m_config.burst_n_channels = std::clamp<channel_t>(m_config.burst_n_channels, 1, m_config.n_channels);
+
+  m_noise_gen.seed(m_config.seed);
+  m_track_gen.seed(m_config.seed + 1);
+  m_burst_gen.seed(m_config.seed + 2);
+  m_start_time = start_time;
+  m_current_time = start_time;
+  m_pending.clear();
+
+  auto interval = [this](double rate_hz) { return rate_hz > 0 ? m_config.clock_frequency_hz / rate_hz : 0; };
+  m_noise_interval = interval(m_config.noise_rate_hz * m_config.n_channels);
+  m_track_interval = interval(m_config.track_rate_hz);
+  m_burst_interval = interval(m_config.burst_rate_hz);
+
+  std::exponential_distribution<double> exp_dist(1.0);
+  auto first_arrival = [&](double mean_interval, std::mt19937_64& gen) {
+    return mean_interval > 0 ? exp_dist(gen) * mean_interval : std::numeric_limits<double>::infinity();
+  };
+  m_next_noise = first_arrival(m_noise_interval, m_noise_gen);
+  m_next_track = first_arrival(m_track_interval, m_track_gen);
+  m_next_burst = first_arrival(m_burst_interval, m_burst_gen);
+}
+
+double
+TPGenerator::get_expected_n_tps(timestamp_t duration) const
+{
+  double duration_s = static_cast<double>(duration) / m_config.clock_frequency_hz;
+  return duration_s * (std::max(m_config.noise_rate_hz, 0.) * m_config.n_channels +
+                       std::max(m_config.track_rate_hz, 0.) * m_config.track_length_channels +
+                       std::max(m_config.burst_rate_hz, 0.) * m_config.burst_n_tps);
+}
+
+TriggerPrimitive
+TPGenerator::make_tp(timestamp_t time,
+                     channel_t channel,
+                     uint32_t adc_peak, // NOLINT(build/unsigned)
+                     timestamp_t time_over_threshold) const
+{
+  TriggerPrimitive tp;
+  tp.time_start = time;
+  tp.time_over_threshold = time_over_threshold;
+  tp.time_peak = time + time_over_threshold / 2;
+  tp.channel = channel;
+  tp.adc_peak = adc_peak;
+  tp.adc_integral = adc_peak * time_over_threshold / 2;
+  tp.type = TriggerPrimitive::Type::kTPC;
+  tp.algorithm = TriggerPrimitive::Algorithm::kTPCDefault;
+  return tp;
+}
+
+void
+TPGenerator::add_track(timestamp_t time)
+{
+  channel_t length = m_config.track_length_channels;
+  std::uniform_int_distribution<channel_t> start_dist(0, m_config.n_channels - length);
+  std::uniform_int_distribution<timestamp_t> step_dist(0, m_config.track_max_ticks_per_channel);
+  std::uniform_int_distribution<uint32_t> adc_dist(100, 300); // NOLINT(build/unsigned)
+
+  channel_t first_channel = m_config.first_channel + start_dist(m_track_gen);
+  bool descending = m_track_gen() & 1;
+  timestamp_t step = step_dist(m_track_gen);
+  for (channel_t i = 0; i < length; ++i) {
+    channel_t channel = descending ? first_channel + length - 1 - i : first_channel + i;
+    m_pending.push_back(make_tp(time + i * step, channel, adc_dist(m_track_gen), 20 + (m_track_gen() & 0xf)));
+  }
+}
+
+void
+TPGenerator::add_burst(timestamp_t time)
+{
+  std::uniform_int_distribution<channel_t> start_dist(0, m_config.n_channels - m_config.burst_n_channels);
+  std::uniform_int_distribution<channel_t> channel_dist(0, m_config.burst_n_channels - 1);
+  std::uniform_int_distribution<timestamp_t> time_dist(0, m_config.burst_duration);
+
+  channel_t first_channel = m_config.first_channel + start_dist(m_burst_gen);
+  for (uint32_t i = 0; i < m_config.burst_n_tps; ++i) { // NOLINT(build/unsigned)
+    uint64_t r = m_burst_gen();                          // NOLINT(build/unsigned)
+    m_pending.push_back(make_tp(time + time_dist(m_burst_gen),
+                                first_channel + channel_dist(m_burst_gen),
+                                20 + (r & 0x1f),
+                                5 + ((r >> 8) & 0xf)));
+  }
+}
+
+void
+TPGenerator::generate(timestamp_t end_time, std::vector<TriggerPrimitive>& tps)
+{
+  if (end_time <= m_current_time) {
+    return;
+  }
+  size_t first_new = tps.size();
+  double end_offset = static_cast<double>(end_time - m_start_time);
+  auto to_time = [this](double offset) { return m_start_time + static_cast<timestamp_t>(offset); };
+
+  // Noise. This is where nearly all the time goes, so it uses one 64-bit
+  // random number for the channel, ADC and time over threshold
+  std::exponential_distribution<double> exp_dist(1.0);
+  while (m_next_noise < end_offset) {
+    uint64_t r = m_noise_gen(); // NOLINT(build/unsigned)
+    tps.push_back(make_tp(to_time(m_next_noise),
+                          m_config.first_channel + static_cast<channel_t>((r & 0xffffffff) % m_config.n_channels),
+                          15 + ((r >> 32) & 0x1f),
+                          5 + ((r >> 40) & 0xf)));
+    m_next_noise += exp_dist(m_noise_gen) * m_noise_interval;
+  }
+  size_t noise_end = tps.size();
+
+  // Tracks and bursts can last past end_time, so their TPs wait in m_pending until their window comes
+  size_t n_pending = m_pending.size();
+  while (m_next_track < end_offset) {
+    add_track(to_time(m_next_track));
+    m_next_track += exp_dist(m_track_gen) * m_track_interval;
+  }
+  while (m_next_burst < end_offset) {
+    add_burst(to_time(m_next_burst));
+    m_next_burst += exp_dist(m_burst_gen) * m_burst_interval;
+  }
+  if (m_pending.size() != n_pending) {
+    std::stable_sort(m_pending.begin() + n_pending, m_pending.end(), earlier);
+    std::inplace_merge(m_pending.begin(), m_pending.begin() + n_pending, m_pending.end(), earlier);
+  }
+
+  auto pending_end = std::lower_bound(
+    m_pending.begin(), m_pending.end(), end_time, [](const TriggerPrimitive& tp, timestamp_t t) {
+      return tp.time_start < t;
+    });
+  tps.insert(tps.end(), m_pending.begin(), pending_end);
+  m_pending.erase(m_pending.begin(), pending_end);
+  std::inplace_merge(tps.begin() + first_new, tps.begin() + noise_end, tps.end(), earlier);
+
+  m_current_time = end_time;
+}
+
+} // namespace dunedaq::trigger
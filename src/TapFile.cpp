@@ -0,0 +1,193 @@
+/**
+ * @file TapFile.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TapFile.hpp"
+
+#include "trigger/Issues.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+TapFileWriter::TapFileWriter(const std::string& prefix,
+                             size_t max_file_bytes,
+                             size_t max_files,
+                             triggeralgs::timestamp_t index_stride)
+  : m_prefix(prefix)
+  , m_max_file_bytes(max_file_bytes)
+  , m_max_files(max_files)
+  , m_index_stride(index_stride)
+{}
+
+TapFileWriter::~TapFileWriter()
+{
+  try {
+    close();
+  } catch (const BadTapFile& e) {
+    ers::error(e);
+  }
+}
+
+std::string
+TapFileWriter::file_name(const std::string& prefix, size_t file_number)
+{
+  char number[16];
+  std::snprintf(number, sizeof(number), "_%06zu", file_number);
+  return prefix + number + ".tap";
+}
+
+void
+TapFileWriter::open_next()
+{
+  m_filename = file_name(m_prefix, m_file_number);
+  m_file.open(m_filename, std::ios::binary | std::ios::trunc);
+  if (!m_file) {
+    throw BadTapFile(ERS_HERE, m_filename, "could not open for writing");
+  }
+  ++m_file_number;
+  if (m_max_files > 0 && m_file_number > m_max_files) {
+    std::remove(file_name(m_prefix, m_file_number - m_max_files - 1).c_str());
+  }
+
+  TapFileHeader header;
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+  m_file_bytes = sizeof(header);
+  m_bytes_written += sizeof(header);
+  m_n_records = 0;
+  m_index.clear();
+  m_next_index_time = 0;
+}
+
+void
+TapFileWriter::write(triggeralgs::timestamp_t start_time,
+                     triggeralgs::timestamp_t end_time,
+                     const char* data,
+                     size_t size)
+{
+  if (m_file.is_open() && m_file_bytes + sizeof(TapRecordHeader) + size > m_max_file_bytes && m_n_records > 0) {
+    close();
+  }
+  if (!m_file.is_open()) {
+    open_next();
+  }
+
+  // Index the first record in each stride. Strides with no record that starts in them get no entry
+  if (m_index_stride > 0 && (m_index.empty() || start_time >= m_next_index_time)) {
+    triggeralgs::timestamp_t index_time = start_time - start_time % m_index_stride;
+    m_index.push_back(TapIndexEntry{ index_time, m_file_bytes });
+    m_next_index_time = index_time + m_index_stride;
+  }
+
+  TapRecordHeader header{ start_time, end_time, size };
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+  m_file.write(data, size);
+  if (!m_file) {
+    throw BadTapFile(ERS_HERE, m_filename, "write failed");
+  }
+  m_file_bytes += sizeof(header) + size;
+  m_bytes_written += sizeof(header) + size;
+  ++m_n_records;
+}
+
+void
+TapFileWriter::close()
+{
+  if (!m_file.is_open()) {
+    return;
+  }
+  TapFileFooter footer;
+  footer.index_offset = m_file_bytes;
+  footer.n_index_entries = m_index.size();
+  footer.n_records = m_n_records;
+  m_file.write(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(TapIndexEntry)); // NOLINT
+  m_file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));                               // NOLINT
+  m_bytes_written += m_index.size() * sizeof(TapIndexEntry) + sizeof(footer);
+  m_file.close();
+  if (!m_file) {
+    throw BadTapFile(ERS_HERE, m_filename, "write failed");
+  }
+}
+
+TapFileReader::TapFileReader(const std::string& filename)
+  : m_filename(filename)
+  , m_file(filename, std::ios::binary)
+{
+  if (!m_file) {
+    throw BadTapFile(ERS_HERE, filename, "could not open for reading");
+  }
+  TapFileHeader header;
+  m_file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+  if (!m_file || header.magic != TapFileHeader::s_magic) {
+    throw BadTapFile(ERS_HERE, filename, "not a tap file");
+  }
+  if (header.version < TapFileHeader::s_min_version || header.version > TapFileHeader::s_version) {
+    throw BadTapFile(ERS_HERE, filename, "unsupported version " + std::to_string(header.version));
+  }
+
+  m_file.seekg(0, std::ios::end);
+  uint64_t file_size = m_file.tellg(); // NOLINT(build/unsigned)
+  m_records_end = file_size;
+
+  // The footer's fields are checked without adding to them, so that garbage can't overflow into a valid-looking index
+  TapFileFooter footer;
+  if (file_size >= sizeof(header) + sizeof(footer)) {
+    uint64_t footer_offset = file_size - sizeof(footer); // NOLINT(build/unsigned)
+    m_file.seekg(footer_offset);
+    m_file.read(reinterpret_cast<char*>(&footer), sizeof(footer)); // NOLINT
+    if (m_file && footer.magic == TapFileFooter::s_magic && footer.index_offset >= sizeof(header) &&
+        footer.index_offset <= footer_offset &&
+        (footer_offset - footer.index_offset) % sizeof(TapIndexEntry) == 0 &&
+        footer.n_index_entries == (footer_offset - footer.index_offset) / sizeof(TapIndexEntry)) {
+      m_records_end = footer.index_offset;
+      m_index.resize(footer.n_index_entries);
+      m_file.seekg(footer.index_offset);
+      m_file.read(reinterpret_cast<char*>(m_index.data()), m_index.size() * sizeof(TapIndexEntry)); // NOLINT
+    }
+  }
+  m_file.clear();
+  m_file.seekg(sizeof(header));
+}
+
+bool
+TapFileReader::next(TapRecordHeader& header, std::vector<char>& data)
+{
+  // Compare against what's left of the records rather than adding to the position, so that a garbage size can't
+  // overflow
+  uint64_t position = m_file.tellg(); // NOLINT(build/unsigned)
+  if (!m_file || position > m_records_end || m_records_end - position < sizeof(header)) {
+    return false;
+  }
+  m_file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+  if (!m_file || header.size > m_records_end - position - sizeof(header)) {
+    return false;
+  }
+  data.resize(header.size);
+  m_file.read(data.data(), header.size);
+  return static_cast<bool>(m_file);
+}
+
+void
+TapFileReader::seek(triggeralgs::timestamp_t time)
+{
+  uint64_t offset = sizeof(TapFileHeader); // NOLINT(build/unsigned)
+  auto entry = std::upper_bound(m_index.begin(),
+                                m_index.end(),
+                                time,
+                                [](triggeralgs::timestamp_t t, const TapIndexEntry& e) { return t < e.time; });
+  if (entry != m_index.begin()) {
+    offset = std::prev(entry)->offset;
+  }
+  m_file.clear();
+  m_file.seekg(offset);
+}
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,188 @@
+/**
+ * @file TriggerActivityMakerADCSimpleWindowFast.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerActivityMakerADCSimpleWindowFast.hpp"
+
+#include <vector>
+
+namespace dunedaq::trigger {
+
+void
+TriggerActivityMakerADCSimpleWindowFast::operator()(const triggeralgs::TriggerPrimitive& input,
+                                                    std::vector<triggeralgs::TriggerActivity>& output)
+{
+  if (m_fast_path) {
+    (*this)(&input, &input + 1, output);
+  } else {
+    m_reference(input, output);
+  }
+}
+
+void
+TriggerActivityMakerADCSimpleWindowFast::operator()(const triggeralgs::TriggerPrimitive* first,
+                                                    const triggeralgs::TriggerPrimitive* last,
+                                                    std::vector<triggeralgs::TriggerActivity>& output)
+{
+  if (!m_fast_path) {
+    for (; first != last; ++first) {
+      m_reference(*first, output);
+    }
+    return;
+  }
+
+  m_columns.assign(first, last);
+  process(m_columns, first, output);
+}
+
+void
+TriggerActivityMakerADCSimpleWindowFast::operator()(const TPSliceColumns& columns,
+                                                    const triggeralgs::TriggerPrimitive* first,
+                                                    const triggeralgs::TriggerPrimitive* last,
+                                                    std::vector<triggeralgs::TriggerActivity>& output)
+{
+  if (!m_fast_path) {
+    (*this)(first, last, output);
+    return;
+  }
+
+  process(columns, first, output);
+}
+
+void
+TriggerActivityMakerADCSimpleWindowFast::process(const TPSliceColumns& columns,
+                                                 const triggeralgs::TriggerPrimitive* first,
+                                                 std::vector<triggeralgs::TriggerActivity>& output)
+{
+  const size_t n_carried = m_window_tps.size();
+  const size_t n_slice = columns.size();
+  const size_t n = n_carried + n_slice;
+  const uint64_t* times = columns.time_start(); // NOLINT(build/unsigned)
+
+  // The carried-over window is only a few primitives long, so its sums are
+  // done here, and the slice's are carried on from them
+  m_adc_prefix.resize(n + 1);
+  m_adc_prefix[0] = 0;
+  for (size_t i = 0; i < n_carried; ++i) {
+    m_adc_prefix[i + 1] = m_adc_prefix[i] + m_window_tps[i].adc_integral;
+  }
+  adcwindow::prefix_sum(columns.adc_integral(), n_slice, m_adc_prefix.data() + n_carried, m_use_simd);
+
+  // While the window still starts in the carried-over primitives, step
+  // through them as adcwindow::scan() would. Once it starts in the slice,
+  // scan the rest of the slice's columns in place
+  m_windows.clear();
+  size_t begin = 0;
+  size_t current = n_carried;
+  while (begin < n_carried && current < n) {
+    current = n_carried + adcwindow::find_first_at_least(
+                            times, current - n_carried, n_slice, time_at(begin, times) + m_window_length, m_use_simd);
+    if (current == n) {
+      break;
+    }
+
+    if (m_adc_prefix[current] - m_adc_prefix[begin] > m_adc_threshold) {
+      m_windows.push_back(adcwindow::Window{ begin, current });
+      begin = current;
+    } else {
+      const uint64_t value = times[current - n_carried] - m_window_length + 1; // NOLINT(build/unsigned)
+      while (begin < n_carried && m_window_tps[begin].time_start < value) {
+        ++begin;
+      }
+      if (begin == n_carried) {
+        begin = n_carried + adcwindow::find_first_at_least(times, 0, current - n_carried, value, m_use_simd);
+      }
+    }
+    ++current;
+  }
+  if (begin >= n_carried) {
+    const size_t n_windows = m_windows.size();
+    begin = n_carried + adcwindow::scan(times,
+                                        m_adc_prefix.data() + n_carried,
+                                        begin - n_carried,
+                                        current - n_carried,
+                                        n_slice,
+                                        m_window_length,
+                                        m_adc_threshold,
+                                        m_use_simd,
+                                        m_windows);
+    for (size_t i = n_windows; i < m_windows.size(); ++i) {
+      m_windows[i].begin += n_carried;
+      m_windows[i].end += n_carried;
+    }
+  }
+
+  for (auto const& window : m_windows) {
+    output.push_back(construct_ta(window.begin, window.end, first, times));
+  }
+  compact(begin, first);
+}
+
+void
+TriggerActivityMakerADCSimpleWindowFast::configure(const nlohmann::json& config)
+{
+  m_reference.configure(config);
+
+  if (config.is_object()) {
+    if (config.contains("window_length")) {
+      m_window_length = config["window_length"];
+    }
+    if (config.contains("adc_threshold")) {
+      m_adc_threshold = config["adc_threshold"];
+    }
+    if (config.contains("fast_path")) {
+      m_fast_path = config["fast_path"];
+    }
+    if (config.contains("use_avx2")) {
+      m_use_simd = config["use_avx2"];
+    }
+  }
+
+  m_window_tps.clear();
+}
+
+triggeralgs::TriggerActivity
+TriggerActivityMakerADCSimpleWindowFast::construct_ta(size_t begin,
+                                                      size_t end,
+                                                      const triggeralgs::TriggerPrimitive* first,
+                                                      const uint64_t* slice_times) const // NOLINT(build/unsigned)
+{
+  // Same fields as triggeralgs::TriggerActivityMakerADCSimpleWindow::construct_ta()
+  const triggeralgs::TriggerPrimitive& latest = tp_at(end - 1, first);
+
+  triggeralgs::TriggerActivity ta;
+  ta.time_start = time_at(begin, slice_times);
+  ta.time_end = latest.time_start + latest.time_over_threshold;
+  ta.time_peak = latest.time_peak;
+  ta.time_activity = latest.time_peak;
+  ta.channel_start = latest.channel;
+  ta.channel_end = latest.channel;
+  ta.channel_peak = latest.channel;
+  ta.adc_integral = m_adc_prefix[end] - m_adc_prefix[begin];
+  ta.adc_peak = latest.adc_peak;
+  ta.detid = latest.detid;
+  ta.type = triggeralgs::TriggerActivity::Type::kTPC;
+  ta.algorithm = triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow;
+  ta.inputs.reserve(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    ta.inputs.push_back(tp_at(i, first));
+  }
+  return ta;
+}
+
+void
+TriggerActivityMakerADCSimpleWindowFast::compact(size_t begin, const triggeralgs::TriggerPrimitive* first)
+{
+  const size_t n = m_adc_prefix.size() - 1;
+  m_scratch_tps.clear();
+  for (size_t i = begin; i < n; ++i) {
+    m_scratch_tps.push_back(tp_at(i, first));
+  }
+  m_window_tps.swap(m_scratch_tps);
+}
+
+} // namespace dunedaq::trigger
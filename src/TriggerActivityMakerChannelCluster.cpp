@@ -0,0 +1,286 @@
+/**
+ * @file TriggerActivityMakerChannelCluster.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerActivityMakerChannelCluster.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+void
+TriggerActivityMakerChannelCluster::operator()(const triggeralgs::TriggerPrimitive& input,
+                                               std::vector<triggeralgs::TriggerActivity>& output)
+{
+  const triggeralgs::timestamp_t time = input.time_start;
+  if (m_n_active > 0 && time > m_next_close_time) {
+    close_older_than(time, output);
+  }
+
+  // Find the open clusters with a recent TP on a neighbouring channel
+  m_adjacent.clear();
+  for (channel_t channel : neighbours(input.channel)) {
+    auto it = m_channel_index.find(channel);
+    if (it == m_channel_index.end()) {
+      continue;
+    }
+    const IndexEntry& entry = it->second;
+    const Cluster& cluster = m_clusters[entry.slot];
+    if (!cluster.active || cluster.generation != entry.generation || time - entry.time > m_time_window) {
+      continue;
+    }
+    if (std::find(m_adjacent.begin(), m_adjacent.end(), entry.slot) == m_adjacent.end()) {
+      m_adjacent.push_back(entry.slot);
+    }
+  }
+
+  size_t slot;
+  if (m_adjacent.empty()) {
+    slot = open_slot(output);
+    m_next_close_time = std::min(m_next_close_time, time + m_time_window);
+  } else {
+    // Merge everything into the biggest adjacent cluster, which means the
+    // fewest index entries to update
+    slot = *std::max_element(m_adjacent.begin(), m_adjacent.end(), [this](size_t a, size_t b) {
+      return m_clusters[a].tps.size() < m_clusters[b].tps.size();
+    });
+    for (size_t other : m_adjacent) {
+      if (other != slot) {
+        merge_into(slot, other);
+      }
+    }
+  }
+
+  Cluster& cluster = m_clusters[slot];
+  cluster.tps.push_back(input);
+  cluster.adc_integral += input.adc_integral;
+  cluster.last_time = std::max(cluster.last_time, time);
+  m_channel_index[input.channel] = IndexEntry{ slot, cluster.generation, time };
+}
+
+void
+TriggerActivityMakerChannelCluster::flush(triggeralgs::timestamp_t until,
+                                          std::vector<triggeralgs::TriggerActivity>& output)
+{
+  // No more TPs will arrive before `until`, so any cluster that would have
+  // timed out by then can be closed now
+  if (m_n_active > 0) {
+    close_older_than(until, output);
+  }
+}
+
+void
+TriggerActivityMakerChannelCluster::configure(const nlohmann::json& config)
+{
+  if (config.is_object()) {
+    if (config.contains("time_window")) {
+      m_time_window = config["time_window"];
+    }
+    if (config.contains("channel_tolerance")) {
+      m_channel_tolerance = config["channel_tolerance"];
+    }
+    if (config.contains("min_tps")) {
+      m_min_tps = config["min_tps"];
+    }
+    if (config.contains("min_adc")) {
+      m_min_adc = config["min_adc"];
+    }
+    if (config.contains("max_active_clusters")) {
+      m_max_active_clusters = std::max<size_t>(config["max_active_clusters"].get<size_t>(), 1);
+    }
+    if (config.contains("channel_groups")) {
+      m_channel_groups.clear();
+      for (auto const& group : config["channel_groups"]) {
+        m_channel_groups.emplace_back(group.at(0).get<channel_t>(), group.at(1).get<channel_t>());
+      }
+      std::sort(m_channel_groups.begin(), m_channel_groups.end());
+    }
+  }
+
+  m_neighbours.clear();
+  m_channel_index.clear();
+  m_clusters.clear();
+  m_free_slots.clear();
+  m_n_active = 0;
+  m_next_close_time = std::numeric_limits<triggeralgs::timestamp_t>::max();
+
+  // With a channel map, every channel we can see is known up front
+  for (auto const& [first, last] : m_channel_groups) {
+    for (uint64_t channel = first; channel <= last; ++channel) { // NOLINT(build/unsigned)
+      m_neighbours.emplace(channel, make_neighbours(channel));
+    }
+  }
+}
+
+const std::vector<TriggerActivityMakerChannelCluster::channel_t>&
+TriggerActivityMakerChannelCluster::neighbours(channel_t channel)
+{
+  auto it = m_neighbours.find(channel);
+  if (it == m_neighbours.end()) {
+    it = m_neighbours.emplace(channel, make_neighbours(channel)).first;
+  }
+  return it->second;
+}
+
+std::vector<TriggerActivityMakerChannelCluster::channel_t>
+TriggerActivityMakerChannelCluster::make_neighbours(channel_t channel) const
+{
+  uint64_t first = channel >= m_channel_tolerance ? channel - m_channel_tolerance : 0; // NOLINT(build/unsigned)
+  uint64_t last = static_cast<uint64_t>(channel) + m_channel_tolerance;                // NOLINT(build/unsigned)
+
+  if (!m_channel_groups.empty()) {
+    // Find the last group starting at or before `channel`
+    auto group = std::upper_bound(m_channel_groups.begin(),
+                                  m_channel_groups.end(),
+                                  std::make_pair(channel, std::numeric_limits<channel_t>::max()));
+    if (group == m_channel_groups.begin() || channel > std::prev(group)->second) {
+      // Not in the channel map, so it has no neighbours
+      return { channel };
+    }
+    --group;
+    first = std::max<uint64_t>(first, group->first); // NOLINT(build/unsigned)
+    last = std::min<uint64_t>(last, group->second);  // NOLINT(build/unsigned)
+  }
+
+  std::vector<channel_t> ret;
+  ret.reserve(last - first + 1);
+  for (uint64_t neighbour = first; neighbour <= last; ++neighbour) { // NOLINT(build/unsigned)
+    ret.push_back(static_cast<channel_t>(neighbour));
+  }
+  return ret;
+}
+
+void
+TriggerActivityMakerChannelCluster::close_older_than(triggeralgs::timestamp_t time,
+                                                     std::vector<triggeralgs::TriggerActivity>& output)
+{
+  m_next_close_time = std::numeric_limits<triggeralgs::timestamp_t>::max();
+  for (size_t slot = 0; slot < m_clusters.size(); ++slot) {
+    const Cluster& cluster = m_clusters[slot];
+    if (!cluster.active) {
+      continue;
+    }
+    if (cluster.last_time + m_time_window < time) {
+      close(slot, output);
+    } else {
+      m_next_close_time = std::min(m_next_close_time, cluster.last_time + m_time_window);
+    }
+  }
+}
+
+void
+TriggerActivityMakerChannelCluster::close(size_t slot, std::vector<triggeralgs::TriggerActivity>& output)
+{
+  Cluster& cluster = m_clusters[slot];
+  if (cluster.tps.size() >= m_min_tps && cluster.adc_integral >= m_min_adc) {
+    output.push_back(construct_ta(cluster));
+  }
+  cluster.tps.clear();
+  cluster.adc_integral = 0;
+  cluster.active = false;
+  ++cluster.generation;
+  m_free_slots.push_back(slot);
+  --m_n_active;
+}
+
+size_t
+TriggerActivityMakerChannelCluster::open_slot(std::vector<triggeralgs::TriggerActivity>& output)
+{
+  if (m_n_active >= m_max_active_clusters) {
+    // Make room by closing the cluster that has been quiet the longest
+    size_t oldest = m_clusters.size();
+    for (size_t slot = 0; slot < m_clusters.size(); ++slot) {
+      if (!m_clusters[slot].active) {
+        continue;
+      }
+      if (oldest == m_clusters.size() || m_clusters[slot].last_time < m_clusters[oldest].last_time) {
+        oldest = slot;
+      }
+    }
+    close(oldest, output);
+  }
+
+  size_t slot;
+  if (m_free_slots.empty()) {
+    slot = m_clusters.size();
+    m_clusters.emplace_back();
+  } else {
+    slot = m_free_slots.back();
+    m_free_slots.pop_back();
+  }
+  Cluster& cluster = m_clusters[slot];
+  cluster.active = true;
+  cluster.last_time = 0;
+  ++m_n_active;
+  return slot;
+}
+
+void
+TriggerActivityMakerChannelCluster::merge_into(size_t target, size_t source)
+{
+  Cluster& to = m_clusters[target];
+  Cluster& from = m_clusters[source];
+
+  // Point the channels that led to `source` at `target` instead
+  for (auto const& tp : from.tps) {
+    auto it = m_channel_index.find(tp.channel);
+    if (it != m_channel_index.end() && it->second.slot == source && it->second.generation == from.generation) {
+      it->second.slot = target;
+      it->second.generation = to.generation;
+    }
+  }
+
+  to.tps.insert(to.tps.end(), from.tps.begin(), from.tps.end());
+  to.adc_integral += from.adc_integral;
+  to.last_time = std::max(to.last_time, from.last_time);
+
+  from.tps.clear();
+  from.adc_integral = 0;
+  from.active = false;
+  ++from.generation;
+  m_free_slots.push_back(source);
+  --m_n_active;
+}
+
+triggeralgs::TriggerActivity
+TriggerActivityMakerChannelCluster::construct_ta(const Cluster& cluster) const
+{
+  triggeralgs::TriggerActivity ta;
+  ta.inputs = cluster.tps;
+  // Merged clusters are no longer in time order
+  std::stable_sort(ta.inputs.begin(), ta.inputs.end(), [](auto const& a, auto const& b) {
+    return a.time_start < b.time_start;
+  });
+
+  const triggeralgs::TriggerPrimitive* peak = &ta.inputs.front();
+  ta.time_start = ta.inputs.front().time_start;
+  ta.time_end = 0;
+  ta.channel_start = ta.inputs.front().channel;
+  ta.channel_end = ta.inputs.front().channel;
+  for (auto const& tp : ta.inputs) {
+    ta.time_end = std::max<triggeralgs::timestamp_t>(ta.time_end, tp.time_start + tp.time_over_threshold);
+    ta.channel_start = std::min<channel_t>(ta.channel_start, tp.channel);
+    ta.channel_end = std::max<channel_t>(ta.channel_end, tp.channel);
+    if (tp.adc_peak > peak->adc_peak) {
+      peak = &tp;
+    }
+  }
+  ta.time_peak = peak->time_peak;
+  ta.time_activity = peak->time_peak;
+  ta.channel_peak = peak->channel;
+  ta.adc_integral = cluster.adc_integral;
+  ta.adc_peak = peak->adc_peak;
+  ta.detid = peak->detid;
+  ta.type = triggeralgs::TriggerActivity::Type::kTPC;
+  ta.algorithm = triggeralgs::TriggerActivity::Algorithm::kUnknown;
+  return ta;
+}
+
+} // namespace dunedaq::trigger
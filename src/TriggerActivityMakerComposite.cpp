@@ -0,0 +1,225 @@
+/**
+ * @file TriggerActivityMakerComposite.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerActivityMakerComposite.hpp"
+
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+namespace {
+// The composite isn't loaded from a plugin, so register its batch entry point here
+[[maybe_unused]] const bool composite_registered = register_slice_processor<triggeralgs::TriggerActivityMaker,
+                                                                            triggeralgs::TriggerPrimitive,
+                                                                            triggeralgs::TriggerActivity,
+                                                                            TriggerActivityMakerComposite>();
+} // namespace
+
+TriggerActivityMakerComposite::TriggerActivityMakerComposite(
+  std::vector<std::shared_ptr<triggeralgs::TriggerActivityMaker>> makers,
+  bool parallel,
+  std::vector<size_t> routes)
+{
+  for (size_t i = 0; i < makers.size(); ++i) {
+    Maker m;
+    m.processor = find_slice_processor<triggeralgs::TriggerActivityMaker,
+                                       triggeralgs::TriggerPrimitive,
+                                       triggeralgs::TriggerActivity>(*makers[i]);
+    const TPSliceColumns::fields_t column_fields = slice_processor_column_fields<triggeralgs::TriggerActivityMaker,
+                                                                                 triggeralgs::TriggerPrimitive,
+                                                                                 triggeralgs::TriggerActivity>(*makers[i]);
+    m.uses_columns = column_fields != 0;
+    m_column_fields |= column_fields;
+    m.route = i < routes.size() ? routes[i] : 0;
+    if (m.route > m_routed.size()) {
+      m_routed.resize(m.route);
+    }
+    m.maker = std::move(makers[i]);
+    m_makers.push_back(std::move(m));
+  }
+
+  if (parallel) {
+    for (size_t i = 1; i < m_makers.size(); ++i) {
+      m_pool.emplace_back(&TriggerActivityMakerComposite::run_pool_thread, this, i);
+    }
+  }
+}
+
+TriggerActivityMakerComposite::~TriggerActivityMakerComposite()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_pool_mutex);
+    m_shutdown = true;
+  }
+  m_start_cv.notify_all();
+  for (auto& thread : m_pool) {
+    thread.join();
+  }
+}
+
+void
+TriggerActivityMakerComposite::operator()(const triggeralgs::TriggerPrimitive& input,
+                                          std::vector<triggeralgs::TriggerActivity>& output)
+{
+  for (auto& m : m_makers) {
+    m.maker->operator()(input, destination(m, output));
+  }
+}
+
+void
+TriggerActivityMakerComposite::operator()(const triggeralgs::TriggerPrimitive* first,
+                                          const triggeralgs::TriggerPrimitive* last,
+                                          std::vector<triggeralgs::TriggerActivity>& output)
+{
+  run_all(first, last, nullptr, output);
+}
+
+void
+TriggerActivityMakerComposite::operator()(const TPSliceColumns& columns,
+                                          const triggeralgs::TriggerPrimitive* first,
+                                          const triggeralgs::TriggerPrimitive* last,
+                                          std::vector<triggeralgs::TriggerActivity>& output)
+{
+  run_all(first, last, &columns, output);
+}
+
+void
+TriggerActivityMakerComposite::run_all(const triggeralgs::TriggerPrimitive* first,
+                                       const triggeralgs::TriggerPrimitive* last,
+                                       const TPSliceColumns* columns,
+                                       std::vector<triggeralgs::TriggerActivity>& output)
+{
+  if (m_makers.empty()) {
+    return;
+  }
+
+  if (!m_pool.empty()) {
+    {
+      std::lock_guard<std::mutex> lk(m_pool_mutex);
+      m_first = first;
+      m_last = last;
+      m_slice_columns = columns;
+      m_n_running = m_pool.size();
+      ++m_generation;
+    }
+    m_start_cv.notify_all();
+    std::exception_ptr error;
+    try {
+      run(m_makers[0], first, last, columns);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // Wait for all of them before rethrowing anything, since they use the slice
+    {
+      std::unique_lock<std::mutex> lk(m_pool_mutex);
+      m_done_cv.wait(lk, [this] { return m_n_running == 0; });
+    }
+    for (auto& m : m_makers) {
+      if (!error && m.error) {
+        error = m.error;
+      }
+      m.error = nullptr;
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  } else {
+    for (auto& m : m_makers) {
+      run(m, first, last, columns);
+    }
+  }
+
+  for (auto& m : m_makers) {
+    auto& dest = destination(m, output);
+    dest.insert(dest.end(), m.output.begin(), m.output.end());
+  }
+}
+
+void
+TriggerActivityMakerComposite::flush(triggeralgs::timestamp_t until, std::vector<triggeralgs::TriggerActivity>& output)
+{
+  for (auto& m : m_makers) {
+    m.maker->flush(until, destination(m, output));
+  }
+}
+
+void
+TriggerActivityMakerComposite::take_outputs(size_t route, std::vector<triggeralgs::TriggerActivity>& output)
+{
+  if (route == 0 || route > m_routed.size()) {
+    return;
+  }
+  auto& routed = m_routed[route - 1];
+  output.insert(output.end(), std::make_move_iterator(routed.begin()), std::make_move_iterator(routed.end()));
+  routed.clear();
+}
+
+void
+TriggerActivityMakerComposite::run(Maker& m,
+                                   const triggeralgs::TriggerPrimitive* first,
+                                   const triggeralgs::TriggerPrimitive* last,
+                                   const TPSliceColumns* columns)
+{
+  m.output.clear();
+  if (m.processor) {
+    m.processor(*m.maker, first, last, m.uses_columns ? columns : nullptr, m.output);
+  } else {
+    for (; first != last; ++first) {
+      m.maker->operator()(*first, m.output);
+    }
+  }
+}
+
+std::vector<triggeralgs::TriggerActivity>&
+TriggerActivityMakerComposite::destination(const Maker& m, std::vector<triggeralgs::TriggerActivity>& output)
+{
+  return m.route == 0 ? output : m_routed[m.route - 1];
+}
+
+void
+TriggerActivityMakerComposite::run_pool_thread(size_t index)
+{
+  Maker& m = m_makers[index];
+  size_t generation = 0;
+  while (true) {
+    const triggeralgs::TriggerPrimitive* first;
+    const triggeralgs::TriggerPrimitive* last;
+    const TPSliceColumns* columns;
+    {
+      std::unique_lock<std::mutex> lk(m_pool_mutex);
+      m_start_cv.wait(lk, [this, generation] { return m_shutdown || m_generation != generation; });
+      if (m_shutdown) {
+        return;
+      }
+      generation = m_generation;
+      first = m_first;
+      last = m_last;
+      columns = m_slice_columns;
+    }
+
+    try {
+      run(m, first, last, columns);
+    } catch (...) {
+      m.error = std::current_exception();
+    }
+
+    bool last_one;
+    {
+      std::lock_guard<std::mutex> lk(m_pool_mutex);
+      last_one = --m_n_running == 0;
+    }
+    if (last_one) {
+      m_done_cv.notify_one();
+    }
+  }
+}
+
+} // namespace dunedaq::trigger
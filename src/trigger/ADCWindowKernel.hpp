@@ -0,0 +1,77 @@
+/**
+ * @file ADCWindowKernel.hpp
+ *
+ * Column-oriented kernels for finding ADC-sum windows in a time-ordered
+ * slice of trigger primitives
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_ADCWINDOWKERNEL_HPP_
+#define TRIGGER_SRC_TRIGGER_ADCWINDOWKERNEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq::trigger::adcwindow {
+
+/**
+ * @brief Whether the AVX2 implementations can be used on this CPU
+ */
+bool simd_available();
+
+/**
+ * @brief Fill prefix[i+1] = prefix[i] + adc[i] for i in [0, n). prefix must
+ * have room for n+1 elements, and prefix[0] must already be set
+ */
+void
+prefix_sum(const uint32_t* adc, size_t n, uint64_t* prefix, bool use_simd); // NOLINT(build/unsigned)
+
+/**
+ * @brief Return the first index i in [from, to) with times[i] >= value, or
+ * `to` if there is none. times must be sorted
+ */
+size_t
+find_first_at_least(const uint64_t* times, size_t from, size_t to, uint64_t value, bool use_simd); // NOLINT(build/unsigned)
+
+/**
+ * @brief Half-open range of indices [begin, end) making up one window
+ */
+struct Window
+{
+  size_t begin;
+  size_t end;
+};
+
+/**
+ * @brief Run the ADC simple window algorithm over the primitives with
+ * indices [first, n), given that the primitives [begin, first) are already in
+ * the current window. (begin == first means the window is empty.)
+ *
+ * A primitive is added to the window if it starts less than `window_length`
+ * after the window's first primitive. Otherwise, if the summed ADC of the
+ * window is above `threshold`, the window is appended to `windows` and a new
+ * window starts with that primitive. If not, the window's earliest primitives
+ * are dropped until the new one fits.
+ *
+ * `prefix` holds the prefix sums of adc_integral, as made by prefix_sum().
+ * Returns the index of the first primitive in the window after the last one
+ * has been processed
+ */
+size_t
+scan(const uint64_t* times,  // NOLINT(build/unsigned)
+     const uint64_t* prefix, // NOLINT(build/unsigned)
+     size_t begin,
+     size_t first,
+     size_t n,
+     uint64_t window_length, // NOLINT(build/unsigned)
+     uint64_t threshold,     // NOLINT(build/unsigned)
+     bool use_simd,
+     std::vector<Window>& windows);
+
+} // namespace dunedaq::trigger::adcwindow
+
+#endif // TRIGGER_SRC_TRIGGER_ADCWINDOWKERNEL_HPP_
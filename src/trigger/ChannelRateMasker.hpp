@@ -0,0 +1,133 @@
+/**
+ * @file ChannelRateMasker.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_CHANNELRATEMASKER_HPP_
+#define TRIGGER_SRC_TRIGGER_CHANNELRATEMASKER_HPP_
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+#include "triggeralgs/Types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief ChannelRateMasker drops TriggerPrimitives from channels whose TP
+ * rate is above a threshold.
+ *
+ * TPs are counted per channel in bins of `rate_interval` ticks. As soon as a
+ * channel has more than `max_rate_hz` worth of TPs in the current bin, it is
+ * masked, and its TPs are dropped for `cooldown` ticks. When the cooldown is
+ * over, the channel is unmasked if its rate over the last full bin was below
+ * the threshold, and masked for another cooldown otherwise.
+ *
+ * Per-channel state is held in an array indexed by channel number, which
+ * grows to the largest channel seen up to `max_channel`. Channels above that,
+ * which may come from corrupt TPs, are kept in a hash map instead, so they
+ * can't make the array take an arbitrary amount of memory.
+ *
+ * The operator() and flush() signatures are those TriggerGenericMaker expects
+ * from its maker, so that this can be used as the maker of a
+ * Set<TriggerPrimitive> to Set<TriggerPrimitive> module. The counters and the
+ * list of masked channels can be read from another thread.
+ */
+class ChannelRateMasker
+{
+public:
+  using channel_t = decltype(triggeralgs::TriggerPrimitive::channel);
+
+  struct Config
+  {
+    // Zero or less disables masking
+    double max_rate_hz{ 0 };
+    triggeralgs::timestamp_t rate_interval{ 50000000 };
+    triggeralgs::timestamp_t cooldown{ 500000000 };
+    uint64_t clock_frequency_hz{ 50000000 }; // NOLINT(build/unsigned)
+    channel_t max_channel{ 1000000 };
+  };
+
+  struct MaskedChannel
+  {
+    channel_t channel;
+    // Rate over the last full bin, or the current bin if that's higher
+    double rate_hz;
+    triggeralgs::timestamp_t masked_until;
+  };
+
+  void configure(const Config& config);
+
+  void operator()(const triggeralgs::TriggerPrimitive& input, std::vector<triggeralgs::TriggerPrimitive>& output);
+
+  /**
+   * Called when no more TPs before `time` will arrive. Unmasks channels whose
+   * cooldown has expired, even if they haven't sent a TP since
+   */
+  void flush(triggeralgs::timestamp_t time, std::vector<triggeralgs::TriggerPrimitive>& output);
+
+  uint64_t get_n_passed() const { return m_n_passed.load(); }           // NOLINT(build/unsigned)
+  uint64_t get_n_dropped() const { return m_n_dropped.load(); }         // NOLINT(build/unsigned)
+  uint64_t get_n_mask_events() const { return m_n_mask_events.load(); } // NOLINT(build/unsigned)
+
+  std::vector<MaskedChannel> get_masked_channels() const;
+
+private:
+  struct ChannelState
+  {
+    uint64_t bin{ std::numeric_limits<uint64_t>::max() }; // NOLINT(build/unsigned)
+    uint32_t count{ 0 };                                  // NOLINT(build/unsigned)
+    uint32_t last_count{ 0 };                             // NOLINT(build/unsigned)
+    triggeralgs::timestamp_t masked_until{ 0 };
+    bool masked{ false };
+  };
+
+  ChannelState& state(channel_t channel)
+  {
+    if (channel > m_config.max_channel) {
+      return m_sparse_channels[channel];
+    }
+    if (channel >= m_channels.size()) {
+      m_channels.resize(static_cast<size_t>(channel) + 1);
+    }
+    return m_channels[channel];
+  }
+
+  // Move `state` on to the bin containing `time`
+  void roll(ChannelState& state, triggeralgs::timestamp_t time) const;
+
+  double rate_hz(const ChannelState& state) const;
+
+  // Called when `state`'s cooldown has expired at `time`. Returns whether it is still masked
+  bool end_cooldown(channel_t channel, ChannelState& state, triggeralgs::timestamp_t time);
+
+  void update_snapshot();
+
+  Config m_config;
+  uint64_t m_max_count{ 0 }; // NOLINT(build/unsigned)
+
+  std::vector<ChannelState> m_channels;
+  std::unordered_map<channel_t, ChannelState> m_sparse_channels;
+  std::vector<channel_t> m_masked;
+
+  std::atomic<uint64_t> m_n_passed{ 0 };      // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_n_dropped{ 0 };     // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_n_mask_events{ 0 }; // NOLINT(build/unsigned)
+
+  mutable std::mutex m_snapshot_mutex;
+  std::vector<MaskedChannel> m_snapshot;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_CHANNELRATEMASKER_HPP_
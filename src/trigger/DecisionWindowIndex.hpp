@@ -0,0 +1,89 @@
+/**
+ * @file DecisionWindowIndex.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_DECISIONWINDOWINDEX_HPP_
+#define TRIGGER_SRC_TRIGGER_DECISIONWINDOWINDEX_HPP_
+
+#include "daqdataformats/ComponentRequest.hpp"
+#include "daqdataformats/GeoID.hpp"
+#include "daqdataformats/Types.hpp"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief DecisionWindowIndex remembers the readout windows of recently
+ * issued TriggerDecisions, per link, so that new decisions don't read out
+ * the same data again.
+ *
+ * A new decision's component requests are compared against the recorded
+ * windows for the same link: a request that is entirely covered is removed,
+ * and a request that overlaps one end of a recorded window is trimmed to the
+ * part that hasn't been read out yet. A request that entirely contains a
+ * recorded window is left alone, since a component request can only describe
+ * one contiguous interval.
+ *
+ * Windows are forgotten once they end more than `history_ticks` before the
+ * start of the newest request seen on the same link. A history of zero
+ * disables the index altogether.
+ */
+class DecisionWindowIndex
+{
+public:
+  enum class Result
+  {
+    kNew,     ///< No request overlapped a recorded window
+    kTrimmed, ///< At least one request was trimmed or removed, but some remain
+    kMerged   ///< Every request was already covered by recorded windows
+  };
+
+  void configure(daqdataformats::timestamp_t history_ticks)
+  {
+    m_history_ticks = history_ticks;
+    m_windows.clear();
+  }
+
+  void reset() { m_windows.clear(); }
+
+  bool enabled() const { return m_history_ticks > 0; }
+
+  /**
+   * Trim `components` in place against the recorded windows, removing any
+   * that are entirely covered
+   */
+  Result apply(std::vector<daqdataformats::ComponentRequest>& components);
+
+  /**
+   * Record the windows of a decision that has been sent
+   */
+  void record(const std::vector<daqdataformats::ComponentRequest>& components);
+
+  size_t get_n_windows() const;
+
+private:
+  struct Window
+  {
+    daqdataformats::timestamp_t begin;
+    daqdataformats::timestamp_t end;
+  };
+
+  // Drop windows on `link` that are too old to matter for a request starting at `begin`
+  void expire(std::deque<Window>& windows, daqdataformats::timestamp_t begin) const;
+
+  daqdataformats::timestamp_t m_history_ticks{ 0 };
+  std::map<daqdataformats::GeoID, std::deque<Window>> m_windows;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_DECISIONWINDOWINDEX_HPP_
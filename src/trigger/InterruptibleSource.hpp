@@ -0,0 +1,131 @@
+/**
+ * @file InterruptibleSource.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_INTERRUPTIBLESOURCE_HPP_
+#define TRIGGER_SRC_TRIGGER_INTERRUPTIBLESOURCE_HPP_
+
+#include "trigger/StopSignal.hpp"
+
+#include "appfwk/DAQSource.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief InterruptibleSource wraps a DAQSource so that a worker thread can
+ * wait for input and for a stop request in one call.
+ *
+ * The appfwk queues don't expose anything a thread can wait on alongside a
+ * stop flag, and their pushes can't be hooked to notify one, so a blocking
+ * pop can't be interrupted. Waits are therefore blocking pops of at most
+ * `stop_check_interval` each: data wakes the worker as soon as it arrives,
+ * through the queue's own wait, and a stop is noticed within one interval.
+ * The default interval is the 100 ms input timeout that the modules used
+ * before, so an idle worker wakes no more often than it did then. After a
+ * stop the source never blocks again: the queue is drained without
+ * waiting, and pop() reports kStopped as soon as it is empty.
+ */
+template<class T>
+class InterruptibleSource
+{
+public:
+  using source_t = appfwk::DAQSource<T>;
+
+  enum class Status
+  {
+    kData,    ///< An object was popped
+    kTimeout, ///< Nothing arrived before the timeout
+    kStopped  ///< A stop was requested and the queue is empty
+  };
+
+  // The default longest time a single blocking pop may take
+  static constexpr std::chrono::milliseconds s_default_stop_check_interval{ 100 };
+
+  /**
+   * `stop_check_interval` is the longest that a single blocking pop may
+   * take, which bounds how long it takes to notice a stop request
+   */
+  InterruptibleSource(source_t& source,
+                      const StopSignal& stop,
+                      std::chrono::milliseconds stop_check_interval = s_default_stop_check_interval)
+    : m_source(source)
+    , m_stop(stop)
+    , m_stop_check_interval(stop_check_interval)
+  {}
+
+  /**
+   * Wait for up to `timeout` for an object
+   */
+  Status pop(T& obj, std::chrono::milliseconds timeout)
+  {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      if (m_stop.stop_requested()) {
+        return try_pop(obj) ? Status::kData : Status::kStopped;
+      }
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0) {
+        return try_pop(obj) ? Status::kData : Status::kTimeout;
+      }
+      try {
+        m_source.pop(obj, std::min(remaining, m_stop_check_interval));
+        return Status::kData;
+      } catch (const appfwk::QueueTimeoutExpired&) {
+        // Go round again, to check for a stop request
+      }
+    }
+  }
+
+  /**
+   * Wait until an object arrives, or until a stop is requested and the
+   * queue is empty. Returns true if an object was popped
+   */
+  bool pop(T& obj)
+  {
+    while (true) {
+      if (m_stop.stop_requested()) {
+        return try_pop(obj);
+      }
+      try {
+        m_source.pop(obj, m_stop_check_interval);
+        return true;
+      } catch (const appfwk::QueueTimeoutExpired&) {
+        // Go round again, to check for a stop request
+      }
+    }
+  }
+
+  /**
+   * Pop an object if one is available, without waiting
+   */
+  bool try_pop(T& obj)
+  {
+    if (!m_source.can_pop()) {
+      return false;
+    }
+    try {
+      m_source.pop(obj, std::chrono::milliseconds(0));
+    } catch (const appfwk::QueueTimeoutExpired&) {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  source_t& m_source;
+  const StopSignal& m_stop;
+  std::chrono::milliseconds m_stop_check_interval;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_INTERRUPTIBLESOURCE_HPP_
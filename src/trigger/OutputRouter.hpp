@@ -0,0 +1,41 @@
+/**
+ * @file OutputRouter.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_OUTPUTROUTER_HPP_
+#define TRIGGER_SRC_TRIGGER_OUTPUTROUTER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief Interface for makers that send some of their outputs to other output
+ * queues than the module's main one.
+ *
+ * Route 0 is the main output, which the maker appends to the output vector as
+ * usual. Outputs for routes 1 and up are kept back by the maker, and the
+ * module collects them with take_outputs after each call to the maker. The
+ * module maps routes 1 and up to output queues, see
+ * TriggerGenericMaker::set_output_queues
+ */
+template<class T>
+class OutputRouter
+{
+public:
+  virtual ~OutputRouter() = default;
+
+  // Append the outputs for `route` made since the last take, and forget them
+  virtual void take_outputs(size_t route, std::vector<T>& output) = 0;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_OUTPUTROUTER_HPP_
@@ -0,0 +1,76 @@
+/**
+ * @file SliceProcessing.hpp Run time slices through makers and collect their output windows
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_SLICEPROCESSING_HPP_
+#define TRIGGER_SRC_TRIGGER_SLICEPROCESSING_HPP_
+
+#include "trigger/AlgorithmDispatch.hpp"
+#include "trigger/Set.hpp"
+#include "trigger/TPSliceColumns.hpp"
+#include "trigger/TimeSliceOutputBuffer.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * Run a time ordered slice through `maker`. If the maker has a typed slice
+ * processor (see find_slice_processor), it is handed the whole slice,
+ * otherwise the maker is called for each object in turn. `columns` is only
+ * passed on to the processor, and may be nullptr
+ */
+template<class MAKER, class A, class B>
+void
+process_slice(MAKER& maker,
+              void (*processor)(MAKER&, const A*, const A*, const TPSliceColumns*, std::vector<B>&),
+              const std::vector<A>& time_slice,
+              const TPSliceColumns* columns,
+              std::vector<B>& out)
+{
+  if (processor) {
+    processor(maker, time_slice.data(), time_slice.data() + time_slice.size(), columns, out);
+  } else {
+    for (const A& x : time_slice) {
+      maker(x, out);
+    }
+  }
+}
+
+/**
+ * As above, looking up the maker's slice processor first
+ */
+template<class MAKER, class A, class B>
+void
+process_slice(MAKER& maker, const std::vector<A>& time_slice, const TPSliceColumns* columns, std::vector<B>& out)
+{
+  process_slice(maker, find_slice_processor<MAKER, A, B>(maker), time_slice, columns, out);
+}
+
+/**
+ * Flush each window that `buffer` has ready, or every window it has if
+ * `all` is set, into a payload Set appended to `sets`. Empty windows are
+ * skipped, as TriggerGenericMaker doesn't send them
+ */
+template<class T>
+void
+flush_ready(TimeSliceOutputBuffer<T>& buffer, std::vector<Set<T>>& sets, bool all = false)
+{
+  while (all ? !buffer.empty() : buffer.ready()) {
+    Set<T> set;
+    buffer.flush(set.objects, set.start_time, set.end_time);
+    if (!set.objects.empty()) {
+      set.type = Set<T>::Type::kPayload;
+      sets.push_back(std::move(set));
+    }
+  }
+}
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_SLICEPROCESSING_HPP_
@@ -0,0 +1,46 @@
+/**
+ * @file StopSignal.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_STOPSIGNAL_HPP_
+#define TRIGGER_SRC_TRIGGER_STOPSIGNAL_HPP_
+
+#include <atomic>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief StopSignal lets a command thread tell a worker thread to stop.
+ * Workers check it between the bounded waits in InterruptibleSource
+ */
+class StopSignal
+{
+public:
+  StopSignal() = default;
+
+  StopSignal(StopSignal const&) = delete;
+  StopSignal(StopSignal&&) = delete;
+  StopSignal& operator=(StopSignal const&) = delete;
+  StopSignal& operator=(StopSignal&&) = delete;
+
+  // Call at start of run, before starting the worker thread
+  void reset() { m_stop_requested.store(false); }
+
+  // Call from the stop command, before joining the worker thread
+  void request_stop() { m_stop_requested.store(true); }
+
+  bool stop_requested() const { return m_stop_requested.load(); }
+
+private:
+  std::atomic<bool> m_stop_requested{ false };
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_STOPSIGNAL_HPP_
@@ -0,0 +1,187 @@
+/**
+ * @file TCScheduler.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TCSCHEDULER_HPP_
+#define TRIGGER_SRC_TRIGGER_TCSCHEDULER_HPP_
+
+#include "triggeralgs/TriggerCandidate.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TCScheduler decides which TriggerCandidates are turned into
+ * TriggerDecisions, and in which order.
+ *
+ * Each TriggerCandidate type has a priority, an optional prescale and an
+ * optional token-bucket rate limit. Candidates that pass the prescale and
+ * the rate limit are held in one FIFO per priority level. When decisions can
+ * be sent, the highest-priority candidate is handed out first. When they
+ * can't (eg because the DFO is busy), the pending candidates are trimmed to a
+ * configurable depth by shedding the lowest-priority ones first.
+ *
+ * Types that are not explicitly configured get the default TypeConfig:
+ * priority zero, no prescale and no rate limit.
+ */
+class TCScheduler
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+  using tc_type_t = triggeralgs::TriggerCandidate::Type;
+
+  struct TypeConfig
+  {
+    int priority{ 0 };
+    // Maximum long-term rate at which TCs of this type are accepted. Zero means unlimited
+    double rate_limit_hz{ 0 };
+    // Number of TCs of this type that may be accepted back-to-back before the rate limit applies
+    uint64_t burst{ 1 }; // NOLINT(build/unsigned)
+    // Only one in every `prescale` TCs of this type is considered
+    uint64_t prescale{ 1 }; // NOLINT(build/unsigned)
+  };
+
+  struct TypeCounters
+  {
+    uint64_t accepted{ 0 }; // NOLINT(build/unsigned)
+    uint64_t dropped{ 0 };  // NOLINT(build/unsigned)
+    // Candidates whose readout was already covered by earlier decisions, so no decision was sent
+    uint64_t merged{ 0 }; // NOLINT(build/unsigned)
+  };
+
+  TCScheduler() = default;
+
+  TCScheduler(TCScheduler const&) = delete;
+  TCScheduler(TCScheduler&&) = delete;
+  TCScheduler& operator=(TCScheduler const&) = delete;
+  TCScheduler& operator=(TCScheduler&&) = delete;
+
+  /**
+   * Set the per-type configuration, the maximum number of candidates held
+   * while decisions can't be sent, and the maximum time a candidate may be
+   * held for. Clears any pending candidates and counters.
+   */
+  void configure(const std::map<tc_type_t, TypeConfig>& type_configs,
+                 size_t max_pending,
+                 std::chrono::milliseconds pending_timeout);
+
+  /**
+   * Clear pending candidates, counters and rate-limiter state. Call at the start of a run
+   */
+  void reset();
+
+  /**
+   * Offer a candidate to the scheduler. Returns false if the candidate was
+   * rejected by its type's prescale or rate limit (and counted as dropped),
+   * true if it is now pending
+   */
+  bool add(const triggeralgs::TriggerCandidate& tc, clock_t::time_point now = clock_t::now());
+
+  /**
+   * Pop the highest-priority pending candidate into `tc`. Candidates that
+   * have been pending for longer than the timeout are shed rather than
+   * returned, as in shed(), and `on_shed` is called for each of them.
+   * Returns false if nothing is pending. The caller is expected to call
+   * accepted(), merged() or dropped() once it knows the candidate's fate
+   */
+  bool next(triggeralgs::TriggerCandidate& tc,
+            clock_t::time_point now = clock_t::now(),
+            const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed = nullptr);
+
+  /**
+   * Drop pending candidates, lowest priority and oldest first, until at most
+   * `depth` remain, and drop any that have exceeded the timeout.
+   * `on_shed` is called for each dropped candidate. Returns the number shed
+   */
+  size_t shed(size_t depth,
+              clock_t::time_point now = clock_t::now(),
+              const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed = nullptr);
+
+  /**
+   * Shed down to the configured maximum pending depth
+   */
+  size_t shed_to_limit(clock_t::time_point now = clock_t::now(),
+                       const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed = nullptr);
+
+  // Record the fate of a candidate of type `type` in the per-type counters
+  void accepted(tc_type_t type);
+  void merged(tc_type_t type);
+  void dropped(tc_type_t type);
+
+  size_t get_n_pending() const;
+
+  /**
+   * Snapshot of the per-type counters, for operational monitoring
+   */
+  std::map<tc_type_t, TypeCounters> get_counters() const;
+
+private:
+  struct TypeState
+  {
+    TypeConfig config;
+    TypeCounters counters;
+    uint64_t n_seen{ 0 }; // NOLINT(build/unsigned)
+    double tokens{ 0 };
+    clock_t::time_point last_refill;
+  };
+
+  struct Pending
+  {
+    triggeralgs::TriggerCandidate tc;
+    clock_t::time_point arrival;
+  };
+
+  // Find or create the state for `type`. Caller must hold m_mutex
+  TypeState& state_for(tc_type_t type);
+
+  // Shed down to `depth`, or to the configured maximum if it is empty, which
+  // is read under m_mutex along with the pending candidates
+  size_t shed_pending(std::optional<size_t> depth,
+                      clock_t::time_point now,
+                      const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed);
+
+  // Count `shed_tcs` as dropped. Caller must hold m_mutex
+  void count_shed(const std::vector<triggeralgs::TriggerCandidate>& shed_tcs);
+
+  // Call `on_shed` for each of `shed_tcs`. Called without holding m_mutex, in case the callback is slow
+  static void report_shed(const std::vector<triggeralgs::TriggerCandidate>& shed_tcs,
+                          const std::function<void(const triggeralgs::TriggerCandidate&)>& on_shed);
+
+  // Refill `state`'s token bucket and take a token if one is available
+  static bool take_token(TypeState& state, clock_t::time_point now);
+
+  bool expired(const Pending& p, clock_t::time_point now) const
+  {
+    return m_pending_timeout.count() > 0 && now - p.arrival > m_pending_timeout;
+  }
+
+  mutable std::mutex m_mutex;
+
+  std::map<tc_type_t, TypeConfig> m_type_configs;
+  std::map<tc_type_t, TypeState> m_type_states;
+
+  // Pending candidates, keyed by priority, highest first
+  std::map<int, std::deque<Pending>, std::greater<int>> m_pending;
+  size_t m_n_pending{ 0 };
+
+  size_t m_max_pending{ 0 };
+  std::chrono::milliseconds m_pending_timeout{ 0 };
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TCSCHEDULER_HPP_
@@ -0,0 +1,100 @@
+/**
+ * @file TPFile.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TPFILE_HPP_
+#define TRIGGER_SRC_TRIGGER_TPFILE_HPP_
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+#include "triggeralgs/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief Header of a binary TP file.
+ *
+ * The header is followed by `n_tps` TriggerPrimitives, sorted by time_start,
+ * written as raw structs. They are replayed front to back, so there is no
+ * time index.
+ *
+ * The TPs are the in-memory layout of this build's TriggerPrimitive, so
+ * files are only portable between builds with the same layout. `tp_size`
+ * and `version` catch the most likely mismatches.
+ */
+struct TPFileHeader
+{
+  static constexpr uint64_t s_magic = 0x31465054454e5544; // "DUNETPF1" // NOLINT(build/unsigned)
+  static constexpr uint32_t s_version = 2;                // NOLINT(build/unsigned)
+
+  uint64_t magic{ s_magic };     // NOLINT(build/unsigned)
+  uint32_t version{ s_version }; // NOLINT(build/unsigned)
+  uint32_t tp_size{ 0 };         // NOLINT(build/unsigned)
+  uint64_t n_tps{ 0 };           // NOLINT(build/unsigned)
+};
+
+/**
+ * Read the next TP from the text format that TriggerPrimitiveMaker has
+ * always read: time_start, time_over_threshold, time_peak, channel,
+ * adc_integral, adc_peak, detid and type, whitespace-separated. Returns
+ * false at the end of the input or on malformed input
+ */
+bool
+read_tp_text(std::istream& in, triggeralgs::TriggerPrimitive& tp);
+
+/**
+ * Write `tps`, which must be sorted by time_start, to a binary TP file.
+ * Throws BadTPFile on failure
+ */
+void
+write_tp_file(const std::string& filename, const std::vector<triggeralgs::TriggerPrimitive>& tps);
+
+/**
+ * @brief TPFileReader memory-maps a binary TP file, so that TPs are read
+ * from disk only as they are used, and can be sliced into TPSets without
+ * loading the whole file.
+ */
+class TPFileReader
+{
+public:
+  // Throws BadTPFile if the file can't be mapped or isn't a TP file for this build
+  explicit TPFileReader(const std::string& filename);
+  ~TPFileReader();
+
+  TPFileReader(const TPFileReader&) = delete;
+  TPFileReader& operator=(const TPFileReader&) = delete;
+  TPFileReader(TPFileReader&&) = delete;
+  TPFileReader& operator=(TPFileReader&&) = delete;
+
+  // True if `filename` starts with the binary TP file magic number
+  static bool is_tp_file(const std::string& filename);
+
+  size_t size() const { return m_header->n_tps; }
+  bool empty() const { return size() == 0; }
+  const triggeralgs::TriggerPrimitive* begin() const { return m_tps; }
+  const triggeralgs::TriggerPrimitive* end() const { return m_tps + size(); }
+
+private:
+  std::string m_filename;
+  int m_fd{ -1 };
+  void* m_map{ nullptr };
+  size_t m_map_size{ 0 };
+
+  const TPFileHeader* m_header{ nullptr };
+  const triggeralgs::TriggerPrimitive* m_tps{ nullptr };
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TPFILE_HPP_
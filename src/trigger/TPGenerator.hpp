@@ -0,0 +1,118 @@
+/**
+ * @file TPGenerator.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TPGENERATOR_HPP_
+#define TRIGGER_SRC_TRIGGER_TPGENERATOR_HPP_
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+#include "triggeralgs/Types.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TPGenerator makes synthetic TriggerPrimitives for a block of
+ * adjacent channels: uncorrelated noise on every channel, plus optional
+ * track-like and supernova-burst-like clusters.
+ *
+ * Noise, tracks and bursts each arrive as a Poisson process. Noise TPs are
+ * drawn from a single process over all the channels, so the cost is a few
+ * random numbers per TP however many channels there are. A track is one TP
+ * on each of `track_length_channels` consecutive channels, with a constant
+ * time step between channels. A burst is `burst_n_tps` low-ADC TPs spread
+ * over `burst_n_channels` channels and `burst_duration` ticks.
+ *
+ * The output only depends on the configuration, including `seed`, and not
+ * on how the time is split into calls to generate(), so runs can be
+ * reproduced exactly with the same build.
+ */
+class TPGenerator
+{
+public:
+  using channel_t = decltype(triggeralgs::TriggerPrimitive::channel);
+
+  struct Config
+  {
+    channel_t first_channel{ 0 };
+    channel_t n_channels{ 2560 };
+    uint64_t clock_frequency_hz{ 50000000 }; // NOLINT(build/unsigned)
+    uint64_t seed{ 0 };                      // NOLINT(build/unsigned)
+
+    // Per channel
+    double noise_rate_hz{ 100 };
+
+    // Zero or less disables tracks
+    double track_rate_hz{ 0 };
+    channel_t track_length_channels{ 200 };
+    // The largest time step between adjacent channels of a track
+    triggeralgs::timestamp_t track_max_ticks_per_channel{ 100 };
+
+    // Zero or less disables bursts
+    double burst_rate_hz{ 0 };
+    uint32_t burst_n_tps{ 1000 }; // NOLINT(build/unsigned)
+    channel_t burst_n_channels{ 100 };
+    triggeralgs::timestamp_t burst_duration{ 500000 };
+  };
+
+  void configure(const Config& config, triggeralgs::timestamp_t start_time);
+
+  /**
+   * Append to `tps` all the TPs with start times in [current time, `end_time`),
+   * sorted by start time, and move the current time to `end_time`. `tps` is
+   * not cleared, so the caller can reuse its allocation
+   */
+  void generate(triggeralgs::timestamp_t end_time, std::vector<triggeralgs::TriggerPrimitive>& tps);
+
+  // The expected number of TPs in `duration` ticks, for sizing buffers
+  double get_expected_n_tps(triggeralgs::timestamp_t duration) const;
+
+private:
+  triggeralgs::TriggerPrimitive make_tp(triggeralgs::timestamp_t time,
+                                        channel_t channel,
+                                        uint32_t adc_peak, // NOLINT(build/unsigned)
+                                        triggeralgs::timestamp_t time_over_threshold) const;
+  void add_track(triggeralgs::timestamp_t time);
+  void add_burst(triggeralgs::timestamp_t time);
+
+  Config m_config;
+
+  // One random number engine per process, so that the sequence of each
+  // doesn't depend on how the others are interleaved with it
+  std::mt19937_64 m_noise_gen;
+  std::mt19937_64 m_track_gen;
+  std::mt19937_64 m_burst_gen;
+
+  triggeralgs::timestamp_t m_start_time{ 0 };
+  triggeralgs::timestamp_t m_current_time{ 0 };
+
+  // Mean ticks between noise TPs over all channels, tracks and bursts. Zero if disabled
+  double m_noise_interval{ 0 };
+  double m_track_interval{ 0 };
+  double m_burst_interval{ 0 };
+
+  // Next arrival time of each process, in ticks since m_start_time. They're
+  // doubles so that intervals shorter than a tick aren't rounded away, and
+  // relative to the start so that they stay well under a tick precise
+  // however large the absolute timestamps are
+  double m_next_noise{ 0 };
+  double m_next_track{ 0 };
+  double m_next_burst{ 0 };
+
+  // TPs from tracks and bursts that started before the current time but
+  // haven't been output yet, sorted by start time
+  std::vector<triggeralgs::TriggerPrimitive> m_pending;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TPGENERATOR_HPP_
@@ -0,0 +1,155 @@
+/**
+ * @file TapFile.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TAPFILE_HPP_
+#define TRIGGER_SRC_TRIGGER_TAPFILE_HPP_
+
+#include "triggeralgs/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief A tap file holds the objects recorded from one stream by a
+ * TriggerTap module, in the order they arrived.
+ *
+ * The file starts with a TapFileHeader. Each record is a TapRecordHeader
+ * followed by `size` bytes of the serialized object. When the file is
+ * closed, a time index and a TapFileFooter are appended. Each index entry
+ * is the offset of the first record to start in a new `index_stride`-tick
+ * stride, so a reader can jump close to a time. A file whose writer didn't
+ * close it has no footer, and can only be read from the start.
+ *
+ * In version 1 files, TASets and TCSets are in their old per-field msgpack
+ * encoding. Since version 2 they are packed as overlays (see SetOverlay.hpp).
+ * Both are read back the same way.
+ */
+struct TapFileHeader
+{
+  static constexpr uint64_t s_magic = 0x31504154454e5544; // "DUNETAP1" // NOLINT(build/unsigned)
+  static constexpr uint32_t s_version = 2;                // NOLINT(build/unsigned)
+  static constexpr uint32_t s_min_version = 1;            // NOLINT(build/unsigned)
+
+  uint64_t magic{ s_magic };     // NOLINT(build/unsigned)
+  uint32_t version{ s_version }; // NOLINT(build/unsigned)
+  uint32_t reserved{ 0 };        // NOLINT(build/unsigned)
+};
+
+struct TapRecordHeader
+{
+  uint64_t start_time{ 0 }; // NOLINT(build/unsigned)
+  uint64_t end_time{ 0 };   // NOLINT(build/unsigned)
+  uint64_t size{ 0 };       // NOLINT(build/unsigned)
+};
+
+struct TapIndexEntry
+{
+  uint64_t time{ 0 };   // NOLINT(build/unsigned)
+  uint64_t offset{ 0 }; // NOLINT(build/unsigned)
+};
+
+struct TapFileFooter
+{
+  static constexpr uint64_t s_magic = 0x444e455041544e45; // "ENTAPEND" // NOLINT(build/unsigned)
+
+  uint64_t index_offset{ 0 };    // NOLINT(build/unsigned)
+  uint64_t n_index_entries{ 0 }; // NOLINT(build/unsigned)
+  uint64_t n_records{ 0 };       // NOLINT(build/unsigned)
+  uint64_t magic{ s_magic };     // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief TapFileWriter writes records to a series of tap files named
+ * `<prefix>_000000.tap`, `<prefix>_000001.tap`, ..., starting a new file
+ * when the current one reaches `max_file_bytes`. If `max_files` is nonzero,
+ * only the newest `max_files` files are kept, so that a long run can be
+ * recorded in a bounded amount of disk.
+ *
+ * All the methods throw BadTapFile if a file can't be written.
+ */
+class TapFileWriter
+{
+public:
+  TapFileWriter(const std::string& prefix,
+                size_t max_file_bytes,
+                size_t max_files,
+                triggeralgs::timestamp_t index_stride);
+  ~TapFileWriter();
+
+  TapFileWriter(const TapFileWriter&) = delete;
+  TapFileWriter& operator=(const TapFileWriter&) = delete;
+  TapFileWriter(TapFileWriter&&) = delete;
+  TapFileWriter& operator=(TapFileWriter&&) = delete;
+
+  void write(triggeralgs::timestamp_t start_time, triggeralgs::timestamp_t end_time, const char* data, size_t size);
+
+  // Write the index and footer of the current file, and close it
+  void close();
+
+  size_t get_bytes_written() const { return m_bytes_written; }
+  size_t get_files_written() const { return m_file_number; }
+
+  static std::string file_name(const std::string& prefix, size_t file_number);
+
+private:
+  void open_next();
+
+  std::string m_prefix;
+  size_t m_max_file_bytes;
+  size_t m_max_files;
+  triggeralgs::timestamp_t m_index_stride;
+
+  std::ofstream m_file;
+  std::string m_filename;
+  size_t m_file_number{ 0 };
+  size_t m_file_bytes{ 0 };
+  size_t m_n_records{ 0 };
+  std::vector<TapIndexEntry> m_index;
+  triggeralgs::timestamp_t m_next_index_time{ 0 };
+  size_t m_bytes_written{ 0 };
+};
+
+/**
+ * @brief TapFileReader reads the records of one tap file in order. Throws
+ * BadTapFile if the file can't be opened or isn't a tap file
+ */
+class TapFileReader
+{
+public:
+  explicit TapFileReader(const std::string& filename);
+
+  // Read the next record into `header` and `data`. Returns false at the end
+  // of the records, including at a record truncated by an unclean close
+  bool next(TapRecordHeader& header, std::vector<char>& data);
+
+  // Move to the last indexed record that starts at or before `time`, or to
+  // the first record if there's no index. Records after that can still
+  // start before `time` if they arrived out of order, so the caller should
+  // check their times
+  void seek(triggeralgs::timestamp_t time);
+
+  bool has_index() const { return !m_index.empty(); }
+
+private:
+  std::string m_filename;
+  std::ifstream m_file;
+  // Where the records end: the index if there's a footer, otherwise the end of the file
+  uint64_t m_records_end{ 0 }; // NOLINT(build/unsigned)
+  std::vector<TapIndexEntry> m_index;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TAPFILE_HPP_
@@ -11,11 +11,13 @@
 
 #include "trigger/Issues.hpp"
 #include "trigger/Set.hpp"
+#include "trigger/TPSliceColumns.hpp"
 
 #include "logging/Logging.hpp"
 
 #include <algorithm>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace dunedaq::trigger {
@@ -36,10 +38,12 @@ public:
   // Add a new Set<T> to the buffer. If it's inconsistent with buffered events,
   // fill time_slice, start_time, end_time with the previous (complete) slice.
   // Returns whether the previous slice was complete (and time_slice etc was filled)
+  // If `columns` is given, it is filled too: see flush()
   bool buffer(Set<T> in,
               std::vector<T>& time_slice,
               daqdataformats::timestamp_t& start_time,
-              daqdataformats::timestamp_t& end_time)
+              daqdataformats::timestamp_t& end_time,
+              TPSliceColumns* columns = nullptr)
   {
     if (m_buffer.size() == 0 || m_buffer.back().start_time == in.start_time) {
       // if `in` is the current time slice
@@ -47,37 +51,99 @@ public:
       return false; // buffer the time slice
     }
     // obtain the current (complete) time slice
-    flush(time_slice, start_time, end_time);
+    flush(time_slice, start_time, end_time, columns);
     // add `in`, which is the next time slice
     m_buffer.emplace_back(in);
     return true;
   }
-  // Fill time_slice with the sorted buffer, clear the buffer, and return true
+  // Replace time_slice with the sorted buffer, clear the buffer, and return true
   // Returns false and does nothing if the buffer is empty
-  bool flush(std::vector<T>& time_slice, daqdataformats::timestamp_t& start_time, daqdataformats::timestamp_t& end_time)
+  // For T = TriggerPrimitive, the selected fields of `columns` (if given) are
+  // also filled with the sorted slice as it is merged, reusing their storage.
+  // It is ignored for other types
+  bool flush(std::vector<T>& time_slice,
+             daqdataformats::timestamp_t& start_time,
+             daqdataformats::timestamp_t& end_time,
+             TPSliceColumns* columns = nullptr)
   {
     if (m_buffer.size() == 0) {
       return false;
     }
-    // build a vector of the T objects from all the sets in the slice
+    // TODO Benjamin Land <BenLand100@github.com> June-01-2021: would be nice if the T (TriggerPrimative, etc) included a natural ordering with operator<()
+    auto earlier = [](const T& a, const T& b) { return a.time_start < b.time_start; };
+
+    // Each set is normally time ordered already, as it comes from a single
+    // source, so the slice is a merge of the sets
     start_time = m_buffer[0].start_time;
     end_time = m_buffer[0].end_time;
+    size_t n = 0;
+    m_heads.clear();
     for (Set<T>& x : m_buffer) {
       if (x.start_time != start_time || x.end_time != end_time) {
         ers::warning(InconsistentSetTimeError(ERS_HERE, m_name, m_algorithm));
       }
-      time_slice.insert(time_slice.end(), x.objects.begin(), x.objects.end());
+      if (!std::is_sorted(x.objects.begin(), x.objects.end(), earlier)) {
+        std::sort(x.objects.begin(), x.objects.end(), earlier);
+      }
+      if (!x.objects.empty()) {
+        m_heads.push_back(Head{ x.objects.data(), x.objects.data() + x.objects.size() });
+      }
+      n += x.objects.size();
+    }
+
+    TPSliceColumns* slice_columns = nullptr;
+    if constexpr (std::is_same_v<T, triggeralgs::TriggerPrimitive>) {
+      slice_columns = columns;
+    } else {
+      (void)columns;
+    }
+    time_slice.clear();
+    time_slice.reserve(n);
+    if (slice_columns) {
+      slice_columns->resize(n);
+    }
+
+    // Min-heap of the sets' next objects
+    auto later_head = [](const Head& a, const Head& b) { return b.next->time_start < a.next->time_start; };
+    std::make_heap(m_heads.begin(), m_heads.end(), later_head);
+    while (!m_heads.empty()) {
+      std::pop_heap(m_heads.begin(), m_heads.end(), later_head);
+      Head& head = m_heads.back();
+      // Take all the objects from this set up to the next set's head at once
+      const T* until = head.end;
+      if (m_heads.size() > 1) {
+        until = std::upper_bound(head.next, head.end, *m_heads.front().next, earlier);
+      }
+      for (; head.next != until; ++head.next) {
+        if constexpr (std::is_same_v<T, triggeralgs::TriggerPrimitive>) {
+          if (slice_columns) {
+            slice_columns->set(time_slice.size(), *head.next);
+          }
+        }
+        time_slice.push_back(*head.next);
+      }
+      if (head.next == head.end) {
+        m_heads.pop_back();
+      } else {
+        std::push_heap(m_heads.begin(), m_heads.end(), later_head);
+      }
     }
+
     // clear the buffer
     m_buffer.clear();
-    // sort the vector by time_start property of T
-    std::sort(time_slice.begin(), time_slice.end(), [](const T& a, const T& b) { return a.time_start < b.time_start; });
-    // TODO Benjamin Land <BenLand100@github.com> June-01-2021: would be nice if the T (TriggerPrimative, etc) included a natural ordering with operator<()
     return true;
   }
 
 private:
+  // The unmerged part of one buffered set
+  struct Head
+  {
+    const T* next;
+    const T* end;
+  };
+
   std::vector<Set<T>> m_buffer;
+  std::vector<Head> m_heads;
   const std::string &m_name, &m_algorithm;
 };
 
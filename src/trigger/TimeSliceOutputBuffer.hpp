@@ -14,6 +14,8 @@
 
 #include "logging/Logging.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <queue>
 #include <string>
 #include <vector>
@@ -27,12 +29,31 @@ struct time_start_greater_t
   bool operator()(const T& a, const T& b) { return a.time_start > b.time_start; }
 };
 
+// Settings for adapting a TimeSliceOutputBuffer's buffer time to the data.
+// The lateness of each buffered T is how far its time_start is behind the
+// largest time_start seen before it. Every `update_interval` T, the buffer
+// time is set to the `percentile` of the lateness seen since the last update,
+// plus `margin`, limited to [min_buffer_time, max_buffer_time]
+struct AdaptiveBufferTime
+{
+  bool enabled{ false };
+  double percentile{ 0.99 };
+  daqdataformats::timestamp_t margin{ 0 };
+  daqdataformats::timestamp_t min_buffer_time{ 0 };
+  // Zero means no upper limit
+  daqdataformats::timestamp_t max_buffer_time{ 0 };
+  size_t update_interval{ 1000 };
+};
+
 // When writing Set<T> to a queue, we want to buffer all T with the same for
 // some time, to ensure that Set<T> are generated with all T from that window,
 // assuming that the T may be generated in some arbitrary, but not too tardy,
 // order. Finally, emit Set<T> for completed windows, and warn for any late
 // arriving T.
 // This class encapsulates that logic.
+//
+// How long to buffer for can either be fixed, or adapted to the lateness of
+// the T actually seen (see AdaptiveBufferTime)
 template<class T>
 class TimeSliceOutputBuffer
 {
@@ -47,19 +68,26 @@ public:
     , m_next_window_start(0)
     , m_buffer_time(buffer_time)
     , m_window_time(window_time)
+    , m_largest_time(0)
   {}
 
-  // Add a new vector<T> to the buffer.
-  void buffer(const std::vector<T>& in)
+  // Add a new vector<T> to the buffer. Returns the number of T that were
+  // discarded for being too late
+  size_t buffer(const std::vector<T>& in)
   {
+    size_t n_tardy = 0;
     if (m_next_window_start == 0) {
       // Window start time is unknown. pick it as the window that contains the
       // first element of in. Window start time must be multiples of m_window_time
       m_next_window_start = (in.front().time_start / m_window_time) * m_window_time;
     }
     for (const T& x : in) {
+      if (m_adaptive.enabled) {
+        add_lateness(m_largest_time > x.time_start ? m_largest_time - x.time_start : 0);
+      }
       if (x.time_start < m_next_window_start) {
         ers::warning(TardyOutputError(ERS_HERE, m_name, m_algorithm, x.time_start, m_next_window_start));
+        ++n_tardy;
         // x is discarded
       } else {
         m_buffer.push(x);
@@ -68,28 +96,65 @@ public:
         }
       }
     }
+    return n_tardy;
+  }
+
+  // Tell the buffer that data time has reached `now`, eg from a heartbeat,
+  // even if no T that late has been buffered. Windows that ended more than
+  // the buffer time before `now` become ready, and are passed over if
+  // nothing is buffered for them. Either way, a T that arrives for one of
+  // them afterwards is tardy, just as if a T at `now` had been buffered
+  void advance(const daqdataformats::timestamp_t now)
+  {
+    if (m_largest_time < now) {
+      m_largest_time = now;
+    }
+    skip_empty_windows();
   }
 
-  void reset() { m_next_window_start = 0; }
+  // The start of the first window that hasn't been emitted, or zero if that
+  // isn't known yet. No T earlier than this will be emitted
+  daqdataformats::timestamp_t get_next_window_start() const { return m_next_window_start; }
 
-  void set_window_time(const daqdataformats::timestamp_t window_time)
+  void reset()
   {
-    m_window_time = window_time;
-    // next window start must technically be realigned to the new multiple.
-    // this probably never matters, because m_next_window_start is 0 at conf time
-    m_next_window_start = (m_next_window_start / m_window_time) * m_window_time;
+    m_next_window_start = 0;
+    m_largest_time = 0;
+    m_lateness.clear();
   }
 
-  // Set the time to wait after a window before a window is emitted in ticks
+  // Can be changed with T still buffered. The next window still starts
+  // where the last one emitted ended, so nothing buffered is lost or sent
+  // twice, and ends at the next multiple of the new window time, so the
+  // windows after it are aligned again
+  void set_window_time(const daqdataformats::timestamp_t window_time) { m_window_time = window_time; }
+
+  // Set the time to wait after a window before a window is emitted in ticks.
+  // With adaptive buffering, this is the starting value
   void set_buffer_time(const daqdataformats::timestamp_t buffer_time) { m_buffer_time = buffer_time; }
 
-  // True if this buffer has gone m_buffer_time past the end of the first window
+  void set_adaptive(const AdaptiveBufferTime& adaptive)
+  {
+    m_adaptive = adaptive;
+    m_adaptive.update_interval = std::max<size_t>(m_adaptive.update_interval, 1);
+    m_adaptive.percentile = std::clamp(m_adaptive.percentile, 0.0, 1.0);
+    m_lateness.clear();
+    m_lateness.reserve(m_adaptive.enabled ? m_adaptive.update_interval : 0);
+    if (m_adaptive.enabled) {
+      m_buffer_time = clamp_buffer_time(m_buffer_time);
+    }
+  }
+
+  daqdataformats::timestamp_t get_buffer_time() const { return m_buffer_time; }
+
+  // True if this buffer has gone m_buffer_time past the end of the first
+  // window, either through the T buffered or through advance()
   bool ready()
   {
     if (empty()) {
       return false;
     } else {
-      return m_largest_time - (m_next_window_start + m_window_time) > m_buffer_time;
+      return m_largest_time > next_window_end() + m_buffer_time;
     }
   }
 
@@ -102,8 +167,8 @@ public:
   void flush(std::vector<T>& time_slice, daqdataformats::timestamp_t& start_time, daqdataformats::timestamp_t& end_time)
   {
     start_time = m_next_window_start;
-    end_time = m_next_window_start + m_window_time;
-    m_next_window_start = m_next_window_start + m_window_time;
+    end_time = next_window_end();
+    m_next_window_start = end_time;
     while (!m_buffer.empty() && m_buffer.top().time_start <= end_time) {
       if (m_buffer.top().time_start < start_time) {
         ers::warning(WindowlessOutputError(ERS_HERE, m_name, m_algorithm));
@@ -113,15 +178,68 @@ public:
       }
       m_buffer.pop();
     }
+    skip_empty_windows();
   }
 
 private:
+  // Window starts are multiples of m_window_time, unless the window time
+  // was changed part way through (see set_window_time)
+  daqdataformats::timestamp_t next_window_end() const
+  {
+    return (m_next_window_start / m_window_time + 1) * m_window_time;
+  }
+
+  // With nothing buffered, move the next window start past the windows that
+  // are already complete, so that it keeps up with data time
+  void skip_empty_windows()
+  {
+    if (!empty() || m_largest_time <= m_buffer_time + 1) {
+      return;
+    }
+    // The first window that isn't complete yet
+    daqdataformats::timestamp_t first_incomplete = (m_largest_time - m_buffer_time - 1) / m_window_time * m_window_time;
+    m_next_window_start = std::max(m_next_window_start, first_incomplete);
+  }
+
+  void add_lateness(daqdataformats::timestamp_t lateness)
+  {
+    m_lateness.push_back(lateness);
+    if (m_lateness.size() < m_adaptive.update_interval) {
+      return;
+    }
+    // nth_element is linear in the number of samples, so this is cheap
+    // compared to sorting, and the samples are thrown away afterwards anyway
+    auto nth = m_lateness.begin() + static_cast<size_t>(m_adaptive.percentile * (m_lateness.size() - 1));
+    std::nth_element(m_lateness.begin(), nth, m_lateness.end());
+    daqdataformats::timestamp_t buffer_time = *nth;
+    buffer_time += std::min(m_adaptive.margin, std::numeric_limits<daqdataformats::timestamp_t>::max() - buffer_time);
+    buffer_time = clamp_buffer_time(buffer_time);
+    if (buffer_time != m_buffer_time) {
+      TLOG_DEBUG(2) << m_name << ": " << m_algorithm << " output buffer time changed from " << m_buffer_time << " to "
+                    << buffer_time;
+      m_buffer_time = buffer_time;
+    }
+    m_lateness.clear();
+  }
+
+  daqdataformats::timestamp_t clamp_buffer_time(daqdataformats::timestamp_t buffer_time) const
+  {
+    buffer_time = std::max(buffer_time, m_adaptive.min_buffer_time);
+    if (m_adaptive.max_buffer_time != 0) {
+      buffer_time = std::min(buffer_time, m_adaptive.max_buffer_time);
+    }
+    return buffer_time;
+  }
+
   std::priority_queue<T, std::vector<T>, time_start_greater_t<T>> m_buffer;
   const std::string &m_name, &m_algorithm;
   daqdataformats::timestamp_t m_next_window_start; // tick start of next window, or 0 if not yet known
   daqdataformats::timestamp_t m_buffer_time;       // ticks to buffer after a window before a window is valid
   daqdataformats::timestamp_t m_window_time;       // width of output windows in ticks
-  daqdataformats::timestamp_t m_largest_time;      // larges observed timestamp
+  daqdataformats::timestamp_t m_largest_time;      // larges observed timestamp, or time passed to advance()
+
+  AdaptiveBufferTime m_adaptive;
+  std::vector<daqdataformats::timestamp_t> m_lateness; // lateness samples since the last buffer time update
 };
 
 } // namespace dunedaq::trigger
@@ -0,0 +1,127 @@
+/**
+ * @file TriggerActivityMakerADCSimpleWindowFast.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERADCSIMPLEWINDOWFAST_HPP_
+#define TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERADCSIMPLEWINDOWFAST_HPP_
+
+#include "trigger/ADCWindowKernel.hpp"
+#include "trigger/TPSliceColumns.hpp"
+
+#include "triggeralgs/ADCSimpleWindow/TriggerActivityMakerADCSimpleWindow.hpp"
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TriggerActivityMaker with the same behaviour as
+ * triggeralgs::TriggerActivityMakerADCSimpleWindow, plus an optional fast
+ * path that processes a whole time slice at once.
+ *
+ * By default, every TriggerPrimitive is passed on to the triggeralgs
+ * implementation. With "fast_path" set to true in the configuration, the
+ * windows are instead found from the time_start and adc_integral columns of
+ * the slice, with the kernels in ADCWindowKernel.hpp, which use AVX2 when
+ * the CPU has it and "use_avx2" isn't set to false.
+ *
+ * The two paths produce identical TriggerActivities.
+ */
+class TriggerActivityMakerADCSimpleWindowFast : public triggeralgs::TriggerActivityMaker
+{
+public:
+  using triggeralgs::TriggerActivityMaker::operator();
+
+  void operator()(const triggeralgs::TriggerPrimitive& input, std::vector<triggeralgs::TriggerActivity>& output) override;
+
+  /**
+   * Process the time-ordered TriggerPrimitives in [first, last). Called
+   * once per time slice by TriggerGenericMaker
+   */
+  void operator()(const triggeralgs::TriggerPrimitive* first,
+                  const triggeralgs::TriggerPrimitive* last,
+                  std::vector<triggeralgs::TriggerActivity>& output);
+
+  /**
+   * As above, with the time_start and adc_integral columns of [first, last)
+   * already filled in by TimeSliceInputBuffer. The columns are scanned where
+   * they are, without copying them
+   */
+  void operator()(const TPSliceColumns& columns,
+                  const triggeralgs::TriggerPrimitive* first,
+                  const triggeralgs::TriggerPrimitive* last,
+                  std::vector<triggeralgs::TriggerActivity>& output);
+
+  // The columns that the fast path reads. The reference path reads none
+  TPSliceColumns::fields_t get_column_fields() const
+  {
+    return m_fast_path ? (TPSliceColumns::kTimeStart | TPSliceColumns::kAdcIntegral) : 0;
+  }
+
+  void configure(const nlohmann::json& config) override;
+
+  bool fast_path_enabled() const { return m_fast_path; }
+
+private:
+  // Find the windows in the carried-over window followed by the slice
+  // [first, first + columns.size())
+  void process(const TPSliceColumns& columns,
+               const triggeralgs::TriggerPrimitive* first,
+               std::vector<triggeralgs::TriggerActivity>& output);
+
+  // Primitive `i`, counting from the start of the carried-over window
+  const triggeralgs::TriggerPrimitive& tp_at(size_t i, const triggeralgs::TriggerPrimitive* first) const
+  {
+    return i < m_window_tps.size() ? m_window_tps[i] : first[i - m_window_tps.size()];
+  }
+
+  // Start time of primitive `i`, counting as tp_at does
+  uint64_t time_at(size_t i, const uint64_t* slice_times) const // NOLINT(build/unsigned)
+  {
+    return i < m_window_tps.size() ? m_window_tps[i].time_start : slice_times[i - m_window_tps.size()];
+  }
+
+  triggeralgs::TriggerActivity construct_ta(size_t begin,
+                                            size_t end,
+                                            const triggeralgs::TriggerPrimitive* first,
+                                            const uint64_t* slice_times) const; // NOLINT(build/unsigned)
+
+  // Make the primitives from `begin` onwards the new carried-over window
+  void compact(size_t begin, const triggeralgs::TriggerPrimitive* first);
+
+  triggeralgs::TriggerActivityMakerADCSimpleWindow m_reference;
+
+  bool m_fast_path{ false };
+  bool m_use_simd{ true };
+  uint64_t m_window_length{ 0 }; // NOLINT(build/unsigned)
+  uint64_t m_adc_threshold{ 0 }; // NOLINT(build/unsigned)
+
+  // The primitives in the window carried over from the previous slice
+  std::vector<triggeralgs::TriggerPrimitive> m_window_tps;
+  std::vector<triggeralgs::TriggerPrimitive> m_scratch_tps;
+
+  // Columns of slices passed without them
+  TPSliceColumns m_columns{ TPSliceColumns::kTimeStart | TPSliceColumns::kAdcIntegral };
+
+  // Prefix sums of adc_integral over the carried-over window followed by the
+  // slice being processed. These are kept between calls to avoid
+  // reallocating for every slice
+  std::vector<uint64_t> m_adc_prefix; // NOLINT(build/unsigned)
+  std::vector<adcwindow::Window> m_windows;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERADCSIMPLEWINDOWFAST_HPP_
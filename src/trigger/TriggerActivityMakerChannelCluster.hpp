@@ -0,0 +1,119 @@
+/**
+ * @file TriggerActivityMakerChannelCluster.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERCHANNELCLUSTER_HPP_
+#define TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERCHANNELCLUSTER_HPP_
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TriggerActivityMaker that groups TriggerPrimitives which are close
+ * in both time and channel, and makes a TriggerActivity from each group that
+ * is big enough.
+ *
+ * A TP joins a cluster if the cluster has a TP on one of the new TP's
+ * neighbouring channels that started no more than `time_window` ticks
+ * earlier. If the TP is adjacent to several clusters, they are merged. A
+ * cluster is closed once `time_window` ticks have passed since its last TP,
+ * and it becomes a TriggerActivity if it has at least `min_tps` TPs and a
+ * summed adc_integral of at least `min_adc`. Smaller clusters, such as
+ * isolated noise hits, are dropped.
+ *
+ * The neighbours of a channel are the channels within `channel_tolerance`
+ * of it. If `channel_groups` is given (a list of [first, last] channel
+ * ranges, eg one per readout plane), neighbours must also be in the same
+ * group, and the neighbour table for all of the grouped channels is built
+ * once at configuration time. Otherwise each channel's neighbours are
+ * worked out the first time it is seen.
+ *
+ * At most `max_active_clusters` clusters are open at any time. When another
+ * is needed, the one that has gone longest without a new TP is closed early.
+ *
+ * TriggerActivities are produced up to `time_window` ticks after their last
+ * TP, so the TriggerActivityMaker module's buffer_time should be at least the
+ * longest expected cluster duration plus `time_window`.
+ */
+class TriggerActivityMakerChannelCluster : public triggeralgs::TriggerActivityMaker
+{
+public:
+  void operator()(const triggeralgs::TriggerPrimitive& input, std::vector<triggeralgs::TriggerActivity>& output) override;
+
+  void flush(triggeralgs::timestamp_t until, std::vector<triggeralgs::TriggerActivity>& output) override;
+
+  void configure(const nlohmann::json& config) override;
+
+  size_t get_n_active_clusters() const { return m_n_active; }
+
+private:
+  using channel_t = decltype(triggeralgs::TriggerPrimitive::channel);
+
+  struct Cluster
+  {
+    std::vector<triggeralgs::TriggerPrimitive> tps;
+    triggeralgs::timestamp_t last_time{ 0 };
+    uint64_t adc_integral{ 0 }; // NOLINT(build/unsigned)
+    // Incremented whenever the slot is reused, so that stale index entries can be spotted
+    uint32_t generation{ 0 }; // NOLINT(build/unsigned)
+    bool active{ false };
+  };
+
+  // The cluster that last had a TP on a channel, and the time of that TP
+  struct IndexEntry
+  {
+    size_t slot;
+    uint32_t generation; // NOLINT(build/unsigned)
+    triggeralgs::timestamp_t time;
+  };
+
+  const std::vector<channel_t>& neighbours(channel_t channel);
+  std::vector<channel_t> make_neighbours(channel_t channel) const;
+
+  // Close every cluster whose last TP is more than m_time_window before `time`
+  void close_older_than(triggeralgs::timestamp_t time, std::vector<triggeralgs::TriggerActivity>& output);
+  void close(size_t slot, std::vector<triggeralgs::TriggerActivity>& output);
+  size_t open_slot(std::vector<triggeralgs::TriggerActivity>& output);
+  void merge_into(size_t target, size_t source);
+
+  triggeralgs::TriggerActivity construct_ta(const Cluster& cluster) const;
+
+  triggeralgs::timestamp_t m_time_window{ 50 };
+  channel_t m_channel_tolerance{ 1 };
+  size_t m_min_tps{ 2 };
+  uint64_t m_min_adc{ 0 }; // NOLINT(build/unsigned)
+  size_t m_max_active_clusters{ 64 };
+  // Sorted, non-overlapping [first, last] channel ranges. Empty means no restriction
+  std::vector<std::pair<channel_t, channel_t>> m_channel_groups;
+
+  std::unordered_map<channel_t, std::vector<channel_t>> m_neighbours;
+  std::unordered_map<channel_t, IndexEntry> m_channel_index;
+
+  std::vector<Cluster> m_clusters;
+  std::vector<size_t> m_free_slots;
+  size_t m_n_active{ 0 };
+  // Earliest time at which some active cluster can be closed
+  triggeralgs::timestamp_t m_next_close_time{ 0 };
+  // Scratch list of the clusters adjacent to the TP being processed
+  std::vector<size_t> m_adjacent;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERCHANNELCLUSTER_HPP_
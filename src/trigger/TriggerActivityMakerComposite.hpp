@@ -0,0 +1,141 @@
+/**
+ * @file TriggerActivityMakerComposite.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERCOMPOSITE_HPP_
+#define TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERCOMPOSITE_HPP_
+
+#include "trigger/AlgorithmDispatch.hpp"
+#include "trigger/OutputRouter.hpp"
+#include "trigger/TPSliceColumns.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TriggerActivityMaker that runs several other TriggerActivityMakers
+ * on the same input, so that one TriggerActivityMaker module can run several
+ * algorithms on one buffered and sorted copy of each time slice.
+ *
+ * Each time slice is passed to every maker in turn, through the maker's typed
+ * slice processor if it has one, and their outputs are appended in the order
+ * the makers were added. The composite asks for the TPSliceColumns fields
+ * that any of its makers read, and passes the caller's columns on to them.
+ * With `parallel` set, the makers after the first run on a pool of threads,
+ * one per maker, that is started with the composite and kept until it is
+ * destroyed, while the first runs on the calling thread.
+ *
+ * Each maker has a route (see OutputRouter). The outputs of makers on route 0
+ * go into the output vector, and the others are kept for take_outputs, so
+ * that the module can send them to separate output queues
+ */
+class TriggerActivityMakerComposite
+  : public triggeralgs::TriggerActivityMaker
+  , public OutputRouter<triggeralgs::TriggerActivity>
+{
+public:
+  // `routes` has the route of each maker, and may be empty to put all of them on route 0
+  TriggerActivityMakerComposite(std::vector<std::shared_ptr<triggeralgs::TriggerActivityMaker>> makers,
+                                bool parallel,
+                                std::vector<size_t> routes = {});
+
+  ~TriggerActivityMakerComposite();
+
+  TriggerActivityMakerComposite(const TriggerActivityMakerComposite&) = delete;
+  TriggerActivityMakerComposite& operator=(const TriggerActivityMakerComposite&) = delete;
+  TriggerActivityMakerComposite(TriggerActivityMakerComposite&&) = delete;
+  TriggerActivityMakerComposite& operator=(TriggerActivityMakerComposite&&) = delete;
+
+  using triggeralgs::TriggerActivityMaker::operator();
+
+  void operator()(const triggeralgs::TriggerPrimitive& input, std::vector<triggeralgs::TriggerActivity>& output) override;
+
+  void operator()(const triggeralgs::TriggerPrimitive* first,
+                  const triggeralgs::TriggerPrimitive* last,
+                  std::vector<triggeralgs::TriggerActivity>& output);
+
+  void operator()(const TPSliceColumns& columns,
+                  const triggeralgs::TriggerPrimitive* first,
+                  const triggeralgs::TriggerPrimitive* last,
+                  std::vector<triggeralgs::TriggerActivity>& output);
+
+  // The fields read by any of the makers
+  TPSliceColumns::fields_t get_column_fields() const { return m_column_fields; }
+
+  void flush(triggeralgs::timestamp_t until, std::vector<triggeralgs::TriggerActivity>& output) override;
+
+  void take_outputs(size_t route, std::vector<triggeralgs::TriggerActivity>& output) override;
+
+  size_t get_n_makers() const { return m_makers.size(); }
+
+  // The number of routes other than route 0
+  size_t get_n_routes() const { return m_routed.size(); }
+
+private:
+  struct Maker
+  {
+    std::shared_ptr<triggeralgs::TriggerActivityMaker> maker;
+    TASliceProcessorRegistry::processor_t processor;
+    bool uses_columns{ false };
+    size_t route{ 0 };
+    std::vector<triggeralgs::TriggerActivity> output;
+    // What the maker threw on a pool thread, for the calling thread to rethrow
+    std::exception_ptr error;
+  };
+
+  void run_all(const triggeralgs::TriggerPrimitive* first,
+               const triggeralgs::TriggerPrimitive* last,
+               const TPSliceColumns* columns,
+               std::vector<triggeralgs::TriggerActivity>& output);
+
+  void run(Maker& maker,
+           const triggeralgs::TriggerPrimitive* first,
+           const triggeralgs::TriggerPrimitive* last,
+           const TPSliceColumns* columns);
+
+  // Where the outputs of `maker` go, given the output vector for route 0
+  std::vector<triggeralgs::TriggerActivity>& destination(const Maker& maker,
+                                                         std::vector<triggeralgs::TriggerActivity>& output);
+
+  void run_pool_thread(size_t index);
+
+  std::vector<Maker> m_makers;
+
+  // Kept-back outputs for routes 1 and up, at index route - 1
+  std::vector<std::vector<triggeralgs::TriggerActivity>> m_routed;
+
+  TPSliceColumns::fields_t m_column_fields{ 0 };
+
+  // The pool runs m_makers[1..] on the current slice each time m_generation
+  // is incremented, and counts m_n_running down to zero when done
+  std::vector<std::thread> m_pool;
+  std::mutex m_pool_mutex;
+  std::condition_variable m_start_cv;
+  std::condition_variable m_done_cv;
+  size_t m_generation{ 0 };
+  size_t m_n_running{ 0 };
+  bool m_shutdown{ false };
+  const triggeralgs::TriggerPrimitive* m_first{ nullptr };
+  const triggeralgs::TriggerPrimitive* m_last{ nullptr };
+  const TPSliceColumns* m_slice_columns{ nullptr };
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERCOMPOSITE_HPP_
@@ -9,8 +9,14 @@
 #ifndef TRIGGER_SRC_TRIGGER_TRIGGERGENERICMAKER_HPP_
 #define TRIGGER_SRC_TRIGGER_TRIGGERGENERICMAKER_HPP_
 
+#include "trigger/AlgorithmDispatch.hpp"
+#include "trigger/InterruptibleSource.hpp"
 #include "trigger/Issues.hpp"
+#include "trigger/OutputRouter.hpp"
 #include "trigger/Set.hpp"
+#include "trigger/SliceProcessing.hpp"
+#include "trigger/StopSignal.hpp"
+#include "trigger/TPSliceColumns.hpp"
 #include "trigger/TimeSliceInputBuffer.hpp"
 #include "trigger/TimeSliceOutputBuffer.hpp"
 
@@ -26,7 +32,10 @@
 #include "detdataformats/trigger/Types.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -63,6 +72,7 @@ public:
     register_command("start", &TriggerGenericMaker::do_start);
     register_command("stop", &TriggerGenericMaker::do_stop);
     register_command("conf", &TriggerGenericMaker::do_configure);
+    register_command("reconfigure", &TriggerGenericMaker::do_reconfigure);
   }
 
   virtual ~TriggerGenericMaker() {}
@@ -76,30 +86,70 @@ public:
   {
     m_input_queue.reset(new source_t(appfwk::queue_inst(obj, "input")));
     m_output_queue.reset(new sink_t(appfwk::queue_inst(obj, "output")));
+    // The maker's config may send some outputs to other queues, see set_output_queues
+    m_queues = appfwk::queue_index(obj);
   }
 
 protected:
-  void set_algorithm_name(const std::string& name) { m_algorithm_name = name; }
+  // These setters may only be called from make_maker. They stage their
+  // values until the maker they go with is applied
+  void set_algorithm_name(const std::string& name) { m_staging->algorithm_name = name; }
 
   // Only applies to makers that output Set<B>
   void set_geoid(uint16_t region_id, uint32_t element_id) // NOLINT(build/unsigned)
   {
-    m_geoid_region_id = region_id;
-    m_geoid_element_id = element_id;
+    m_staging->geoid_region_id = region_id;
+    m_staging->geoid_element_id = element_id;
   }
 
   // Only applies to makers that output Set<B>
   void set_windowing(daqdataformats::timestamp_t window_time, daqdataformats::timestamp_t buffer_time)
   {
-    m_window_time = window_time;
-    m_buffer_time = buffer_time;
+    m_staging->window_time = window_time;
+    m_staging->buffer_time = buffer_time;
+  }
+
+  // Only applies to makers that output Set<B>. buffer_time from set_windowing
+  // is the starting point when the buffer time is adaptive
+  void set_adaptive_buffer(const AdaptiveBufferTime& adaptive_buffer) { m_staging->adaptive_buffer = adaptive_buffer; }
+
+  // Only applies to makers that output Set<B> and are OutputRouters. The
+  // names of the module's queues for the maker's routes 1 and up, which get
+  // their own windows and heartbeats like the main output queue
+  void set_output_queues(const std::vector<std::string>& names)
+  {
+    m_staging->output_queues.clear();
+    for (auto& name : names) {
+      auto queue = m_queues.find(name);
+      if (queue == m_queues.end()) {
+        throw UnknownOutputQueue(ERS_HERE, get_name(), name);
+      }
+      m_staging->output_queues.push_back(queue->second.inst);
+    }
+  }
+
+  // Counters and the current output buffer time, for operational monitoring
+  size_t get_received_count() const { return m_received_count.load(); }
+  size_t get_sent_count() const { return m_sent_count.load(); }
+  size_t get_tardy_count() const { return m_tardy_count.load(); }
+  daqdataformats::timestamp_t get_current_buffer_time() const { return m_current_buffer_time.load(); }
+
+  // The maker in use, for operational monitoring from other threads
+  std::shared_ptr<MAKER> get_maker() const
+  {
+    std::lock_guard<std::mutex> lk(m_maker_mutex);
+    return m_maker;
   }
 
 private:
   dunedaq::utilities::WorkerThread m_thread;
+  StopSignal m_stop_signal;
 
-  size_t m_received_count;
-  size_t m_sent_count;
+  std::atomic<size_t> m_received_count{ 0 };
+  std::atomic<size_t> m_sent_count{ 0 };
+  // Outputs dropped by the output buffer for being too late for their window
+  std::atomic<size_t> m_tardy_count{ 0 };
+  std::atomic<daqdataformats::timestamp_t> m_current_buffer_time{ 0 };
 
   using source_t = dunedaq::appfwk::DAQSource<IN>;
   std::unique_ptr<source_t> m_input_queue;
@@ -107,6 +157,9 @@ private:
   using sink_t = dunedaq::appfwk::DAQSink<OUT>;
   std::unique_ptr<sink_t> m_output_queue;
 
+  // All the queues given to init, by name
+  std::map<std::string, appfwk::QueueInfo> m_queues;
+
   std::chrono::milliseconds m_queue_timeout;
 
   std::string m_algorithm_name;
@@ -116,8 +169,42 @@ private:
 
   daqdataformats::timestamp_t m_buffer_time;
   daqdataformats::timestamp_t m_window_time;
+  AdaptiveBufferTime m_adaptive_buffer;
+  // Queue instances for the maker's routes 1 and up
+  std::vector<std::string> m_output_queues;
 
+  // Only the worker thread changes m_maker during a run, so it reads it
+  // without locking. Everything else goes through get_maker()
   std::shared_ptr<MAKER> m_maker;
+  mutable std::mutex m_maker_mutex;
+
+  // A maker together with the settings from make_maker that go with it.
+  // The defaults match the initial values of the settings above
+  struct MakerConfig
+  {
+    std::shared_ptr<MAKER> maker;
+    std::string algorithm_name{ "[uninitialized]" };
+    uint16_t geoid_region_id{ dunedaq::daqdataformats::GeoID::s_invalid_region_id };   // NOLINT(build/unsigned)
+    uint32_t geoid_element_id{ dunedaq::daqdataformats::GeoID::s_invalid_element_id }; // NOLINT(build/unsigned)
+    daqdataformats::timestamp_t buffer_time{ 0 };
+    daqdataformats::timestamp_t window_time{ 625000 };
+    AdaptiveBufferTime adaptive_buffer;
+    std::vector<std::string> output_queues;
+  };
+
+  // The settings above belong to the worker thread while it's running. The
+  // command thread keeps its own copy of the settings from the last conf or
+  // reconfigure, which new makers start from, so it never reads them
+  std::mutex m_stage_mutex;
+  MakerConfig m_latest;
+  // The local config that the setters fill in during make_maker
+  MakerConfig* m_staging = nullptr;
+
+  // Set by a reconfigure command during a run, and swapped in by the worker
+  // thread at the next point where the current maker has been flushed
+  std::mutex m_pending_mutex;
+  std::unique_ptr<MakerConfig> m_pending;
+  std::atomic<bool> m_has_pending{ false };
 
   TriggerGenericWorker<IN, OUT, MAKER> worker;
 
@@ -129,52 +216,135 @@ private:
   {
     m_received_count = 0;
     m_sent_count = 0;
+    m_tardy_count = 0;
+    m_stop_signal.reset();
+    // A reconfigure that arrived as the last run was ending
+    if (swap_pending()) {
+      worker.reconfigure();
+    }
     m_thread.start_working_thread();
   }
 
-  void do_stop(const nlohmann::json& /*obj*/) { m_thread.stop_working_thread(); }
+  void do_stop(const nlohmann::json& /*obj*/)
+  {
+    m_stop_signal.request_stop();
+    m_thread.stop_working_thread();
+  }
 
   void do_configure(const nlohmann::json& obj)
   {
-    m_maker = make_maker(obj);
+    apply(stage(obj));
     // worker should be notified that configuration potentially changed
     worker.reconfigure();
   }
 
-  void do_work(std::atomic<bool>& running_flag)
+  // Replace the maker during a run. The new maker is created and configured
+  // here, on the command thread, so that the plugin loading and algorithm
+  // setup happen off the data path. The worker thread swaps it in once the
+  // current maker has been flushed (see swap_pending), so that no window is
+  // lost and buffered inputs are kept
+  void do_reconfigure(const nlohmann::json& obj)
   {
-    // Loop until a stop is received
-    while (running_flag.load()) {
-      // While there are items in the input queue, continue draining even if
-      // the running_flag is false, but stop _immediately_ when input is empty
-      IN in;
-      while (receive(in)) {
-        worker.process(in);
-      }
+    if (!m_thread.thread_running()) {
+      do_configure(obj);
+      return;
     }
-    worker.drain();
-    TLOG() << ": Exiting do_work() method, received " << m_received_count << " inputs and successfully sent "
-           << m_sent_count << " outputs. ";
-    worker.reset();
+
+    auto config = std::make_unique<MakerConfig>(stage(obj));
+    const std::string algorithm_name = config->algorithm_name;
+    {
+      std::lock_guard<std::mutex> lk(m_pending_mutex);
+      m_pending = std::move(config);
+      m_has_pending.store(true);
+    }
+    TLOG() << get_name() << ": new " << algorithm_name
+           << " maker is ready, and will replace the current one at the next heartbeat";
   }
 
-  bool receive(IN& in)
+  // Make a new maker, starting from the latest settings so that any the
+  // maker doesn't set are kept
+  MakerConfig stage(const nlohmann::json& obj)
   {
+    std::lock_guard<std::mutex> lk(m_stage_mutex);
+    MakerConfig config = m_latest;
+    m_staging = &config;
     try {
-      m_input_queue->pop(in, m_queue_timeout);
-    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-      // it is perfectly reasonable that there might be no data in the queue
-      // some fraction of the times that we check, so we just continue on and try again
+      config.maker = make_maker(obj);
+    } catch (...) {
+      m_staging = nullptr;
+      throw;
+    }
+    m_staging = nullptr;
+    m_latest = config;
+    m_latest.maker.reset();
+    return config;
+  }
+
+  void apply(const MakerConfig& config)
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_maker_mutex);
+      m_maker = config.maker;
+    }
+    m_algorithm_name = config.algorithm_name;
+    m_geoid_region_id = config.geoid_region_id;
+    m_geoid_element_id = config.geoid_element_id;
+    m_buffer_time = config.buffer_time;
+    m_window_time = config.window_time;
+    m_adaptive_buffer = config.adaptive_buffer;
+    m_output_queues = config.output_queues;
+  }
+
+  // Called by the worker at a point where the current maker has been
+  // flushed. Returns true if a new maker was swapped in, in which case the
+  // worker should pick up any changed settings
+  bool swap_pending()
+  {
+    if (!m_has_pending.load()) {
       return false;
     }
-    ++m_received_count;
+    std::unique_ptr<MakerConfig> config;
+    {
+      std::lock_guard<std::mutex> lk(m_pending_mutex);
+      config = std::move(m_pending);
+      m_has_pending.store(false);
+    }
+    if (!config) {
+      return false;
+    }
+    apply(*config);
+    TLOG() << get_name() << ": swapped in new " << m_algorithm_name << " maker";
     return true;
   }
 
-  bool send(const OUT& out)
+  void do_work(std::atomic<bool>& /*running_flag*/)
+  {
+    // Keep going until a stop is received and the input queue is empty.
+    // While there are items in the input queue, continue draining even after
+    // the stop, but stop _immediately_ when input is empty
+    InterruptibleSource<IN> input(*m_input_queue, m_stop_signal);
+    IN in;
+    while (input.pop(in)) {
+      ++m_received_count;
+      worker.process(in);
+    }
+    worker.drain();
+    TLOG() << ": Exiting do_work() method, received " << m_received_count.load() << " inputs and successfully sent "
+           << m_sent_count.load() << " outputs. ";
+    worker.reset();
+    // A reconfigure that arrived too late to be swapped in during the run
+    // applies to the next one
+    if (swap_pending()) {
+      worker.reconfigure();
+    }
+  }
+
+  bool send(const OUT& out) { return send(out, *m_output_queue); }
+
+  bool send(const OUT& out, sink_t& queue)
   {
     try {
-      m_output_queue->push(out, m_queue_timeout);
+      queue.push(out, m_queue_timeout);
     } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
       ers::warning(excpt);
       return false;
@@ -208,6 +378,9 @@ public:
 
   void process(IN& in)
   {
+    // Each input is processed independently, so we can swap makers between any two inputs
+    m_parent.swap_pending();
+
     std::vector<OUT> out_vec; // one input -> many outputs
     try {
       m_parent.m_maker->operator()(in, out_vec);
@@ -243,41 +416,175 @@ public: // NOLINT
 
   TriggerGenericMaker<Set<A>, Set<B>, MAKER>& m_parent;
 
+  using sink_t = typename TriggerGenericMaker<Set<A>, Set<B>, MAKER>::sink_t;
+  using seqno_t = typename Set<B>::seqno_t;
+
   TimeSliceInputBuffer<A> m_in_buffer;
   TimeSliceOutputBuffer<B> m_out_buffer;
+  seqno_t m_seqno = 0;
+
+  // An output queue for one of the maker's routes 1 and up, windowed
+  // separately from the main output queue
+  struct RoutedOutput
+  {
+    RoutedOutput(TriggerGenericMaker<Set<A>, Set<B>, MAKER>& parent, const std::string& instance)
+      : instance(instance)
+      , queue(new sink_t(instance))
+      , buffer(parent.get_name(), parent.m_algorithm_name, parent.m_buffer_time)
+    {}
+
+    std::string instance;
+    std::unique_ptr<sink_t> queue;
+    TimeSliceOutputBuffer<B> buffer;
+    seqno_t seqno = 0;
+  };
+  std::vector<std::unique_ptr<RoutedOutput>> m_routed;
+
+  // The maker, if it sends outputs to more than one queue
+  OutputRouter<B>* m_router = nullptr;
 
   daqdataformats::timestamp_t m_prev_start_time = 0;
 
+  // Typed processor for the maker's concrete class, or nullptr if it doesn't have one
+  void (*m_processor)(MAKER&, const A*, const A*, const TPSliceColumns*, std::vector<B>&) = nullptr;
+
+  // Column view of the current slice, filled by m_in_buffer as it merges
+  // the slice, with only the fields the maker asks for. Reused for every slice
+  TPSliceColumns m_columns;
+  bool m_use_columns = false;
+
   void reconfigure()
   {
-    m_out_buffer.set_window_time(m_parent.m_window_time);
-    m_out_buffer.set_buffer_time(m_parent.m_buffer_time);
+    configure_buffer(m_out_buffer);
+    m_parent.m_current_buffer_time = m_out_buffer.get_buffer_time();
+    m_processor = m_parent.m_maker ? find_slice_processor<MAKER, A, B>(*m_parent.m_maker) : nullptr;
+    const TPSliceColumns::fields_t column_fields =
+      m_processor ? slice_processor_column_fields<MAKER, A, B>(*m_parent.m_maker) : 0;
+    m_use_columns = column_fields != 0;
+    m_columns.set_fields(column_fields);
+    m_router = dynamic_cast<OutputRouter<B>*>(m_parent.m_maker.get());
+
+    // Keep the windows of the routed queues that are still in use, and send
+    // what the others have left, since nothing more will come for them
+    std::vector<std::unique_ptr<RoutedOutput>> routed;
+    for (auto& instance : m_parent.m_output_queues) {
+      auto it = std::find_if(m_routed.begin(), m_routed.end(), [&instance](const std::unique_ptr<RoutedOutput>& r) {
+        return r && r->instance == instance;
+      });
+      if (it != m_routed.end()) {
+        routed.push_back(std::move(*it));
+      } else {
+        routed.push_back(std::make_unique<RoutedOutput>(m_parent, instance));
+      }
+      configure_buffer(routed.back()->buffer);
+    }
+    for (auto& r : m_routed) {
+      if (r) {
+        send_windows(r->buffer, *r->queue, r->seqno, true);
+      }
+    }
+    m_routed = std::move(routed);
+  }
+
+  void configure_buffer(TimeSliceOutputBuffer<B>& buffer)
+  {
+    buffer.set_window_time(m_parent.m_window_time);
+    buffer.set_buffer_time(m_parent.m_buffer_time);
+    buffer.set_adaptive(m_parent.m_adaptive_buffer);
   }
 
+  TPSliceColumns* columns() { return m_use_columns ? &m_columns : nullptr; }
+
   void reset()
   {
     m_prev_start_time = 0;
     m_out_buffer.reset();
+    m_seqno = 0;
+    for (auto& r : m_routed) {
+      r->buffer.reset();
+      r->seqno = 0;
+    }
   }
 
   void process_slice(const std::vector<A>& time_slice, std::vector<B>& out_vec)
   {
-    // time_slice is a full slice (all Set<A> combined), time ordered, vector of A
-    // call operator for each of the objects in the vector
-    for (const A& x : time_slice) {
-      try {
-        m_parent.m_maker->operator()(x, out_vec);
-      } catch (...) { // NOLINT TODO Benjamin Land <BenLand100@github.com> May 28-2021 can we restrict the possible
-                      // exceptions triggeralgs might raise?
-        ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
-        return;
+    // time_slice is a full slice (all Set<A> combined), time ordered, vector of A.
+    // If the plugin registered a typed processor, hand it the whole slice,
+    // otherwise call operator for each of the objects in the vector
+    try {
+      trigger::process_slice(*m_parent.m_maker, m_processor, time_slice, columns(), out_vec);
+    } catch (...) { // NOLINT TODO Benjamin Land <BenLand100@github.com> May 28-2021 can we restrict the possible
+                    // exceptions triggeralgs might raise?
+      ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
+      return;
+    }
+  }
+
+  // Move the outputs the maker kept back for its other routes into their buffers
+  void buffer_routed()
+  {
+    if (!m_router) {
+      return;
+    }
+    for (size_t i = 0; i < m_routed.size(); ++i) {
+      std::vector<B> elems;
+      m_router->take_outputs(i + 1, elems);
+      if (elems.size() > 0) {
+        m_parent.m_tardy_count += m_routed[i]->buffer.buffer(elems);
       }
     }
   }
 
+  // Send the windows that `buffer` has ready, or everything it has when draining
+  void send_windows(TimeSliceOutputBuffer<B>& buffer, sink_t& queue, seqno_t& seqno, bool draining)
+  {
+    while (draining ? !buffer.empty() : buffer.ready()) {
+      Set<B> out;
+      buffer.flush(out.objects, out.start_time, out.end_time);
+      // Only form and send Set<B> if it has a nonzero number of objects
+      if (out.objects.size() != 0) {
+        out.seqno = seqno;
+        out.type = Set<B>::Type::kPayload;
+        out.origin = daqdataformats::GeoID(
+          daqdataformats::GeoID::SystemType::kDataSelection, m_parent.m_geoid_region_id, m_parent.m_geoid_element_id);
+        TLOG_DEBUG(2) << "Output set window " << (draining ? "drained" : "ready") << " with start time "
+                      << out.start_time << " end time " << out.end_time << " and " << out.objects.size()
+                      << " members";
+        if (m_parent.send(out, queue)) {
+          ++seqno;
+        } else {
+          ers::error(AlgorithmFailedToSend(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
+          // out is dropped
+        }
+      }
+    }
+  }
+
+  void send_heartbeat(const Set<A>& in, TimeSliceOutputBuffer<B>& buffer, sink_t& queue, seqno_t& seqno)
+  {
+    Set<B> heartbeat;
+    heartbeat.seqno = seqno;
+    heartbeat.type = Set<B>::Type::kHeartbeat;
+    // Windows that are still buffered, and any sent later, start no
+    // earlier than the output buffer's next window, so the heartbeat
+    // mustn't be later than that
+    daqdataformats::timestamp_t next_window_start = buffer.get_next_window_start();
+    heartbeat.start_time = std::min(in.start_time, next_window_start);
+    heartbeat.end_time = std::min(in.end_time, next_window_start);
+    heartbeat.origin = daqdataformats::GeoID(
+      daqdataformats::GeoID::SystemType::kDataSelection, m_parent.m_geoid_region_id, m_parent.m_geoid_element_id);
+    if (m_parent.send(heartbeat, queue)) {
+      ++seqno;
+    } else {
+      ers::error(AlgorithmFailedToHeartbeat(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
+      // heartbeat is dropped
+    }
+  }
+
   void process(Set<A>& in)
   {
     std::vector<B> elems; // Bs to buffer for the next window
+    bool is_heartbeat = false;
     switch (in.type) {
       case Set<A>::Type::kPayload: {
         if (m_prev_start_time != 0 && in.start_time < m_prev_start_time) {
@@ -286,39 +593,30 @@ public: // NOLINT
         m_prev_start_time = in.start_time;
         std::vector<A> time_slice;
         daqdataformats::timestamp_t start_time, end_time;
-        if (!m_in_buffer.buffer(in, time_slice, start_time, end_time)) {
+        if (!m_in_buffer.buffer(in, time_slice, start_time, end_time, columns())) {
           return; // no complete time slice yet (`in` was part of buffered slice)
         }
         process_slice(time_slice, elems);
+        buffer_routed();
       } break;
       case Set<A>::Type::kHeartbeat: {
         // PAR 2022-01-21 We've got a heartbeat for time T, so we know
         // we won't receive any more inputs for times t < T. Therefore
         // we can flush all items in the input buffer, which have
         // times t < T, because the input is time-ordered. We also
-        // forward the heartbeat downstream
+        // forward the heartbeat downstream, after any output windows it
+        // completes
+        is_heartbeat = true;
 
         std::vector<A> time_slice;
         daqdataformats::timestamp_t start_time, end_time;
-        if (m_in_buffer.flush(time_slice, start_time, end_time)) {
+        if (m_in_buffer.flush(time_slice, start_time, end_time, columns())) {
           if (end_time > in.start_time) {
             // This should never happen, but we check here so we at least get some output if it did
             ers::fatal(OutOfOrderSets(ERS_HERE, m_parent.get_name(), end_time, in.start_time));
           }
           process_slice(time_slice, elems);
         }
-        
-        Set<B> heartbeat;
-        heartbeat.seqno = m_parent.m_sent_count;
-        heartbeat.type = Set<B>::Type::kHeartbeat;
-        heartbeat.start_time = in.start_time;
-        heartbeat.end_time = in.end_time;
-        heartbeat.origin = daqdataformats::GeoID(
-          daqdataformats::GeoID::SystemType::kDataSelection, m_parent.m_geoid_region_id, m_parent.m_geoid_element_id);
-        if (!m_parent.send(heartbeat)) {
-          ers::error(AlgorithmFailedToHeartbeat(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
-          // heartbeat is dropped
-        }
 
         // flush the maker
         try {
@@ -330,6 +628,14 @@ public: // NOLINT
           ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
           return;
         }
+        // Before the swap, while the routes are still the old maker's
+        buffer_routed();
+
+        // The old maker has now seen everything before the heartbeat, so
+        // this is where a new one can take over
+        if (m_parent.swap_pending()) {
+          reconfigure();
+        }
       } break;
       case Set<A>::Type::kUnknown:
         ers::error(UnknownSetError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
@@ -338,25 +644,33 @@ public: // NOLINT
 
     // add new elements to output buffer
     if (elems.size() > 0) {
-      m_out_buffer.buffer(elems);
+      m_parent.m_tardy_count += m_out_buffer.buffer(elems);
+      m_parent.m_current_buffer_time = m_out_buffer.get_buffer_time();
+    }
+
+    // The maker has seen everything before the heartbeat, so data time has
+    // reached the heartbeat even if no outputs have. This lets windows be
+    // emitted during quiet periods instead of waiting for the next output.
+    // It also means that outputs more than the buffer time behind the
+    // heartbeat are tardy, so a maker that holds outputs back across
+    // heartbeats may need a longer buffer time than it did before
+    if (is_heartbeat) {
+      m_out_buffer.advance(in.end_time);
+      for (auto& r : m_routed) {
+        r->buffer.advance(in.end_time);
+      }
     }
 
     // emit completed windows
-    while (m_out_buffer.ready()) {
-      Set<B> out;
-      m_out_buffer.flush(out.objects, out.start_time, out.end_time);
-      // Only form and send Set<B> if it has a nonzero number of objects
-      if (out.objects.size() != 0) {
-        out.seqno = m_parent.m_sent_count;
-        out.type = Set<B>::Type::kPayload;
-        out.origin = daqdataformats::GeoID(
-          daqdataformats::GeoID::SystemType::kDataSelection, m_parent.m_geoid_region_id, m_parent.m_geoid_element_id);
-        TLOG_DEBUG(2) << "Output set window ready with start time " << out.start_time << " end time " << out.end_time
-                      << " and " << out.objects.size() << " members";
-        if (!m_parent.send(out)) {
-          ers::error(AlgorithmFailedToSend(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
-          // out is dropped
-        }
+    send_windows(m_out_buffer, *m_parent.m_output_queue, m_seqno, false);
+    for (auto& r : m_routed) {
+      send_windows(r->buffer, *r->queue, r->seqno, false);
+    }
+
+    if (is_heartbeat) {
+      send_heartbeat(in, m_out_buffer, *m_parent.m_output_queue, m_seqno);
+      for (auto& r : m_routed) {
+        send_heartbeat(in, r->buffer, *r->queue, r->seqno);
       }
     }
   }
@@ -367,31 +681,19 @@ public: // NOLINT
     // results to output buffer
     std::vector<A> time_slice;
     daqdataformats::timestamp_t start_time, end_time;
-    if (m_in_buffer.flush(time_slice, start_time, end_time)) {
+    if (m_in_buffer.flush(time_slice, start_time, end_time, columns())) {
       std::vector<B> elems;
       process_slice(time_slice, elems);
+      buffer_routed();
       if (elems.size() > 0) {
-        m_out_buffer.buffer(elems);
+        m_parent.m_tardy_count += m_out_buffer.buffer(elems);
       }
     }
-    // Second, drain the output buffer onto the queue. These may not be "fully
+    // Second, drain the output buffers onto the queues. These may not be "fully
     // formed" windows, but at this point we're getting no more data anyway.
-    while (!m_out_buffer.empty()) {
-      Set<B> out;
-      m_out_buffer.flush(out.objects, out.start_time, out.end_time);
-      // Only form and send Set<B> if it has a nonzero number of objects
-      if (out.objects.size() != 0) {
-        out.seqno = m_parent.m_sent_count;
-        out.type = Set<B>::Type::kPayload;
-        out.origin = daqdataformats::GeoID(
-          daqdataformats::GeoID::SystemType::kDataSelection, m_parent.m_geoid_region_id, m_parent.m_geoid_element_id);
-        TLOG_DEBUG(2) << "Output set window drained with start time " << out.start_time << " end time " << out.end_time
-                      << " and " << out.objects.size() << " members";
-        if (!m_parent.send(out)) {
-          ers::error(AlgorithmFailedToSend(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
-          // out is dropped
-        }
-      }
+    send_windows(m_out_buffer, *m_parent.m_output_queue, m_seqno, true);
+    for (auto& r : m_routed) {
+      send_windows(r->buffer, *r->queue, r->seqno, true);
     }
   }
 };
@@ -411,22 +713,27 @@ public: // NOLINT
 
   TimeSliceInputBuffer<A> m_in_buffer;
 
-  void reconfigure() {}
+  // Typed processor for the maker's concrete class, or nullptr if it doesn't have one
+  void (*m_processor)(MAKER&, const A*, const A*, const TPSliceColumns*, std::vector<OUT>&) = nullptr;
+
+  void reconfigure()
+  {
+    m_processor = m_parent.m_maker ? find_slice_processor<MAKER, A, OUT>(*m_parent.m_maker) : nullptr;
+  }
 
   void reset() {}
 
   void process_slice(const std::vector<A>& time_slice, std::vector<OUT>& out_vec)
   {
-    // time_slice is a full slice (all Set<A> combined), time ordered, vector of A
-    // call operator for each of the objects in the vector
-    for (const A& x : time_slice) {
-      try {
-        m_parent.m_maker->operator()(x, out_vec);
-      } catch (...) { // NOLINT TODO Benjamin Land <BenLand100@github.com> May 28-2021 can we restrict the possible
-                      // exceptions triggeralgs might raise?
-        ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
-        return;
-      }
+    // time_slice is a full slice (all Set<A> combined), time ordered, vector of A.
+    // If the plugin registered a typed processor, hand it the whole slice,
+    // otherwise call operator for each of the objects in the vector
+    try {
+      trigger::process_slice(*m_parent.m_maker, m_processor, time_slice, nullptr, out_vec);
+    } catch (...) { // NOLINT TODO Benjamin Land <BenLand100@github.com> May 28-2021 can we restrict the possible
+                    // exceptions triggeralgs might raise?
+      ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
+      return;
     }
   }
 
@@ -465,6 +772,11 @@ public: // NOLINT
           ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
           return;
         }
+        // The old maker has now seen everything before the heartbeat, so
+        // this is where a new one can take over
+        if (m_parent.swap_pending()) {
+          reconfigure();
+        }
         break;
       case Set<A>::Type::kUnknown:
         ers::error(UnknownSetError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
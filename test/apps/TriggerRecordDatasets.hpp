@@ -0,0 +1,94 @@
+/**
+ * @file TriggerRecordDatasets.hpp Group the datasets in an HDF5 file by trigger record
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_TEST_APPS_TRIGGERRECORDDATASETS_HPP_
+#define TRIGGER_TEST_APPS_TRIGGERRECORDDATASETS_HPP_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+// The names of the datasets that make up one trigger record. Only the
+// names are kept for the whole file: the header and fragments are
+// loaded when the record is processed, and freed straight after
+struct TriggerRecordDatasets
+{
+  int trigger_number = 0;
+  std::string header;
+  std::vector<std::string> fragments;
+};
+
+namespace dataset_name {
+
+// If `name` continues at `pos` with `prefix`, skip past it and return true
+inline bool
+consume(const std::string& name, size_t& pos, const std::string& prefix)
+{
+  if (name.compare(pos, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  pos += prefix.size();
+  return true;
+}
+
+// Read the decimal number at `pos` in `name`, and skip past it. Returns false if there's no digit at `pos`
+inline bool
+consume_number(const std::string& name, size_t& pos, int& number)
+{
+  size_t start = pos;
+  number = 0;
+  while (pos < name.size() && name[pos] >= '0' && name[pos] <= '9') {
+    number = 10 * number + (name[pos] - '0');
+    ++pos;
+  }
+  return pos != start;
+}
+
+} // namespace dataset_name
+
+// Sort the dataset names into trigger records, in trigger number order,
+// keeping the header and the trigger (TP) fragments. The names look like
+// "//TriggerRecord00001/TriggerRecordHeader" and
+// "//TriggerRecord00001/Trigger/Region00/Element00", and there are a lot
+// of them, so they're matched by hand rather than with a regex
+inline std::vector<TriggerRecordDatasets>
+find_trigger_records(const std::vector<std::string>& datasets)
+{
+  using dataset_name::consume;
+  using dataset_name::consume_number;
+
+  std::map<int, TriggerRecordDatasets> records;
+  for (auto const& dataset : datasets) {
+    size_t pos = 0;
+    int trigger_number = 0, region = 0, element = 0;
+    if (!consume(dataset, pos, "//TriggerRecord") || !consume_number(dataset, pos, trigger_number)) {
+      continue;
+    }
+    if (consume(dataset, pos, "/TriggerRecordHeader") && pos == dataset.size()) {
+      records[trigger_number].header = dataset;
+    } else if (consume(dataset, pos, "/Trigger/Region") && consume_number(dataset, pos, region) &&
+               consume(dataset, pos, "/Element") && consume_number(dataset, pos, element) && pos == dataset.size()) {
+      records[trigger_number].fragments.push_back(dataset);
+    }
+  }
+
+  std::vector<TriggerRecordDatasets> ret;
+  ret.reserve(records.size());
+  for (auto& [trigger_number, record] : records) {
+    record.trigger_number = trigger_number;
+    ret.push_back(std::move(record));
+  }
+  return ret;
+}
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_TEST_APPS_TRIGGERRECORDDATASETS_HPP_
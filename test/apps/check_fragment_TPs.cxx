@@ -7,26 +7,132 @@
  */
 #include "CLI/CLI.hpp"
 
+#include "TriggerRecordDatasets.hpp"
+
 #include "detdataformats/trigger/TriggerPrimitive.hpp"
 #include "hdf5libs/DAQDecoder.hpp"
 
 #include <daqdataformats/Fragment.hpp>
 #include <daqdataformats/FragmentHeader.hpp>
+#include <daqdataformats/GeoID.hpp>
 #include <daqdataformats/TriggerRecordHeader.hpp>
 #include <daqdataformats/Types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
-#include <regex>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using dunedaq::daqdataformats::GeoID;
+using dunedaq::daqdataformats::timestamp_t;
+using dunedaq::detdataformats::trigger::TriggerPrimitive;
 
-// A little struct to hold a TriggerRecordHeader along with the
-// corresponding TP fragments
-struct MyTriggerRecord
+// What we found when checking one trigger record
+struct RecordResult
 {
-  std::unique_ptr<dunedaq::daqdataformats::TriggerRecordHeader> header;
-  std::vector<std::unique_ptr<dunedaq::daqdataformats::Fragment>> fragments;
+  bool checked = false;
+  size_t n_fragments = 0;
+  size_t n_tps = 0;
+  size_t n_failures = 0;
+  std::string messages;
 };
 
+// TP statistics for the fragments from one GeoID, over the whole file
+struct GeoIDStats
+{
+  size_t n_fragments = 0;
+  size_t n_empty_fragments = 0;
+  size_t n_tps = 0;
+  size_t n_outside = 0;
+  // The fraction of each request window between the first and last TP in the window
+  double coverage_sum = 0;
+  double min_coverage = 1;
+
+  void add(const GeoIDStats& other)
+  {
+    n_fragments += other.n_fragments;
+    n_empty_fragments += other.n_empty_fragments;
+    n_tps += other.n_tps;
+    n_outside += other.n_outside;
+    coverage_sum += other.coverage_sum;
+    min_coverage = std::min(min_coverage, other.min_coverage);
+  }
+};
+
+// Find the window start and end requested for this trigger record. In
+// principle the request windows for each data selection component could
+// be different, but we'll assume they're the same for now, because
+// matching up the component request to the fragment is too difficult
+std::pair<timestamp_t, timestamp_t>
+request_window(const dunedaq::daqdataformats::TriggerRecordHeader& header)
+{
+  size_t n_requests = header.get_num_requested_components();
+  timestamp_t window_begin = 0, window_end = 0;
+  for (size_t i = 0; i < n_requests; ++i) {
+    auto request = header.at(i);
+    if (request.component.system_type == GeoID::SystemType::kDataSelection) {
+      window_begin = request.window_begin;
+      window_end = request.window_end;
+    }
+  }
+  return { window_begin, window_end };
+}
+
+// Check that each primitive in the fragment falls within the request
+// window, and add the fragment to the statistics for its GeoID. Messages
+// are only kept for failing fragments, unless `verbose`
+void
+check_fragment(const dunedaq::daqdataformats::Fragment& frag,
+               timestamp_t window_begin,
+               timestamp_t window_end,
+               size_t max_messages,
+               bool verbose,
+               RecordResult& result,
+               GeoIDStats& stats)
+{
+  const size_t n_prim = (frag.get_size() - sizeof(dunedaq::daqdataformats::FragmentHeader)) / sizeof(TriggerPrimitive);
+  const TriggerPrimitive* prim = reinterpret_cast<TriggerPrimitive*>(frag.get_data()); // NOLINT
+  timestamp_t first = std::numeric_limits<timestamp_t>::max(), last = 0;
+  std::ostringstream messages;
+  size_t n_failures_before = result.n_failures;
+  for (size_t i = 0; i < n_prim; ++i, ++prim) {
+    if (prim->time_start < window_begin || prim->time_start > window_end) {
+      if (result.n_failures < max_messages) {
+        messages << "    Primitive with time_start " << prim->time_start << " is outside request window of ("
+                 << window_begin << ", " << window_end << ")\n";
+      }
+      ++result.n_failures;
+      ++stats.n_outside;
+      continue;
+    }
+    first = std::min(first, prim->time_start);
+    last = std::max(last, prim->time_start);
+  }
+  if (verbose || result.n_failures > n_failures_before) {
+    result.messages += "  Fragment has " + std::to_string(n_prim) + " primitives\n" + messages.str();
+  }
+  result.n_tps += n_prim;
+
+  double coverage = 0;
+  if (last >= first && window_end > window_begin) {
+    coverage = static_cast<double>(last - first) / (window_end - window_begin);
+  }
+  ++stats.n_fragments;
+  stats.n_empty_fragments += (n_prim == 0);
+  stats.n_tps += n_prim;
+  stats.coverage_sum += coverage;
+  stats.min_coverage = std::min(stats.min_coverage, coverage);
+}
+
 int
 main(int argc, char** argv)
 {
@@ -34,77 +140,106 @@ main(int argc, char** argv)
 
   std::string filename;
   app.add_option("-f,--file", filename, "Input HDF5 file");
+  size_t n_threads = 1;
+  app.add_option("-j,--threads",
+                 n_threads,
+                 "Number of threads to check trigger records on. Loading is serialized, so this only helps when "
+                 "checking, rather than reading the file, is the bottleneck");
+  size_t max_messages = 10;
+  app.add_option("--max-messages", max_messages, "Most out-of-window TPs to print per trigger record");
+  bool verbose = false;
+  app.add_flag("-v,--verbose", verbose, "Print the fragments in every trigger record, not just failing ones");
 
   CLI11_PARSE(app, argc, argv);
 
-  // Map from trigger number to struct of header/fragments
-  std::map<int, MyTriggerRecord> trigger_records;
-
-  std::regex header_regex("^//TriggerRecord([0-9]+)/TriggerRecordHeader$", std::regex::extended);
-  std::regex trigger_fragment_regex("^//TriggerRecord([0-9]+)/Trigger/Region[0-9]+/Element[0-9]+$",
-                                    std::regex::extended);
-
   unsigned int num_events;
   dunedaq::hdf5libs::DAQDecoder decoder(filename, num_events);
 
-  // Populate the map with the TRHs and DS fragments
-  auto datasets = decoder.get_datasets();
-  for (auto const& dataset : datasets) {
-    // std::cout << dataset << std::endl;
-    std::smatch m;
-    if (std::regex_match(dataset, m, header_regex)) {
-      int trigger_number = std::atoi(m[1].str().c_str());
-      trigger_records[trigger_number].header = decoder.get_trh_ptr(dataset);
-      // std::cout << "Header match: " << dataset << " m[1] = " <<  << std::endl;
+  auto records = dunedaq::trigger::find_trigger_records(decoder.get_datasets());
+
+  // Each thread takes the next trigger record, loads it, checks it, and
+  // frees it, so only n_threads records are in memory at once. HDF5
+  // reads aren't thread safe, so loading is serialized, and only the
+  // checking runs in parallel
+  std::vector<RecordResult> results(records.size());
+  std::map<GeoID, GeoIDStats> geoid_stats;
+  std::mutex decoder_mutex, stats_mutex;
+  std::atomic<size_t> next_record{ 0 };
+
+  auto worker = [&]() {
+    std::map<GeoID, GeoIDStats> my_stats;
+    for (size_t i = next_record++; i < records.size(); i = next_record++) {
+      auto const& datasets = records[i];
+      if (datasets.header.empty()) {
+        continue;
+      }
+      std::unique_ptr<dunedaq::daqdataformats::TriggerRecordHeader> header;
+      std::vector<std::unique_ptr<dunedaq::daqdataformats::Fragment>> fragments;
+      timestamp_t window_begin = 0, window_end = 0;
+      {
+        std::lock_guard<std::mutex> lk(decoder_mutex);
+        header = decoder.get_trh_ptr(datasets.header);
+        std::tie(window_begin, window_end) = request_window(*header);
+        if (window_begin == 0 || window_end == 0) {
+          // We didn't find a component request for a dataselection item, so skip
+          continue;
+        }
+        for (auto const& name : datasets.fragments) {
+          fragments.push_back(decoder.get_frag_ptr(name));
+        }
+      }
+
+      RecordResult& result = results[i];
+      result.checked = true;
+      result.n_fragments = fragments.size();
+      for (auto const& frag : fragments) {
+        check_fragment(
+          *frag, window_begin, window_end, max_messages, verbose, result, my_stats[frag->get_element_id()]);
+      }
     }
-    if (std::regex_match(dataset, m, trigger_fragment_regex)) {
-      int trigger_number = std::atoi(m[1].str().c_str());
-      trigger_records[trigger_number].fragments.push_back(decoder.get_frag_ptr(dataset));
-      // std::cout << "Trigger fragment match: " << dataset << std::endl;
+
+    std::lock_guard<std::mutex> lk(stats_mutex);
+    for (auto const& [geoid, stats] : my_stats) {
+      geoid_stats[geoid].add(stats);
     }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < std::max<size_t>(n_threads, 1); ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& thread : threads) {
+    thread.join();
   }
 
-  int n_failures = 0;
-
-  using dunedaq::detdataformats::trigger::TriggerPrimitive;
-  for (auto const& [trigger_number, record] : trigger_records) {
-    std::cout << "Trigger number " << trigger_number << " with TRH pointer " << record.header.get() << " and "
-              << record.fragments.size() << " fragments" << std::endl;
-
-    // Find the window start and end requested for this trigger
-    // record. In principle the request windows for each data
-    // selection component could be different, but we'll assume
-    // they're the same for now, because matching up the component
-    // request to the fragment is too difficult
-    size_t n_requests = record.header->get_num_requested_components();
-    dunedaq::daqdataformats::timestamp_t window_begin = 0, window_end = 0;
-    for (size_t i = 0; i < n_requests; ++i) {
-      auto request = record.header->at(i);
-      if (request.component.system_type == dunedaq::daqdataformats::GeoID::SystemType::kDataSelection) {
-        window_begin = request.window_begin;
-        window_end = request.window_end;
-      }
-    }
-    if (window_begin == 0 || window_end == 0) {
-      // We didn't find a component request for a dataselection item, so skip
+  size_t n_failures = 0, n_checked = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    auto const& result = results[i];
+    if (!result.checked) {
       continue;
     }
-    // Check that each primitive in each fragment falls within the request window
-    for (auto const& frag : record.fragments) {
-      const size_t n_prim =
-        (frag->get_size() - sizeof(dunedaq::daqdataformats::FragmentHeader)) / sizeof(TriggerPrimitive);
-      std::cout << "  Fragment has " << n_prim << " primitives" << std::endl;
-      const TriggerPrimitive* prim = reinterpret_cast<TriggerPrimitive*>(frag->get_data());
-      for (size_t i = 0; i < n_prim; ++i) {
-        if (prim->time_start < window_begin || prim->time_start > window_end) {
-          std::cout << "Primitive with time_start " << prim->time_start << " is outside request window of ("
-                    << window_begin << ", " << window_end << ")" << std::endl;
-          ++n_failures;
-        }
-        ++prim;
+    ++n_checked;
+    n_failures += result.n_failures;
+    if (verbose || result.n_failures > 0) {
+      std::cout << "Trigger number " << records[i].trigger_number << " with " << result.n_fragments << " fragments and "
+                << result.n_tps << " primitives, " << result.n_failures << " outside the request window" << std::endl;
+      std::cout << result.messages;
+      if (result.n_failures > max_messages) {
+        std::cout << "    ... and " << (result.n_failures - max_messages) << " more" << std::endl;
       }
     }
   }
+
+  std::cout << "Checked " << n_checked << " of " << records.size() << " trigger records" << std::endl;
+  for (auto const& [geoid, stats] : geoid_stats) {
+    std::cout << "Region " << geoid.region_id << " element " << geoid.element_id << ": " << stats.n_fragments
+              << " fragments (" << stats.n_empty_fragments << " empty), " << stats.n_tps << " TPs ("
+              << stats.n_outside << " outside window), mean TPs/fragment "
+              << (stats.n_fragments ? static_cast<double>(stats.n_tps) / stats.n_fragments : 0.)
+              << ", window coverage mean " << (stats.n_fragments ? stats.coverage_sum / stats.n_fragments : 0.)
+              << " min " << stats.min_coverage << std::endl;
+  }
+
   if (n_failures > 0) {
     std::cout << "Found " << n_failures << " TPs outside window in " << num_events << " trigger records" << std::endl;
   } else {
@@ -0,0 +1,452 @@
+/**
+ * @file run_trigger_chain.cxx Run the TP -> TA -> TC chain offline over the TP fragments in an HDF5 file
+ *
+ * Each trigger record is run independently: the TPs from each trigger
+ * fragment go through TimeSliceInputBuffer, a fresh TA maker and
+ * TimeSliceOutputBuffer, as they would in a TriggerActivityMaker module for
+ * that link, and the TASets from all the fragments go through the same for
+ * the TC maker. Trigger records are run in parallel, and the TASets and TCs
+ * are written in trigger record order to tap files, in the same format as
+ * TASetTap and TCTap write
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#include "CLI/CLI.hpp"
+
+#include "TriggerRecordDatasets.hpp"
+
+#include "trigger/AlgorithmPlugins.hpp"
+#include "trigger/SliceProcessing.hpp"
+#include "trigger/TASet.hpp"
+#include "trigger/TPSet.hpp"
+#include "trigger/TPSliceColumns.hpp"
+#include "trigger/TapFile.hpp"
+#include "trigger/TimeSliceInputBuffer.hpp"
+#include "trigger/TimeSliceOutputBuffer.hpp"
+#include "trigger/TriggerCandidate_serialization.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+#include "daqdataformats/FragmentHeader.hpp"
+#include "hdf5libs/DAQDecoder.hpp"
+#include "serialization/Serialization.hpp"
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerCandidate.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::trigger;
+
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerCandidate;
+using triggeralgs::TriggerPrimitive;
+using timestamp_t = dunedaq::daqdataformats::timestamp_t;
+
+namespace {
+
+struct Options
+{
+  std::string filename;
+  std::string output_prefix;
+  std::string ta_plugin = "TriggerActivityMakerPrescalePlugin";
+  std::string ta_config = R"({"prescale": 100})";
+  std::string tc_plugin = "TriggerCandidateMakerPrescalePlugin";
+  std::string tc_config = R"({"prescale": 10})";
+  size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t clock_frequency_hz = 50'000'000; // NOLINT(build/unsigned)
+  timestamp_t tpset_time_width = 62'500;
+  timestamp_t window_time = 625'000;
+  timestamp_t buffer_time = 625'000;
+  size_t max_file_size_mb = 1024;
+};
+
+// Everything that comes out of one trigger record
+struct RecordOutput
+{
+  bool done = false;
+  // Set if the record couldn't be read or run
+  std::string error;
+  std::vector<TASet> tasets;
+  std::vector<TriggerCandidate> tcs;
+  size_t n_tps = 0;
+  size_t n_tas = 0;
+  size_t n_tardy = 0;
+  // From the first TP to the last in the record
+  timestamp_t data_ticks = 0;
+  // Time spent in the chain, not counting reading the record from file
+  double processing_seconds = 0;
+};
+
+// Split the TPs from one fragment into TPSets `width` ticks wide, with
+// their start times a multiple of `width`, as readout makes them
+std::vector<TPSet>
+make_tpsets(const dunedaq::daqdataformats::Fragment& frag, timestamp_t width)
+{
+  const size_t n_prim = (frag.get_size() - sizeof(dunedaq::daqdataformats::FragmentHeader)) / sizeof(TriggerPrimitive);
+  const TriggerPrimitive* prim = reinterpret_cast<const TriggerPrimitive*>(frag.get_data()); // NOLINT
+  std::vector<TriggerPrimitive> tps(prim, prim + n_prim);
+  std::sort(tps.begin(), tps.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return a.time_start < b.time_start;
+  });
+
+  std::vector<TPSet> tpsets;
+  for (auto& tp : tps) {
+    timestamp_t start_time = tp.time_start - tp.time_start % width;
+    if (tpsets.empty() || tpsets.back().start_time != start_time) {
+      TPSet& tpset = tpsets.emplace_back();
+      tpset.seqno = tpsets.size();
+      tpset.origin = frag.get_element_id();
+      tpset.type = TPSet::Type::kPayload;
+      tpset.start_time = start_time;
+      tpset.end_time = start_time + width;
+    }
+    tpsets.back().objects.push_back(tp);
+  }
+  return tpsets;
+}
+
+// Makers hold state from one time slice to the next, so each link in each
+// trigger record gets new ones. cetlib's plugin factory isn't thread safe
+std::mutex g_plugin_mutex;
+
+std::shared_ptr<triggeralgs::TriggerActivityMaker>
+new_ta_maker(const Options& opts, const nlohmann::json& config)
+{
+  std::shared_ptr<triggeralgs::TriggerActivityMaker> maker;
+  {
+    std::lock_guard<std::mutex> lk(g_plugin_mutex);
+    maker = make_ta_maker(opts.ta_plugin);
+  }
+  maker->configure(config);
+  return maker;
+}
+
+std::shared_ptr<triggeralgs::TriggerCandidateMaker>
+new_tc_maker(const Options& opts, const nlohmann::json& config)
+{
+  std::shared_ptr<triggeralgs::TriggerCandidateMaker> maker;
+  {
+    std::lock_guard<std::mutex> lk(g_plugin_mutex);
+    maker = make_tc_maker(opts.tc_plugin);
+  }
+  maker->configure(config);
+  return maker;
+}
+
+// Run the TPSets from one link through a TA maker, adding the TASets to `tasets`
+void
+run_link(const Options& opts,
+         const nlohmann::json& ta_config,
+         std::vector<TPSet>& tpsets,
+         std::vector<TASet>& tasets,
+         RecordOutput& out)
+{
+  auto maker = new_ta_maker(opts, ta_config);
+  TPSliceColumns columns(
+    slice_processor_column_fields<triggeralgs::TriggerActivityMaker, TriggerPrimitive, TriggerActivity>(*maker));
+  TPSliceColumns* slice_columns = columns.get_fields() != 0 ? &columns : nullptr;
+
+  const std::string name("link");
+  TimeSliceInputBuffer<TriggerPrimitive> in_buffer(name, opts.ta_plugin);
+  TimeSliceOutputBuffer<TriggerActivity> out_buffer(name, opts.ta_plugin, opts.buffer_time, opts.window_time);
+  std::vector<TriggerPrimitive> tp_slice;
+  std::vector<TriggerActivity> tas;
+  timestamp_t slice_start, slice_end;
+
+  auto process = [&]() {
+    tas.clear();
+    process_slice(*maker, tp_slice, slice_columns, tas);
+    out.n_tas += tas.size();
+    if (!tas.empty()) {
+      out.n_tardy += out_buffer.buffer(tas);
+    }
+  };
+
+  const auto origin = tpsets.empty() ? TASet().origin : tpsets.front().origin;
+  size_t first = tasets.size();
+  for (TPSet& tpset : tpsets) {
+    out.n_tps += tpset.objects.size();
+    tp_slice.clear();
+    if (in_buffer.buffer(std::move(tpset), tp_slice, slice_start, slice_end, slice_columns)) {
+      process();
+      out_buffer.advance(slice_end);
+      flush_ready(out_buffer, tasets);
+    }
+  }
+  tp_slice.clear();
+  if (in_buffer.flush(tp_slice, slice_start, slice_end, slice_columns)) {
+    process();
+  }
+  flush_ready(out_buffer, tasets, true);
+
+  for (size_t i = first; i < tasets.size(); ++i) {
+    tasets[i].seqno = i - first + 1;
+    tasets[i].origin = origin;
+  }
+}
+
+// Run the TASets from all links, in start time order, through a TC maker
+void
+run_tcs(const Options& opts, const nlohmann::json& tc_config, RecordOutput& out)
+{
+  auto maker = new_tc_maker(opts, tc_config);
+  const std::string name("tc");
+  TimeSliceInputBuffer<TriggerActivity> in_buffer(name, opts.tc_plugin);
+  TimeSliceOutputBuffer<TriggerCandidate> out_buffer(name, opts.tc_plugin, opts.buffer_time, opts.window_time);
+  std::vector<TriggerActivity> ta_slice;
+  std::vector<TriggerCandidate> tcs;
+  std::vector<Set<TriggerCandidate>> tcsets;
+  timestamp_t slice_start, slice_end;
+
+  auto process = [&]() {
+    tcs.clear();
+    process_slice(*maker, ta_slice, nullptr, tcs);
+    if (!tcs.empty()) {
+      out.n_tardy += out_buffer.buffer(tcs);
+    }
+  };
+
+  // With the whole record to hand, sorting the TASets gives the order that TriggerZipper would
+  std::vector<TASet> tasets(out.tasets);
+  std::stable_sort(
+    tasets.begin(), tasets.end(), [](const TASet& a, const TASet& b) { return a.start_time < b.start_time; });
+  for (TASet& taset : tasets) {
+    ta_slice.clear();
+    if (in_buffer.buffer(std::move(taset), ta_slice, slice_start, slice_end)) {
+      process();
+      out_buffer.advance(slice_end);
+      flush_ready(out_buffer, tcsets);
+    }
+  }
+  ta_slice.clear();
+  if (in_buffer.flush(ta_slice, slice_start, slice_end)) {
+    process();
+  }
+  flush_ready(out_buffer, tcsets, true);
+
+  for (auto& tcset : tcsets) {
+    out.tcs.insert(out.tcs.end(), tcset.objects.begin(), tcset.objects.end());
+  }
+}
+
+void
+run_record(const Options& opts,
+           const nlohmann::json& ta_config,
+           const nlohmann::json& tc_config,
+           const std::vector<std::unique_ptr<dunedaq::daqdataformats::Fragment>>& fragments,
+           RecordOutput& out)
+{
+  auto start = std::chrono::steady_clock::now();
+  timestamp_t first_tp = std::numeric_limits<timestamp_t>::max(), last_tp = 0;
+  for (auto const& frag : fragments) {
+    auto tpsets = make_tpsets(*frag, opts.tpset_time_width);
+    if (tpsets.empty()) {
+      continue;
+    }
+    first_tp = std::min(first_tp, tpsets.front().objects.front().time_start);
+    last_tp = std::max(last_tp, tpsets.back().objects.back().time_start);
+    run_link(opts, ta_config, tpsets, out.tasets, out);
+  }
+  run_tcs(opts, tc_config, out);
+  out.data_ticks = last_tp > first_tp ? last_tp - first_tp : 0;
+  out.processing_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Serialize `obj` into the next record of a tap file
+template<class T>
+void
+write_tap(TapFileWriter& writer, const T& obj, timestamp_t start_time, timestamp_t end_time)
+{
+  auto bytes = dunedaq::serialization::serialize(obj, dunedaq::serialization::kMsgPack);
+  writer.write(start_time, end_time, reinterpret_cast<const char*>(bytes.data()), bytes.size()); // NOLINT
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  CLI::App app{ "Run TA and TC maker plugins over the TP fragments in an HDF5 file" };
+
+  Options opts;
+  app.add_option("-f,--file", opts.filename, "Input HDF5 file")->required();
+  app.add_option("-o,--output-prefix",
+                 opts.output_prefix,
+                 "Prefix of the tap files to write the TASets and TCs to. If not given, nothing is written");
+  app.add_option("--ta-plugin", opts.ta_plugin, "TA maker plugin");
+  app.add_option("--ta-config", opts.ta_config, "TA maker configuration, as JSON");
+  app.add_option("--tc-plugin", opts.tc_plugin, "TC maker plugin");
+  app.add_option("--tc-config", opts.tc_config, "TC maker configuration, as JSON");
+  app.add_option("-j,--threads", opts.n_threads, "Number of trigger records to run at once");
+  app.add_option("--clock-frequency", opts.clock_frequency_hz, "Clock frequency in Hz (default 50000000)");
+  app.add_option("--tpset-width", opts.tpset_time_width, "Ticks per input TPSet (default 62500)");
+  app.add_option("--window-time", opts.window_time, "Output window width in ticks (default 625000)");
+  app.add_option("--buffer-time", opts.buffer_time, "Output buffer time in ticks (default 625000)");
+  app.add_option("--max-file-size", opts.max_file_size_mb, "Size in MB at which a new output file is started");
+
+  CLI11_PARSE(app, argc, argv);
+
+  if (opts.tpset_time_width == 0 || opts.window_time == 0 || opts.n_threads == 0) {
+    std::cerr << "TPSet width, window time and thread count must be nonzero" << std::endl;
+    return 1;
+  }
+  const auto ta_config = nlohmann::json::parse(opts.ta_config);
+  const auto tc_config = nlohmann::json::parse(opts.tc_config);
+
+  unsigned int num_events;
+  dunedaq::hdf5libs::DAQDecoder decoder(opts.filename, num_events);
+  auto records = find_trigger_records(decoder.get_datasets());
+
+  std::unique_ptr<TapFileWriter> ta_writer, tc_writer;
+  if (!opts.output_prefix.empty()) {
+    ta_writer.reset(new TapFileWriter(opts.output_prefix + "_tas", opts.max_file_size_mb << 20, 0, opts.window_time));
+    tc_writer.reset(new TapFileWriter(opts.output_prefix + "_tcs", opts.max_file_size_mb << 20, 0, opts.window_time));
+  }
+
+  // Each thread takes the next trigger record, reads it, and runs it.
+  // HDF5 reads aren't thread safe, so reading is serialized. The main
+  // thread writes the output of each record in order, and a thread won't
+  // start a record more than 2 * n_threads ahead of the writing, so memory
+  // use is bounded however large the file is
+  std::vector<RecordOutput> outputs(records.size());
+  std::mutex decoder_mutex, output_mutex;
+  std::condition_variable output_cv;
+  size_t next_record = 0, next_to_write = 0;
+  const size_t max_ahead = 2 * opts.n_threads;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> lk(output_mutex);
+        output_cv.wait(lk, [&]() { return next_record >= records.size() || next_record < next_to_write + max_ahead; });
+        if (next_record >= records.size()) {
+          return;
+        }
+        i = next_record++;
+      }
+
+      // An exception mustn't escape the thread, and the record still has to
+      // be marked done, or the writer would wait for it forever
+      RecordOutput out;
+      try {
+        std::vector<std::unique_ptr<dunedaq::daqdataformats::Fragment>> fragments;
+        {
+          std::lock_guard<std::mutex> lk(decoder_mutex);
+          for (auto const& name : records[i].fragments) {
+            fragments.push_back(decoder.get_frag_ptr(name));
+          }
+        }
+        run_record(opts, ta_config, tc_config, fragments, out);
+      } catch (const std::exception& excpt) {
+        out = RecordOutput();
+        out.error = excpt.what();
+      }
+      out.done = true;
+
+      {
+        std::lock_guard<std::mutex> lk(output_mutex);
+        outputs[i] = std::move(out);
+      }
+      output_cv.notify_all();
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < opts.n_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  size_t n_tps = 0, n_tas = 0, n_tasets = 0, n_tcs = 0, n_tardy = 0;
+  timestamp_t data_ticks = 0;
+  double processing_seconds = 0;
+  int ret = 0;
+  while (next_to_write < records.size()) {
+    RecordOutput out;
+    {
+      std::unique_lock<std::mutex> lk(output_mutex);
+      output_cv.wait(lk, [&]() { return outputs[next_to_write].done; });
+      out = std::move(outputs[next_to_write]);
+      outputs[next_to_write] = RecordOutput();
+    }
+
+    if (!out.error.empty()) {
+      std::cerr << "Trigger number " << records[next_to_write].trigger_number << " failed: " << out.error
+                << std::endl;
+      ret = 1;
+    }
+    n_tps += out.n_tps;
+    n_tas += out.n_tas;
+    n_tasets += out.tasets.size();
+    n_tcs += out.tcs.size();
+    n_tardy += out.n_tardy;
+    data_ticks += out.data_ticks;
+    processing_seconds += out.processing_seconds;
+    try {
+      if (ta_writer) {
+        for (auto const& taset : out.tasets) {
+          write_tap(*ta_writer, taset, taset.start_time, taset.end_time);
+        }
+        for (auto const& tc : out.tcs) {
+          write_tap(*tc_writer, tc, tc.time_start, tc.time_end);
+        }
+      }
+    } catch (const BadTapFile& excpt) {
+      std::cerr << excpt.what() << std::endl;
+      ta_writer.reset();
+      tc_writer.reset();
+      ret = 1;
+    }
+
+    {
+      std::lock_guard<std::mutex> lk(output_mutex);
+      ++next_to_write;
+    }
+    output_cv.notify_all();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  try {
+    if (ta_writer) {
+      ta_writer->close();
+      tc_writer->close();
+    }
+  } catch (const BadTapFile& excpt) {
+    std::cerr << excpt.what() << std::endl;
+    ta_writer.reset();
+    tc_writer.reset();
+    ret = 1;
+  }
+
+  double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double data_seconds = static_cast<double>(data_ticks) / opts.clock_frequency_hz;
+  std::cout << "Ran " << records.size() << " trigger records (" << num_events << " in file) on " << opts.n_threads
+            << " threads: " << n_tps << " TPs -> " << n_tas << " TAs in " << n_tasets << " TASets -> " << n_tcs
+            << " TCs, " << n_tardy << " dropped as tardy" << std::endl;
+  std::cout << "Ran " << data_seconds << " s of data in " << wall_seconds << " s ("
+            << (wall_seconds > 0 ? data_seconds / wall_seconds : 0.) << "x real time), using " << processing_seconds
+            << " s of thread time in the chain ("
+            << (processing_seconds > 0 ? data_seconds / processing_seconds : 0.) << "x real time per thread)"
+            << std::endl;
+  if (ta_writer) {
+    std::cout << "Wrote " << ta_writer->get_bytes_written() << " bytes of TASets to " << ta_writer->get_files_written()
+              << " files and " << tc_writer->get_bytes_written() << " bytes of TCs to "
+              << tc_writer->get_files_written() << " files with prefix " << opts.output_prefix << std::endl;
+  }
+  return ret;
+}
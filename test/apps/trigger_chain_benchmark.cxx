@@ -0,0 +1,434 @@
+/**
+ * @file trigger_chain_benchmark.cxx Time the TP -> TA -> TC chain in-process, without queues
+ *
+ * Synthetic TPSets from one TPGenerator per link go through the same
+ * templates as the trigger modules: BufferManager (as in TPSetBufferCreator),
+ * then TimeSliceInputBuffer, the TA maker plugin and TimeSliceOutputBuffer
+ * for each link, then zipper::merge of the TASets from all links, and then
+ * TimeSliceInputBuffer, the TC maker plugin and TimeSliceOutputBuffer for the
+ * TCs. Each stage is timed separately, and the heap allocations it makes are
+ * counted, for each combination of link count and noise rate given
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#include "CLI/CLI.hpp"
+
+#include "../../plugins/zipper.hpp" // NOLINT
+
+#include "trigger/AlgorithmPlugins.hpp"
+#include "trigger/BufferManager.hpp"
+#include "trigger/SliceProcessing.hpp"
+#include "trigger/TASet.hpp"
+#include "trigger/TPGenerator.hpp"
+#include "trigger/TPSet.hpp"
+#include "trigger/TPSliceColumns.hpp"
+#include "trigger/TimeSliceInputBuffer.hpp"
+#include "trigger/TimeSliceOutputBuffer.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerCandidate.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::trigger;
+
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerCandidate;
+using triggeralgs::TriggerPrimitive;
+using timestamp_t = dunedaq::daqdataformats::timestamp_t;
+
+// Count every heap allocation in the program, so that each stage can report
+// how many it made. The benchmark is single-threaded, so a plain counter will
+// do. The standard library's operator delete releases memory with std::free,
+// so it doesn't need replacing too
+static size_t g_n_allocations = 0;
+
+void*
+operator new(size_t size)
+{
+  ++g_n_allocations;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void*
+operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void*
+operator new(size_t size, std::align_val_t align)
+{
+  ++g_n_allocations;
+  // aligned_alloc wants the size to be a multiple of the alignment
+  size_t alignment = static_cast<size_t>(align);
+  size = std::max<size_t>((size + alignment - 1) / alignment, 1) * alignment;
+  if (void* p = std::aligned_alloc(alignment, size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void*
+operator new[](size_t size, std::align_val_t align)
+{
+  return operator new(size, align);
+}
+
+namespace {
+
+struct Options
+{
+  std::string ta_plugin = "TriggerActivityMakerPrescalePlugin";
+  std::string ta_config = R"({"prescale": 100})";
+  std::string tc_plugin = "TriggerCandidateMakerPrescalePlugin";
+  std::string tc_config = R"({"prescale": 10})";
+  std::vector<size_t> links{ 1, 2, 4, 8 };
+  std::vector<double> noise_rates_hz{ 10, 100, 1000 };
+  double track_rate_hz = 0;
+  double burst_rate_hz = 0;
+  double duration_s = 1;
+  TPGenerator::channel_t channels_per_link = 2560;
+  uint64_t clock_frequency_hz = 50'000'000; // NOLINT(build/unsigned)
+  timestamp_t tpset_time_width = 62'500;
+  timestamp_t window_time = 625'000;
+  timestamp_t buffer_time = 625'000;
+  size_t tpset_buffer_size = 1000;
+};
+
+// The time taken by each call to one stage, and the allocations made in all of them
+class Stage
+{
+public:
+  explicit Stage(std::string name)
+    : m_name(std::move(name))
+  {}
+
+  template<class F>
+  void run(F&& f)
+  {
+    size_t n_allocations = g_n_allocations;
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    m_allocations += g_n_allocations - n_allocations;
+    m_latencies_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  }
+
+  double total_s() const
+  {
+    double total_ns = 0;
+    for (auto latency : m_latencies_ns) {
+      total_ns += latency;
+    }
+    return 1e-9 * total_ns;
+  }
+
+  void report(size_t n_tps)
+  {
+    std::sort(m_latencies_ns.begin(), m_latencies_ns.end());
+    auto percentile = [this](double p) -> double {
+      if (m_latencies_ns.empty()) {
+        return 0;
+      }
+      return 1e-3 * m_latencies_ns[static_cast<size_t>(p * (m_latencies_ns.size() - 1))];
+    };
+    std::printf("  %-12s %9zu calls %10.3f s total   latency us p50 %9.2f p90 %9.2f p99 %9.2f max %9.2f   %7.3f "
+                "allocs/TP\n",
+                m_name.c_str(),
+                m_latencies_ns.size(),
+                total_s(),
+                percentile(0.5),
+                percentile(0.9),
+                percentile(0.99),
+                percentile(1.),
+                n_tps > 0 ? static_cast<double>(m_allocations) / n_tps : 0.);
+  }
+
+  size_t allocations() const { return m_allocations; }
+
+private:
+  std::string m_name;
+  std::vector<int64_t> m_latencies_ns;
+  size_t m_allocations{ 0 };
+};
+
+// The per-link part of the chain, up to the TASets
+struct Link
+{
+  Link(const std::string& algorithm, const Options& opts)
+    : name("link")
+    , algorithm(algorithm)
+    , tpset_buffer(opts.tpset_buffer_size)
+    , in_buffer(name, this->algorithm)
+    , out_buffer(name, this->algorithm, opts.buffer_time, opts.window_time)
+  {}
+
+  std::string name, algorithm;
+  TPGenerator generator;
+  BufferManager<TPSet> tpset_buffer;
+  TimeSliceInputBuffer<TriggerPrimitive> in_buffer;
+  TimeSliceOutputBuffer<TriggerActivity> out_buffer;
+  TPSliceColumns columns;
+  std::shared_ptr<triggeralgs::TriggerActivityMaker> maker;
+  bool use_columns{ false };
+};
+
+using node_t = zipper::Node<TASet>;
+
+void
+run_chain(const Options& opts, size_t n_links, double noise_rate_hz)
+{
+  std::vector<std::unique_ptr<Link>> links;
+  TPGenerator::Config generator_config;
+  generator_config.n_channels = opts.channels_per_link;
+  generator_config.clock_frequency_hz = opts.clock_frequency_hz;
+  generator_config.noise_rate_hz = noise_rate_hz;
+  generator_config.track_rate_hz = opts.track_rate_hz;
+  generator_config.burst_rate_hz = opts.burst_rate_hz;
+  const timestamp_t start_time = 1'000'000 * opts.tpset_time_width;
+  for (size_t i = 0; i < n_links; ++i) {
+    links.push_back(std::make_unique<Link>(opts.ta_plugin, opts));
+    Link& link = *links.back();
+    generator_config.first_channel = i * opts.channels_per_link;
+    generator_config.seed = i;
+    link.generator.configure(generator_config, start_time);
+    link.maker = make_ta_maker(opts.ta_plugin);
+    link.maker->configure(nlohmann::json::parse(opts.ta_config));
+    link.columns.set_fields(
+      slice_processor_column_fields<triggeralgs::TriggerActivityMaker, TriggerPrimitive, TriggerActivity>(*link.maker));
+    link.use_columns = link.columns.get_fields() != 0;
+  }
+
+  std::string tc_name("tc"), tc_algorithm(opts.tc_plugin);
+  auto tc_maker = make_tc_maker(opts.tc_plugin);
+  tc_maker->configure(nlohmann::json::parse(opts.tc_config));
+  TimeSliceInputBuffer<TriggerActivity> tc_in_buffer(tc_name, tc_algorithm);
+  TimeSliceOutputBuffer<TriggerCandidate> tc_out_buffer(tc_name, tc_algorithm, opts.buffer_time, opts.window_time);
+
+  zipper::merge<node_t> merge(n_links);
+
+  Stage buffer_stage("buffer"), ta_in_stage("ta_input"), ta_maker_stage("ta_maker"), ta_out_stage("ta_output"),
+    zipper_stage("zipper"), tc_in_stage("tc_input"), tc_maker_stage("tc_maker"), tc_out_stage("tc_output");
+
+  size_t n_tps = 0, n_tas = 0, n_tcs = 0, n_tardy = 0;
+  std::vector<TPSet> tpsets(n_links);
+  std::vector<TriggerPrimitive> tp_slice;
+  std::vector<TriggerActivity> tas;
+  std::vector<TASet> tasets;
+  std::vector<node_t> nodes;
+  std::vector<TriggerActivity> ta_slice;
+  std::vector<TriggerCandidate> tcs;
+  std::vector<Set<TriggerCandidate>> tcsets;
+
+  // The TC end of the chain, for the nodes that came out of the zipper
+  auto process_nodes = [&]() {
+    for (node_t& node : nodes) {
+      if (node.payload.type == TASet::Type::kHeartbeat) {
+        tc_out_stage.run([&]() {
+          tc_out_buffer.advance(node.ordering);
+          flush_ready(tc_out_buffer, tcsets);
+        });
+        continue;
+      }
+      timestamp_t slice_start, slice_end;
+      bool complete = false;
+      tc_in_stage.run([&]() {
+        ta_slice.clear();
+        complete = tc_in_buffer.buffer(std::move(node.payload), ta_slice, slice_start, slice_end);
+      });
+      if (complete) {
+        tcs.clear();
+        tc_maker_stage.run([&]() { process_slice(*tc_maker, ta_slice, nullptr, tcs); });
+        tc_out_stage.run([&]() {
+          if (!tcs.empty()) {
+            n_tardy += tc_out_buffer.buffer(tcs);
+          }
+          flush_ready(tc_out_buffer, tcsets);
+        });
+      }
+    }
+    for (auto& tcset : tcsets) {
+      n_tcs += tcset.objects.size();
+    }
+    tcsets.clear();
+    nodes.clear();
+  };
+
+  const timestamp_t end_time = start_time + static_cast<timestamp_t>(opts.duration_s * opts.clock_frequency_hz);
+  for (timestamp_t tpset_end = start_time + opts.tpset_time_width; tpset_end <= end_time;
+       tpset_end += opts.tpset_time_width) {
+    // Generating the TPs isn't part of the chain, so it isn't timed
+    for (size_t i = 0; i < n_links; ++i) {
+      TPSet& tpset = tpsets[i];
+      tpset = TPSet();
+      tpset.type = TPSet::Type::kPayload;
+      tpset.start_time = tpset_end - opts.tpset_time_width;
+      tpset.end_time = tpset_end;
+      links[i]->generator.generate(tpset_end, tpset.objects);
+      n_tps += tpset.objects.size();
+    }
+
+    for (size_t i = 0; i < n_links; ++i) {
+      Link& link = *links[i];
+      buffer_stage.run([&]() { link.tpset_buffer.add(tpsets[i]); });
+
+      timestamp_t slice_start, slice_end;
+      bool complete = false;
+      ta_in_stage.run([&]() {
+        tp_slice.clear();
+        complete = link.in_buffer.buffer(
+          std::move(tpsets[i]), tp_slice, slice_start, slice_end, link.use_columns ? &link.columns : nullptr);
+      });
+      if (!complete) {
+        continue;
+      }
+
+      tas.clear();
+      ta_maker_stage.run(
+        [&]() { process_slice(*link.maker, tp_slice, link.use_columns ? &link.columns : nullptr, tas); });
+      n_tas += tas.size();
+
+      ta_out_stage.run([&]() {
+        if (!tas.empty()) {
+          n_tardy += link.out_buffer.buffer(tas);
+        }
+        // The slice is complete, so data time has reached its end, as if
+        // from a heartbeat. No TASet from this link can now start before
+        // the heartbeat time below, so the zipper can move on without it
+        link.out_buffer.advance(slice_end);
+        flush_ready(link.out_buffer, tasets);
+        TASet heartbeat;
+        heartbeat.type = TASet::Type::kHeartbeat;
+        heartbeat.start_time = heartbeat.end_time =
+          slice_end > opts.window_time + opts.buffer_time ? slice_end - opts.window_time - opts.buffer_time : 0;
+        tasets.push_back(std::move(heartbeat));
+      });
+
+      zipper_stage.run([&]() {
+        for (TASet& taset : tasets) {
+          timestamp_t ordering = taset.start_time;
+          merge.feed(std::move(taset), ordering, i);
+        }
+        merge.drain_waiting(std::back_inserter(nodes));
+      });
+      tasets.clear();
+      process_nodes();
+    }
+  }
+
+  // Drain everything that's left, as TriggerGenericWorker::drain does
+  for (size_t i = 0; i < n_links; ++i) {
+    Link& link = *links[i];
+    timestamp_t slice_start, slice_end;
+    tp_slice.clear();
+    if (link.in_buffer.flush(tp_slice, slice_start, slice_end, link.use_columns ? &link.columns : nullptr)) {
+      tas.clear();
+      process_slice(*link.maker, tp_slice, link.use_columns ? &link.columns : nullptr, tas);
+      n_tas += tas.size();
+      if (!tas.empty()) {
+        n_tardy += link.out_buffer.buffer(tas);
+      }
+    }
+    flush_ready(link.out_buffer, tasets, true);
+    for (TASet& taset : tasets) {
+      timestamp_t ordering = taset.start_time;
+      merge.feed(std::move(taset), ordering, i);
+    }
+    tasets.clear();
+  }
+  merge.drain_full(std::back_inserter(nodes));
+  process_nodes();
+  timestamp_t slice_start, slice_end;
+  ta_slice.clear();
+  if (tc_in_buffer.flush(ta_slice, slice_start, slice_end)) {
+    tcs.clear();
+    process_slice(*tc_maker, ta_slice, nullptr, tcs);
+    if (!tcs.empty()) {
+      n_tardy += tc_out_buffer.buffer(tcs);
+    }
+  }
+  flush_ready(tc_out_buffer, tcsets, true);
+  for (auto& tcset : tcsets) {
+    n_tcs += tcset.objects.size();
+  }
+
+  std::vector<Stage*> stages{ &buffer_stage,  &ta_in_stage,  &ta_maker_stage, &ta_out_stage,
+                              &zipper_stage,  &tc_in_stage,  &tc_maker_stage, &tc_out_stage };
+  double chain_s = 0;
+  size_t n_allocations = 0;
+  for (auto stage : stages) {
+    chain_s += stage->total_s();
+    n_allocations += stage->allocations();
+  }
+
+  std::printf("%zu links, %g Hz/channel noise: %zu TPs -> %zu TAs -> %zu TCs, %zu tardy\n",
+              n_links,
+              noise_rate_hz,
+              n_tps,
+              n_tas,
+              n_tcs,
+              n_tardy);
+  std::printf("  chain %.3f s, %.3f MTPs/s, %.1fx real time, %.3f allocs/TP\n",
+              chain_s,
+              chain_s > 0 ? 1e-6 * n_tps / chain_s : 0.,
+              chain_s > 0 ? opts.duration_s / chain_s : 0.,
+              n_tps > 0 ? static_cast<double>(n_allocations) / n_tps : 0.);
+  for (auto stage : stages) {
+    stage->report(n_tps);
+  }
+  std::fflush(stdout);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  CLI::App app{ "Time the TP -> TA -> TC chain in-process with synthetic TPs, for increasing link counts and rates" };
+
+  Options opts;
+  app.add_option("--ta-plugin", opts.ta_plugin, "TA maker plugin");
+  app.add_option("--ta-config", opts.ta_config, "TA maker configuration, as JSON");
+  app.add_option("--tc-plugin", opts.tc_plugin, "TC maker plugin");
+  app.add_option("--tc-config", opts.tc_config, "TC maker configuration, as JSON");
+  app.add_option("-l,--links", opts.links, "Numbers of links to run with (default 1 2 4 8)");
+  app.add_option("-r,--noise-rates", opts.noise_rates_hz, "Noise TP rates per channel in Hz (default 10 100 1000)");
+  app.add_option("--track-rate", opts.track_rate_hz, "Track rate per link in Hz");
+  app.add_option("--burst-rate", opts.burst_rate_hz, "Burst rate per link in Hz");
+  app.add_option("-d,--duration", opts.duration_s, "Seconds of data to run for each combination (default 1)");
+  app.add_option("--channels-per-link", opts.channels_per_link, "Channels per link (default 2560)");
+  app.add_option("--tpset-width", opts.tpset_time_width, "Ticks per input TPSet (default 62500)");
+  app.add_option("--window-time", opts.window_time, "Output window width in ticks (default 625000)");
+  app.add_option("--buffer-time", opts.buffer_time, "Output buffer time in ticks (default 625000)");
+
+  CLI11_PARSE(app, argc, argv);
+
+  if (opts.tpset_time_width == 0 || opts.window_time == 0) {
+    std::cerr << "TPSet width and window time must be nonzero" << std::endl;
+    return 1;
+  }
+
+  for (size_t n_links : opts.links) {
+    for (double noise_rate_hz : opts.noise_rates_hz) {
+      run_chain(opts, n_links, noise_rate_hz);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,354 @@
+/**
+ * @file trigger_microbenchmarks.cxx Time zipper::merge, BufferManager and the time slice buffers in isolation
+ *
+ * Each benchmark is run over a sweep of its parameters, and the results are
+ * written as JSON, so that they can be tracked over time and compared
+ * before and after a change to one of these data structures
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#include "CLI/CLI.hpp"
+
+#include "../../plugins/zipper.hpp" // NOLINT
+
+#include "trigger/BufferManager.hpp"
+#include "trigger/TPSet.hpp"
+#include "trigger/TimeSliceInputBuffer.hpp"
+#include "trigger/TimeSliceOutputBuffer.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::trigger;
+
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerPrimitive;
+using timestamp_t = dunedaq::daqdataformats::timestamp_t;
+
+namespace {
+
+constexpr double clock_frequency_hz = 50'000'000;
+
+// Time taken by f() in nanoseconds
+template<class F>
+double
+time_ns(F&& f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+nlohmann::json
+result(const std::string& name, nlohmann::json params, nlohmann::json results)
+{
+  return nlohmann::json{ { "benchmark", name }, { "params", std::move(params) }, { "results", std::move(results) } };
+}
+
+// Feed `n_nodes` TPSet nodes from `n_streams` streams, each sending at
+// `rate_hz`, to a zipper::merge, draining it after each round of nodes from
+// all the streams. The streams are evenly staggered, so that with a latency
+// bound shorter than the time between nodes, the zipper sees stale streams.
+// The clock used for latency is the data time, so runs are repeatable
+nlohmann::json
+bench_zipper(size_t n_streams, double rate_hz, int64_t max_latency_us, bool prompt, size_t n_nodes)
+{
+  using node_t = zipper::Node<TPSet>;
+  using clock_t = std::chrono::steady_clock;
+
+  // Build the nodes, in the order they arrive
+  std::vector<node_t> nodes;
+  nodes.reserve(n_nodes);
+  const double period_s = 1 / rate_hz;
+  const auto t0 = clock_t::now();
+  for (size_t i = 0; nodes.size() < n_nodes; ++i) {
+    size_t stream = i % n_streams;
+    double t_s = (i / n_streams) * period_s + stream * period_s / n_streams;
+    node_t node;
+    node.ordering = static_cast<size_t>(t_s * clock_frequency_hz);
+    node.identity = stream;
+    node.debut = t0 + std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(t_s));
+    node.payload.start_time = node.ordering;
+    node.payload.end_time = node.ordering;
+    node.payload.type = TPSet::Type::kPayload;
+    nodes.push_back(std::move(node));
+  }
+
+  zipper::merge<node_t> merge(n_streams, std::chrono::microseconds(max_latency_us));
+  std::vector<node_t> out;
+  out.reserve(n_nodes);
+  const size_t batch = std::max<size_t>(n_streams, 64);
+  double feed_ns = 0, drain_ns = 0;
+  size_t n_rejected = 0;
+  for (size_t first = 0; first < nodes.size(); first += batch) {
+    size_t last = std::min(first + batch, nodes.size());
+    feed_ns += time_ns([&]() {
+      for (size_t i = first; i < last; ++i) {
+        n_rejected += !merge.feed(nodes[i]);
+      }
+    });
+    const auto now = nodes[last - 1].debut;
+    drain_ns += time_ns([&]() {
+      if (prompt) {
+        merge.drain_prompt(std::back_inserter(out), now);
+      } else {
+        merge.drain_waiting(std::back_inserter(out));
+      }
+    });
+  }
+  size_t n_drained = out.size();
+  merge.drain_full(std::back_inserter(out));
+
+  return result("zipper",
+                { { "n_streams", n_streams },
+                  { "rate_hz", rate_hz },
+                  { "max_latency_us", max_latency_us },
+                  { "drain", prompt ? "prompt" : "waiting" },
+                  { "n_nodes", n_nodes } },
+                { { "feed_ns_per_node", feed_ns / n_nodes },
+                  { "drain_ns_per_node", n_drained > 0 ? drain_ns / n_drained : 0. },
+                  { "drained_before_end", n_drained },
+                  { "rejected", n_rejected } });
+}
+
+TPSet
+make_tpset(timestamp_t start_time, timestamp_t width, size_t n_tps, std::mt19937_64& gen)
+{
+  TPSet tpset;
+  tpset.type = TPSet::Type::kPayload;
+  tpset.start_time = start_time;
+  tpset.end_time = start_time + width;
+  std::uniform_int_distribution<timestamp_t> time_dist(start_time, start_time + width - 1);
+  tpset.objects.resize(n_tps);
+  for (auto& tp : tpset.objects) {
+    tp.time_start = time_dist(gen);
+    tp.channel = gen() % 2560;
+  }
+  std::sort(tpset.objects.begin(), tpset.objects.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return a.time_start < b.time_start;
+  });
+  return tpset;
+}
+
+// Fill a BufferManager of `buffer_size` TPSets, timing the adds once it's
+// full, and then time requests for windows `request_width_sets` TPSets wide
+nlohmann::json
+bench_buffer_manager(size_t buffer_size, size_t tps_per_set, size_t request_width_sets, size_t n_requests)
+{
+  const timestamp_t width = 62'500;
+  std::mt19937_64 gen(0);
+
+  // The TPSets are built up front, so that building them isn't timed
+  std::vector<TPSet> tpsets;
+  for (size_t i = 0; i < 2 * buffer_size; ++i) {
+    tpsets.push_back(make_tpset((i + 1) * width, width, tps_per_set, gen));
+  }
+
+  BufferManager<TPSet> buffer(buffer_size);
+  for (size_t i = 0; i < buffer_size; ++i) {
+    buffer.add(tpsets[i]);
+  }
+  double add_ns = time_ns([&]() {
+    for (size_t i = buffer_size; i < tpsets.size(); ++i) {
+      buffer.add(tpsets[i]);
+    }
+  });
+
+  // Windows in the buffered range, not aligned to the TPSets
+  timestamp_t earliest = buffer.get_earliest_start_time();
+  timestamp_t latest = buffer.get_latest_end_time() - request_width_sets * width;
+  std::uniform_int_distribution<timestamp_t> start_dist(earliest, std::max(earliest, latest));
+  std::vector<timestamp_t> starts(n_requests);
+  for (auto& start : starts) {
+    start = start_dist(gen);
+  }
+  size_t n_returned = 0;
+  double request_ns = time_ns([&]() {
+    for (auto start : starts) {
+      n_returned += buffer.get_txsets_in_window(start, start + request_width_sets * width).txsets_in_window.size();
+    }
+  });
+
+  return result("buffer_manager",
+                { { "buffer_size", buffer_size },
+                  { "tps_per_set", tps_per_set },
+                  { "request_width_sets", request_width_sets },
+                  { "n_requests", n_requests } },
+                { { "add_ns_per_set", add_ns / buffer_size },
+                  { "request_ns", request_ns / n_requests },
+                  { "sets_per_request", static_cast<double>(n_returned) / n_requests } });
+}
+
+// Buffer one TPSet from each of `n_streams` streams per time slice and flush
+// the slice, as TriggerGenericWorker does for each heartbeat
+nlohmann::json
+bench_input_buffer(size_t n_streams, size_t tps_per_set, size_t max_tps)
+{
+  const timestamp_t width = 62'500;
+  const size_t n_slices = std::max<size_t>(max_tps / (n_streams * tps_per_set), 10);
+  std::mt19937_64 gen(0);
+
+  std::vector<TPSet> tpsets;
+  tpsets.reserve(n_slices * n_streams);
+  for (size_t i = 0; i < n_slices; ++i) {
+    for (size_t j = 0; j < n_streams; ++j) {
+      tpsets.push_back(make_tpset((i + 1) * width, width, tps_per_set, gen));
+    }
+  }
+
+  std::string name("bench"), algorithm("none");
+  TimeSliceInputBuffer<TriggerPrimitive> buffer(name, algorithm);
+  std::vector<TriggerPrimitive> time_slice;
+  timestamp_t start_time, end_time;
+  double buffer_ns = 0, flush_ns = 0;
+  size_t n_out = 0;
+  for (size_t i = 0; i < n_slices; ++i) {
+    buffer_ns += time_ns([&]() {
+      for (size_t j = 0; j < n_streams; ++j) {
+        buffer.buffer(std::move(tpsets[i * n_streams + j]), time_slice, start_time, end_time);
+      }
+    });
+    time_slice.clear();
+    flush_ns += time_ns([&]() { buffer.flush(time_slice, start_time, end_time); });
+    n_out += time_slice.size();
+  }
+
+  const double n_tps = static_cast<double>(n_slices * n_streams * tps_per_set);
+  return result("time_slice_input_buffer",
+                { { "n_streams", n_streams }, { "tps_per_set", tps_per_set }, { "n_slices", n_slices } },
+                { { "buffer_ns_per_tp", buffer_ns / n_tps },
+                  { "flush_ns_per_tp", flush_ns / n_tps },
+                  { "flush_ns_per_slice", flush_ns / n_slices },
+                  { "tps_out", n_out } });
+}
+
+// Buffer TAs arriving every `spacing` ticks, up to half a window late, in
+// batches, and flush each window once it's ready
+nlohmann::json
+bench_output_buffer(timestamp_t window_time, timestamp_t spacing, size_t n_objects)
+{
+  const size_t batch_size = 100;
+  std::mt19937_64 gen(0);
+  std::uniform_int_distribution<timestamp_t> lateness_dist(0, window_time / 2);
+
+  const timestamp_t start = 1000 * window_time;
+  std::vector<TriggerActivity> tas(n_objects);
+  for (size_t i = 0; i < n_objects; ++i) {
+    tas[i].time_start = start + i * spacing - std::min(lateness_dist(gen), i * spacing);
+  }
+
+  std::string name("bench"), algorithm("none");
+  TimeSliceOutputBuffer<TriggerActivity> buffer(name, algorithm, window_time, window_time);
+  std::vector<TriggerActivity> batch, out;
+  timestamp_t start_time, end_time;
+  double buffer_ns = 0, flush_ns = 0;
+  size_t n_out = 0, n_tardy = 0, n_windows = 0;
+  for (size_t first = 0; first < n_objects; first += batch_size) {
+    batch.assign(tas.begin() + first, tas.begin() + std::min(first + batch_size, n_objects));
+    buffer_ns += time_ns([&]() { n_tardy += buffer.buffer(batch); });
+    flush_ns += time_ns([&]() {
+      while (buffer.ready()) {
+        out.clear();
+        buffer.flush(out, start_time, end_time);
+        n_out += out.size();
+        ++n_windows;
+      }
+    });
+  }
+  // Drain what's left, as a module does at stop
+  flush_ns += time_ns([&]() {
+    while (!buffer.empty()) {
+      out.clear();
+      buffer.flush(out, start_time, end_time);
+      n_out += out.size();
+      ++n_windows;
+    }
+  });
+
+  return result("time_slice_output_buffer",
+                { { "window_time", window_time }, { "spacing_ticks", spacing }, { "n_objects", n_objects } },
+                { { "buffer_ns_per_object", buffer_ns / n_objects },
+                  { "flush_ns_per_object", n_out > 0 ? flush_ns / n_out : 0. },
+                  { "flush_ns_per_window", n_windows > 0 ? flush_ns / n_windows : 0. },
+                  { "objects_out", n_out },
+                  { "tardy", n_tardy } });
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  CLI::App app{ "Microbenchmarks for zipper::merge, BufferManager and the time slice buffers, with JSON output" };
+
+  std::string output_filename;
+  bool quick = false;
+  app.add_option("-o,--output", output_filename, "File to write the JSON results to (default stdout)");
+  app.add_flag("-q,--quick", quick, "Run a tenth as many iterations, eg for a smoke test");
+
+  CLI11_PARSE(app, argc, argv);
+
+  const size_t scale = quick ? 10 : 1;
+  nlohmann::json results = nlohmann::json::array();
+  auto add = [&](nlohmann::json r) {
+    std::cerr << r.dump() << std::endl;
+    results.push_back(std::move(r));
+  };
+
+  for (size_t n_streams : { 1, 4, 16, 64 }) {
+    for (double rate_hz : { 1e3, 1e5 }) {
+      for (int64_t max_latency_us : { 0, 100, 10000 }) {
+        for (bool prompt : { true, false }) {
+          add(bench_zipper(n_streams, rate_hz, max_latency_us, prompt, 1'000'000 / scale));
+        }
+      }
+    }
+  }
+
+  for (size_t buffer_size : { 1000, 10000 }) {
+    for (size_t tps_per_set : { 10, 100 }) {
+      for (size_t request_width_sets : { 1, 10, 100 }) {
+        add(bench_buffer_manager(buffer_size, tps_per_set, request_width_sets, 100'000 / scale));
+      }
+    }
+  }
+
+  for (size_t n_streams : { 1, 4, 16 }) {
+    for (size_t tps_per_set : { 10, 100, 1000 }) {
+      add(bench_input_buffer(n_streams, tps_per_set, 4'000'000 / scale));
+    }
+  }
+
+  for (timestamp_t window_time : { 62'500, 625'000, 6'250'000 }) {
+    for (timestamp_t spacing : { 100, 10'000 }) {
+      add(bench_output_buffer(window_time, spacing, 1'000'000 / scale));
+    }
+  }
+
+  nlohmann::json doc{ { "clock_frequency_hz", clock_frequency_hz }, { "results", results } };
+  if (output_filename.empty()) {
+    std::cout << doc.dump(2) << std::endl;
+  } else {
+    std::ofstream output(output_filename);
+    if (!output) {
+      std::cerr << "Could not open " << output_filename << std::endl;
+      return 1;
+    }
+    output << doc.dump(2) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file FakeTPGenerator.cpp FakeTPGenerator class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FakeTPGenerator.hpp"
+#include "trigger/Issues.hpp"
+#include "trigger/faketpgenerator/Nljs.hpp"
+#include "trigger/faketpgeneratorinfo/InfoNljs.hpp"
+
+#include "appfwk/DAQModuleHelper.hpp"
+#include "appfwk/app/Nljs.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace dunedaq {
+namespace trigger {
+
+FakeTPGenerator::FakeTPGenerator(const std::string& name)
+  : dunedaq::appfwk::DAQModule(name)
+  , m_thread(std::bind(&FakeTPGenerator::do_work, this, std::placeholders::_1))
+  , m_tpset_sink()
+  , m_queue_timeout(100)
+{
+  register_command("conf", &FakeTPGenerator::do_configure);
+  register_command("start", &FakeTPGenerator::do_start);
+  register_command("stop", &FakeTPGenerator::do_stop);
+  register_command("scrap", &FakeTPGenerator::do_scrap);
+}
+
+void
+FakeTPGenerator::init(const nlohmann::json& init_data)
+{
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering init() method";
+  try {
+    m_tpset_sink.reset(new appfwk::DAQSink<TPSet>(appfwk::queue_inst(init_data, "tpset_sink")));
+  } catch (const ers::Issue& excpt) {
+    throw InvalidQueueFatalError(ERS_HERE, get_name(), "tpset_sink", excpt);
+  }
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting init() method";
+}
+
+void
+FakeTPGenerator::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  faketpgeneratorinfo::Info i;
+  i.tpset_sent_count = m_tpset_sent_count.load();
+  i.tp_sent_count = m_tp_sent_count.load();
+  i.heartbeats_sent = m_heartbeats_sent.load();
+  i.late_tpsets_sent = m_late_tpsets_sent.load();
+  i.push_failed_count = m_push_failed_count.load();
+  ci.add(i);
+}
+
+void
+FakeTPGenerator::do_configure(const nlohmann::json& obj)
+{
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_configure() method";
+  m_conf = obj.get<faketpgenerator::Conf>();
+  if (m_conf.tpset_time_width == 0 || m_conf.clock_frequency_hz == 0 || m_conf.generation_speed < 0) {
+    throw InvalidConfiguration(ERS_HERE);
+  }
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_configure() method";
+}
+
+void
+FakeTPGenerator::do_start(const nlohmann::json& /*args*/)
+{
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_start() method";
+  m_tpset_sent_count = 0;
+  m_tp_sent_count = 0;
+  m_heartbeats_sent = 0;
+  m_late_tpsets_sent = 0;
+  m_push_failed_count = 0;
+  m_thread.start_working_thread("fake-tp-gen");
+  TLOG() << get_name() << " successfully started";
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_start() method";
+}
+
+void
+FakeTPGenerator::do_stop(const nlohmann::json& /*args*/)
+{
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_stop() method";
+  m_thread.stop_working_thread();
+  TLOG() << get_name() << " successfully stopped";
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
+}
+
+void
+FakeTPGenerator::do_scrap(const nlohmann::json& /*args*/)
+{
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
+}
+
+bool
+FakeTPGenerator::send(TPSet&& tpset, std::atomic<bool>& running_flag)
+{
+  if (m_conf.generation_speed > 0) {
+    try {
+      m_tpset_sink->push(std::move(tpset), m_queue_timeout);
+      return true;
+    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+      ers::warning(excpt);
+      ++m_push_failed_count;
+      return false;
+    }
+  }
+
+  // Unpaced, we go as fast as the queue accepts TPSets, so wait rather than
+  // drop. The appfwk queues (StdDeQueue, FollySPSCQueue) only move from the
+  // TPSet once it is in the queue and leave it alone when the push times
+  // out, so it can be moved again on the next attempt
+  while (running_flag.load()) {
+    try {
+      m_tpset_sink->push(std::move(tpset), m_queue_timeout);
+      return true;
+    } catch (const dunedaq::appfwk::QueueTimeoutExpired&) {
+      // The queue is still full; try again
+    }
+  }
+  return false;
+}
+
+void
+FakeTPGenerator::do_work(std::atomic<bool>& running_flag)
+{
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_work() method";
+
+  TPGenerator::Config generator_config;
+  generator_config.first_channel = m_conf.first_channel;
+  generator_config.n_channels = m_conf.n_channels;
+  generator_config.clock_frequency_hz = m_conf.clock_frequency_hz;
+  generator_config.seed = m_conf.seed;
+  generator_config.noise_rate_hz = m_conf.noise_rate_hz;
+  generator_config.track_rate_hz = m_conf.track_rate_hz;
+  generator_config.track_length_channels = m_conf.track_length_channels;
+  generator_config.track_max_ticks_per_channel = m_conf.track_max_ticks_per_channel;
+  generator_config.burst_rate_hz = m_conf.burst_rate_hz;
+  generator_config.burst_n_tps = m_conf.burst_n_tps;
+  generator_config.burst_n_channels = m_conf.burst_n_channels;
+  generator_config.burst_duration = m_conf.burst_duration;
+
+  uint64_t width = m_conf.tpset_time_width;     // NOLINT(build/unsigned)
+  uint64_t start_time = m_conf.start_timestamp; // NOLINT(build/unsigned)
+  if (start_time == 0) {
+    std::chrono::duration<double> since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    start_time = static_cast<uint64_t>(since_epoch.count() * m_conf.clock_frequency_hz); // NOLINT(build/unsigned)
+  }
+  start_time -= start_time % width;
+  m_generator.configure(generator_config, start_time);
+
+  // Reserve each TPSet for well above the expected number of TPs, so that
+  // generating into it doesn't reallocate
+  double expected_tps = m_generator.get_expected_n_tps(width);
+  size_t tpset_capacity = static_cast<size_t>(expected_tps + 5 * std::sqrt(expected_tps)) + 16;
+
+  // TPSets that are being held back, with the index of the TPSet after which they'll be sent
+  std::mt19937_64 late_gen(m_conf.seed + 3);
+  std::bernoulli_distribution late_dist(std::clamp(m_conf.late_fraction, 0., 1.));
+  std::deque<std::pair<uint64_t, TPSet>> late_tpsets; // NOLINT(build/unsigned)
+
+  uint64_t next_heartbeat = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+  if (m_conf.heartbeat_interval > 0) {
+    next_heartbeat = start_time + m_conf.heartbeat_interval;
+  }
+
+  // Ticks of data time per second of running
+  double ticks_per_s = m_conf.clock_frequency_hz * m_conf.generation_speed;
+  auto slice_period = std::chrono::milliseconds(10);
+
+  auto run_start_time = std::chrono::steady_clock::now();
+  uint32_t seqno = 0;             // NOLINT(build/unsigned)
+  uint64_t tpset_index = 0;       // NOLINT(build/unsigned)
+  uint64_t end_time = start_time; // NOLINT(build/unsigned)
+
+  while (running_flag.load()) {
+    end_time = start_time + (tpset_index + 1) * width;
+
+    TPSet tpset;
+    tpset.objects.reserve(tpset_capacity);
+    m_generator.generate(end_time, tpset.objects);
+
+    // A TPSet can't be complete until its end time has passed
+    if (ticks_per_s > 0) {
+      std::chrono::duration<double> send_delay((end_time - start_time) / ticks_per_s);
+      auto send_time = run_start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(send_delay);
+      while (running_flag.load() && std::chrono::steady_clock::now() + slice_period < send_time) {
+        std::this_thread::sleep_for(slice_period);
+      }
+      if (!running_flag.load()) {
+        break;
+      }
+      std::this_thread::sleep_until(send_time);
+    }
+
+    if (!tpset.objects.empty()) {
+      // We don't send empty TPSets
+      tpset.start_time = end_time - width;
+      tpset.end_time = end_time;
+      tpset.seqno = seqno;
+      ++seqno;
+      tpset.origin.region_id = m_conf.region_id;
+      tpset.origin.element_id = m_conf.element_id;
+      tpset.type = TPSet::Type::kPayload;
+
+      size_t n_tps = tpset.objects.size();
+      if (late_dist(late_gen)) {
+        late_tpsets.emplace_back(tpset_index + m_conf.late_delay_tpsets, std::move(tpset));
+      } else if (send(std::move(tpset), running_flag)) {
+        ++m_tpset_sent_count;
+        m_tp_sent_count += n_tps;
+      }
+    }
+
+    while (!late_tpsets.empty() && late_tpsets.front().first <= tpset_index) {
+      size_t n_tps = late_tpsets.front().second.objects.size();
+      if (send(std::move(late_tpsets.front().second), running_flag)) {
+        ++m_tpset_sent_count;
+        ++m_late_tpsets_sent;
+        m_tp_sent_count += n_tps;
+      }
+      late_tpsets.pop_front();
+    }
+
+    while (next_heartbeat <= end_time) {
+      TPSet heartbeat;
+      heartbeat.type = TPSet::Type::kHeartbeat;
+      heartbeat.start_time = next_heartbeat;
+      heartbeat.end_time = next_heartbeat;
+      heartbeat.origin.region_id = m_conf.region_id;
+      heartbeat.origin.element_id = m_conf.element_id;
+      if (send(std::move(heartbeat), running_flag)) {
+        ++m_heartbeats_sent;
+      }
+      next_heartbeat += m_conf.heartbeat_interval;
+    }
+
+    ++tpset_index;
+  }
+
+  std::chrono::duration<double> time_s = std::chrono::steady_clock::now() - run_start_time;
+  TLOG() << get_name() << " generated " << tpset_index << " TPSet windows up to timestamp " << end_time << ", and sent "
+         << m_tpset_sent_count << " TPSets (" << m_tp_sent_count << " TPs, " << m_tp_sent_count / time_s.count()
+         << " TPs/s), " << m_late_tpsets_sent << " of them late, and " << m_heartbeats_sent << " heartbeats. "
+         << m_push_failed_count << " failed to push, and " << late_tpsets.size() << " late TPSets were never sent";
+
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
+}
+
+} // namespace trigger
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::trigger::FakeTPGenerator)
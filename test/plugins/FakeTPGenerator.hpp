@@ -0,0 +1,82 @@
+/**
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_TEST_PLUGINS_FAKETPGENERATOR_HPP_
+#define TRIGGER_TEST_PLUGINS_FAKETPGENERATOR_HPP_
+
+#include "trigger/TPGenerator.hpp"
+#include "trigger/TPSet.hpp"
+
+#include "trigger/faketpgenerator/Structs.hpp"
+#include "trigger/faketpgeneratorinfo/InfoStructs.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/DAQSink.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief FakeTPGenerator sends TPSets of synthetic TPs from a TPGenerator:
+ * noise, plus optional tracks and supernova-like bursts. It can also send
+ * heartbeats, and hold some TPSets back to send them late and out of order.
+ */
+class FakeTPGenerator : public dunedaq::appfwk::DAQModule
+{
+public:
+  /**
+   * @brief FakeTPGenerator Constructor
+   * @param name Instance name for this FakeTPGenerator instance
+   */
+  explicit FakeTPGenerator(const std::string& name);
+
+  FakeTPGenerator(const FakeTPGenerator&) = delete;            ///< FakeTPGenerator is not copy-constructible
+  FakeTPGenerator& operator=(const FakeTPGenerator&) = delete; ///< FakeTPGenerator is not copy-assignable
+  FakeTPGenerator(FakeTPGenerator&&) = delete;                 ///< FakeTPGenerator is not move-constructible
+  FakeTPGenerator& operator=(FakeTPGenerator&&) = delete;      ///< FakeTPGenerator is not move-assignable
+
+  void init(const nlohmann::json& obj) override;
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
+
+private:
+  // Commands
+  void do_configure(const nlohmann::json& obj);
+  void do_start(const nlohmann::json& obj);
+  void do_stop(const nlohmann::json& obj);
+  void do_scrap(const nlohmann::json& obj);
+
+  // Threading
+  dunedaq::utilities::WorkerThread m_thread;
+  void do_work(std::atomic<bool>&);
+
+  // Push `tpset`, retrying while the queue is full if we're unpaced. Returns false if it was dropped
+  bool send(TPSet&& tpset, std::atomic<bool>& running_flag);
+
+  // Configuration
+  faketpgenerator::Conf m_conf;
+  std::unique_ptr<appfwk::DAQSink<TPSet>> m_tpset_sink;
+  std::chrono::milliseconds m_queue_timeout;
+
+  TPGenerator m_generator;
+
+  // Opmon variables
+  using metric_counter_type = decltype(faketpgeneratorinfo::Info::tpset_sent_count);
+  std::atomic<metric_counter_type> m_tpset_sent_count{ 0 };
+  std::atomic<metric_counter_type> m_tp_sent_count{ 0 };
+  std::atomic<metric_counter_type> m_heartbeats_sent{ 0 };
+  std::atomic<metric_counter_type> m_late_tpsets_sent{ 0 };
+  std::atomic<metric_counter_type> m_push_failed_count{ 0 };
+};
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_TEST_PLUGINS_FAKETPGENERATOR_HPP_
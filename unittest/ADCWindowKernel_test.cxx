@@ -0,0 +1,167 @@
+/**
+ * @file ADCWindowKernel_test.cxx  ADC window kernels and fast ADCSimpleWindow maker Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/ADCWindowKernel.hpp"
+#include "trigger/TriggerActivityMakerADCSimpleWindowFast.hpp"
+
+#include "triggeralgs/ADCSimpleWindow/TriggerActivityMakerADCSimpleWindow.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE ADCWindowKernel_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+std::vector<triggeralgs::TriggerPrimitive>
+make_tps(size_t n, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<uint64_t> gap(0, 60);        // NOLINT(build/unsigned)
+  std::uniform_int_distribution<uint32_t> adc(1, 400);       // NOLINT(build/unsigned)
+  std::uniform_int_distribution<uint32_t> channel(0, 10000); // NOLINT(build/unsigned)
+
+  std::vector<triggeralgs::TriggerPrimitive> tps(n);
+  uint64_t time = 1000; // NOLINT(build/unsigned)
+  for (auto& tp : tps) {
+    time += gap(gen);
+    tp.time_start = time;
+    tp.time_peak = time + 5;
+    tp.time_over_threshold = 20;
+    tp.channel = channel(gen);
+    tp.adc_integral = adc(gen);
+    tp.adc_peak = tp.adc_integral / 4;
+  }
+  return tps;
+}
+
+void
+check_same_tas(const std::vector<triggeralgs::TriggerActivity>& expected,
+               const std::vector<triggeralgs::TriggerActivity>& got)
+{
+  BOOST_REQUIRE_EQUAL(expected.size(), got.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    BOOST_CHECK_EQUAL(expected[i].time_start, got[i].time_start);
+    BOOST_CHECK_EQUAL(expected[i].time_end, got[i].time_end);
+    BOOST_CHECK_EQUAL(expected[i].channel_peak, got[i].channel_peak);
+    BOOST_CHECK_EQUAL(expected[i].adc_integral, got[i].adc_integral);
+    BOOST_CHECK_EQUAL(expected[i].inputs.size(), got[i].inputs.size());
+  }
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(PrefixSum)
+{
+  std::vector<uint32_t> adc{ 3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 0xffffffff, 0xffffffff, 7 }; // NOLINT(build/unsigned)
+  for (bool use_simd : { false, true }) {
+    std::vector<uint64_t> prefix(adc.size() + 1); // NOLINT(build/unsigned)
+    prefix[0] = 10;
+    trigger::adcwindow::prefix_sum(adc.data(), adc.size(), prefix.data(), use_simd);
+
+    uint64_t expected = 10; // NOLINT(build/unsigned)
+    for (size_t i = 0; i < adc.size(); ++i) {
+      expected += adc[i];
+      BOOST_CHECK_EQUAL(prefix[i + 1], expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FindFirstAtLeast)
+{
+  std::vector<uint64_t> times; // NOLINT(build/unsigned)
+  for (uint64_t t = 0; t < 100; ++t) { // NOLINT(build/unsigned)
+    times.push_back(0xfffffffffffff000ULL + 2 * t);
+  }
+  for (bool use_simd : { false, true }) {
+    for (size_t from : { 0, 3, 50 }) {
+      for (uint64_t offset = 0; offset < 210; ++offset) { // NOLINT(build/unsigned)
+        uint64_t value = 0xfffffffffffff000ULL + offset;  // NOLINT(build/unsigned)
+        size_t expected = std::lower_bound(times.begin() + from, times.end(), value) - times.begin();
+        BOOST_CHECK_EQUAL(trigger::adcwindow::find_first_at_least(times.data(), from, times.size(), value, use_simd),
+                          expected);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MatchesReference)
+{
+  nlohmann::json config = { { "window_length", 100 }, { "adc_threshold", 1500 } };
+  auto tps = make_tps(20000, 1234);
+
+  triggeralgs::TriggerActivityMakerADCSimpleWindow reference;
+  reference.configure(config);
+  std::vector<triggeralgs::TriggerActivity> expected;
+  for (auto const& tp : tps) {
+    reference(tp, expected);
+  }
+  BOOST_REQUIRE(!expected.empty());
+
+  for (bool use_avx2 : { false, true }) {
+    nlohmann::json fast_config = config;
+    fast_config["fast_path"] = true;
+    fast_config["use_avx2"] = use_avx2;
+
+    trigger::TriggerActivityMakerADCSimpleWindowFast fast;
+    fast.configure(fast_config);
+    BOOST_REQUIRE(fast.fast_path_enabled());
+
+    // Feed the TPs in uneven slices, so that windows span slice boundaries
+    std::vector<triggeralgs::TriggerActivity> got;
+    size_t slice_size = 1;
+    for (size_t i = 0; i < tps.size(); i += slice_size, slice_size = slice_size * 3 % 97 + 1) {
+      size_t end = std::min(tps.size(), i + slice_size);
+      fast(tps.data() + i, tps.data() + end, got);
+    }
+    check_same_tas(expected, got);
+
+    // Same again, taking the start times and ADC sums from the slice
+    // columns, which are all that it asks for
+    trigger::TriggerActivityMakerADCSimpleWindowFast columns_fast;
+    columns_fast.configure(fast_config);
+    trigger::TPSliceColumns columns(columns_fast.get_column_fields());
+    BOOST_CHECK_EQUAL(columns.get_fields(), trigger::TPSliceColumns::kTimeStart | trigger::TPSliceColumns::kAdcIntegral);
+    got.clear();
+    slice_size = 1;
+    for (size_t i = 0; i < tps.size(); i += slice_size, slice_size = slice_size * 3 % 97 + 1) {
+      size_t end = std::min(tps.size(), i + slice_size);
+      columns.assign(tps.data() + i, tps.data() + end);
+      columns_fast(columns, tps.data() + i, tps.data() + end, got);
+    }
+    check_same_tas(expected, got);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SingleTPCalls)
+{
+  nlohmann::json config = { { "window_length", 50 }, { "adc_threshold", 600 }, { "fast_path", true } };
+  auto tps = make_tps(2000, 99);
+
+  triggeralgs::TriggerActivityMakerADCSimpleWindow reference;
+  reference.configure(config);
+  trigger::TriggerActivityMakerADCSimpleWindowFast fast;
+  fast.configure(config);
+
+  std::vector<triggeralgs::TriggerActivity> expected, got;
+  for (auto const& tp : tps) {
+    reference(tp, expected);
+    fast(tp, got);
+  }
+  check_same_tas(expected, got);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
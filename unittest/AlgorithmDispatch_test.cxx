@@ -0,0 +1,221 @@
+/**
+ * @file AlgorithmDispatch_test.cxx  Typed slice processor registry Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/AlgorithmDispatch.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE AlgorithmDispatch_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+// Emits one TA for every `m_group` TPs
+class CountingMaker : public triggeralgs::TriggerActivityMaker
+{
+public:
+  void operator()(const triggeralgs::TriggerPrimitive& tp, std::vector<triggeralgs::TriggerActivity>& out) override
+  {
+    ++m_n_calls;
+    if (m_n_calls % m_group == 0) {
+      triggeralgs::TriggerActivity ta;
+      ta.time_start = tp.time_start;
+      out.push_back(ta);
+    }
+  }
+
+  size_t m_n_calls{ 0 };
+  size_t m_group{ 2 };
+};
+
+class UnregisteredMaker : public CountingMaker
+{};
+
+// Advertises a batch entry point, which should be preferred over operator() per TP
+class BatchMaker : public triggeralgs::TriggerActivityMaker
+{
+public:
+  using triggeralgs::TriggerActivityMaker::operator();
+
+  void operator()(const triggeralgs::TriggerPrimitive& /*tp*/, std::vector<triggeralgs::TriggerActivity>& /*out*/) override
+  {
+    ++m_n_single_calls;
+  }
+
+  void operator()(const triggeralgs::TriggerPrimitive* first,
+                  const triggeralgs::TriggerPrimitive* last,
+                  std::vector<triggeralgs::TriggerActivity>& out)
+  {
+    ++m_n_batch_calls;
+    triggeralgs::TriggerActivity ta;
+    ta.time_start = first->time_start;
+    ta.time_end = (last - 1)->time_start;
+    out.push_back(ta);
+  }
+
+  size_t m_n_single_calls{ 0 };
+  size_t m_n_batch_calls{ 0 };
+};
+
+// Also takes the column view of the slice, which should be preferred when it's available
+class ColumnsMaker : public BatchMaker
+{
+public:
+  using BatchMaker::operator();
+
+  void operator()(const trigger::TPSliceColumns& columns,
+                  const triggeralgs::TriggerPrimitive* /*first*/,
+                  const triggeralgs::TriggerPrimitive* /*last*/,
+                  std::vector<triggeralgs::TriggerActivity>& out)
+  {
+    ++m_n_columns_calls;
+    triggeralgs::TriggerActivity ta;
+    ta.time_start = columns.time_start()[0];
+    ta.time_end = columns.time_start()[columns.size() - 1];
+    out.push_back(ta);
+  }
+
+  size_t m_n_columns_calls{ 0 };
+};
+
+const bool registered = trigger::register_slice_processor<triggeralgs::TriggerActivityMaker,
+                                                          triggeralgs::TriggerPrimitive,
+                                                          triggeralgs::TriggerActivity,
+                                                          CountingMaker>();
+
+const bool batch_registered = trigger::register_slice_processor<triggeralgs::TriggerActivityMaker,
+                                                                triggeralgs::TriggerPrimitive,
+                                                                triggeralgs::TriggerActivity,
+                                                                BatchMaker>();
+
+const bool columns_registered = trigger::register_slice_processor<triggeralgs::TriggerActivityMaker,
+                                                                  triggeralgs::TriggerPrimitive,
+                                                                  triggeralgs::TriggerActivity,
+                                                                  ColumnsMaker>();
+
+static_assert(!trigger::has_batch_call<CountingMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>::value);
+static_assert(trigger::has_batch_call<BatchMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>::value);
+static_assert(!trigger::has_columns_call<BatchMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>::value);
+static_assert(trigger::has_columns_call<ColumnsMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>::value);
+} // namespace
+
+BOOST_AUTO_TEST_CASE(FindRegistered)
+{
+  BOOST_REQUIRE(registered);
+
+  CountingMaker maker;
+  triggeralgs::TriggerActivityMaker& base = maker;
+  auto processor =
+    trigger::find_slice_processor<triggeralgs::TriggerActivityMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>(
+      base);
+  BOOST_REQUIRE(processor != nullptr);
+
+  std::vector<triggeralgs::TriggerPrimitive> slice(5);
+  for (size_t i = 0; i < slice.size(); ++i) {
+    slice[i].time_start = 100 * i;
+  }
+  std::vector<triggeralgs::TriggerActivity> out;
+  processor(base, slice.data(), slice.data() + slice.size(), nullptr, out);
+
+  BOOST_CHECK_EQUAL(maker.m_n_calls, 5);
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  BOOST_CHECK_EQUAL(out[0].time_start, 100);
+  BOOST_CHECK_EQUAL(out[1].time_start, 300);
+}
+
+BOOST_AUTO_TEST_CASE(FallBack)
+{
+  // Registration is by exact concrete class, so a derived class that
+  // wasn't registered gets no processor, and will be called virtually
+  UnregisteredMaker maker;
+  triggeralgs::TriggerActivityMaker& base = maker;
+  auto processor =
+    trigger::find_slice_processor<triggeralgs::TriggerActivityMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>(
+      base);
+  BOOST_CHECK(processor == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Batch)
+{
+  BOOST_REQUIRE(batch_registered);
+
+  BatchMaker maker;
+  triggeralgs::TriggerActivityMaker& base = maker;
+  auto processor =
+    trigger::find_slice_processor<triggeralgs::TriggerActivityMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>(
+      base);
+  BOOST_REQUIRE(processor != nullptr);
+
+  std::vector<triggeralgs::TriggerPrimitive> slice(1000);
+  for (size_t i = 0; i < slice.size(); ++i) {
+    slice[i].time_start = 10 * i;
+  }
+  std::vector<triggeralgs::TriggerActivity> out;
+  processor(base, slice.data(), slice.data() + slice.size(), nullptr, out);
+
+  BOOST_CHECK_EQUAL(maker.m_n_batch_calls, 1);
+  BOOST_CHECK_EQUAL(maker.m_n_single_calls, 0);
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  BOOST_CHECK_EQUAL(out[0].time_start, 0);
+  BOOST_CHECK_EQUAL(out[0].time_end, 9990);
+}
+
+BOOST_AUTO_TEST_CASE(Columns)
+{
+  BOOST_REQUIRE(columns_registered);
+
+  ColumnsMaker maker;
+  triggeralgs::TriggerActivityMaker& base = maker;
+  auto processor =
+    trigger::find_slice_processor<triggeralgs::TriggerActivityMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>(
+      base);
+  BOOST_REQUIRE(processor != nullptr);
+  bool uses_columns = trigger::slice_processor_uses_columns<triggeralgs::TriggerActivityMaker,
+                                                            triggeralgs::TriggerPrimitive,
+                                                            triggeralgs::TriggerActivity>(base);
+  BOOST_CHECK(uses_columns);
+  // It doesn't say which columns it reads, so it gets all of them
+  auto column_fields = trigger::slice_processor_column_fields<triggeralgs::TriggerActivityMaker,
+                                                             triggeralgs::TriggerPrimitive,
+                                                             triggeralgs::TriggerActivity>(base);
+  BOOST_CHECK_EQUAL(column_fields, trigger::TPSliceColumns::s_all_fields);
+
+  std::vector<triggeralgs::TriggerPrimitive> slice(100);
+  for (size_t i = 0; i < slice.size(); ++i) {
+    slice[i].time_start = 10 * i;
+  }
+  trigger::TPSliceColumns columns;
+  columns.assign(slice.data(), slice.data() + slice.size());
+
+  std::vector<triggeralgs::TriggerActivity> out;
+  processor(base, slice.data(), slice.data() + slice.size(), &columns, out);
+  BOOST_CHECK_EQUAL(maker.m_n_columns_calls, 1);
+  BOOST_CHECK_EQUAL(maker.m_n_batch_calls, 0);
+
+  // Without columns, the batch entry point is used instead
+  processor(base, slice.data(), slice.data() + slice.size(), nullptr, out);
+  BOOST_CHECK_EQUAL(maker.m_n_columns_calls, 1);
+  BOOST_CHECK_EQUAL(maker.m_n_batch_calls, 1);
+
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  BOOST_CHECK_EQUAL(out[0].time_end, 990);
+  BOOST_CHECK_EQUAL(out[1].time_end, 990);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
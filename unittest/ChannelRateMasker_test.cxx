@@ -0,0 +1,144 @@
+/**
+ * @file ChannelRateMasker_test.cxx  ChannelRateMasker class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/ChannelRateMasker.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE ChannelRateMasker_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <limits>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::ChannelRateMasker;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+triggeralgs::TriggerPrimitive
+make_tp(triggeralgs::timestamp_t time, uint32_t channel) // NOLINT(build/unsigned)
+{
+  triggeralgs::TriggerPrimitive tp;
+  tp.time_start = time;
+  tp.channel = channel;
+  return tp;
+}
+
+// 10 TPs per 1000-tick bin at most, and masked channels are checked again after 3000 ticks
+ChannelRateMasker::Config
+make_config()
+{
+  ChannelRateMasker::Config config;
+  config.clock_frequency_hz = 1000;
+  config.rate_interval = 1000;
+  config.max_rate_hz = 10;
+  config.cooldown = 3000;
+  return config;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  ChannelRateMasker masker;
+  masker.configure(ChannelRateMasker::Config());
+
+  std::vector<triggeralgs::TriggerPrimitive> out;
+  for (int i = 0; i < 1000; ++i) {
+    masker(make_tp(i, 5), out);
+  }
+  BOOST_CHECK_EQUAL(out.size(), 1000);
+  BOOST_CHECK_EQUAL(masker.get_n_dropped(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(MaskNoisyChannel)
+{
+  ChannelRateMasker masker;
+  masker.configure(make_config());
+
+  std::vector<triggeralgs::TriggerPrimitive> out;
+  // Channel 7 fires every 10 ticks, channel 3000 every 200
+  for (triggeralgs::timestamp_t t = 0; t < 1000; t += 10) {
+    masker(make_tp(t, 7), out);
+    if (t % 200 == 0) {
+      masker(make_tp(t, 3000), out);
+    }
+  }
+
+  // The first 10 TPs on channel 7 get through before it is masked
+  BOOST_CHECK_EQUAL(out.size(), 10 + 5);
+  BOOST_CHECK_EQUAL(masker.get_n_passed(), 15);
+  BOOST_CHECK_EQUAL(masker.get_n_dropped(), 90);
+  BOOST_CHECK_EQUAL(masker.get_n_mask_events(), 1);
+
+  auto masked = masker.get_masked_channels();
+  BOOST_REQUIRE_EQUAL(masked.size(), 1);
+  BOOST_CHECK_EQUAL(masked[0].channel, 7);
+  BOOST_CHECK_EQUAL(masked[0].masked_until, 100 + 3000);
+}
+
+BOOST_AUTO_TEST_CASE(Cooldown)
+{
+  ChannelRateMasker masker;
+  masker.configure(make_config());
+
+  std::vector<triggeralgs::TriggerPrimitive> out;
+  for (triggeralgs::timestamp_t t = 0; t < 200; t += 10) {
+    masker(make_tp(t, 7), out);
+  }
+  BOOST_CHECK_EQUAL(masker.get_masked_channels().size(), 1);
+
+  // Still noisy when the cooldown ends, so it stays masked
+  for (triggeralgs::timestamp_t t = 2000; t < 3200; t += 10) {
+    masker(make_tp(t, 7), out);
+  }
+  BOOST_CHECK_EQUAL(out.size(), 10);
+  BOOST_CHECK_EQUAL(masker.get_masked_channels().size(), 1);
+
+  // Goes quiet, and a heartbeat after the extended cooldown unmasks it
+  masker.flush(6000, out);
+  BOOST_CHECK_EQUAL(masker.get_masked_channels().size(), 1);
+  masker.flush(6300, out);
+  BOOST_CHECK_EQUAL(masker.get_masked_channels().size(), 0);
+
+  masker(make_tp(6400, 7), out);
+  BOOST_CHECK_EQUAL(out.size(), 11);
+  BOOST_CHECK_EQUAL(masker.get_n_mask_events(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ChannelAboveMax)
+{
+  ChannelRateMasker masker;
+  auto config = make_config();
+  config.max_channel = 100;
+  masker.configure(config);
+
+  // A channel number from a corrupt TP is filtered like any other, without
+  // the per-channel array growing to hold it
+  const ChannelRateMasker::channel_t bad_channel = std::numeric_limits<ChannelRateMasker::channel_t>::max();
+  std::vector<triggeralgs::TriggerPrimitive> out;
+  for (triggeralgs::timestamp_t t = 0; t < 1000; t += 10) {
+    masker(make_tp(t, bad_channel), out);
+    masker(make_tp(t, 7), out);
+  }
+  BOOST_CHECK_EQUAL(out.size(), 20);
+  BOOST_CHECK_EQUAL(masker.get_n_mask_events(), 2);
+
+  auto masked = masker.get_masked_channels();
+  BOOST_REQUIRE_EQUAL(masked.size(), 2);
+  BOOST_CHECK_EQUAL(masked[0].channel, bad_channel);
+
+  masker.flush(5000, out);
+  BOOST_CHECK_EQUAL(masker.get_masked_channels().size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+/**
+ * @file DecisionWindowIndex_test.cxx  DecisionWindowIndex class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/DecisionWindowIndex.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE DecisionWindowIndex_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::DecisionWindowIndex;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const daqdataformats::GeoID link0(daqdataformats::GeoID::SystemType::kTPC, 0, 0);
+const daqdataformats::GeoID link1(daqdataformats::GeoID::SystemType::kTPC, 0, 1);
+
+daqdataformats::ComponentRequest
+make_request(const daqdataformats::GeoID& link, daqdataformats::timestamp_t begin, daqdataformats::timestamp_t end)
+{
+  daqdataformats::ComponentRequest request;
+  request.component = link;
+  request.window_begin = begin;
+  request.window_end = end;
+  return request;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  DecisionWindowIndex index;
+  index.configure(0);
+
+  std::vector<daqdataformats::ComponentRequest> components{ make_request(link0, 100, 200) };
+  index.record(components);
+  BOOST_CHECK(index.apply(components) == DecisionWindowIndex::Result::kNew);
+  BOOST_CHECK_EQUAL(index.get_n_windows(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Merge)
+{
+  DecisionWindowIndex index;
+  index.configure(1000);
+
+  index.record({ make_request(link0, 100, 200), make_request(link1, 100, 200) });
+
+  std::vector<daqdataformats::ComponentRequest> components{ make_request(link0, 120, 180),
+                                                            make_request(link1, 100, 200) };
+  BOOST_CHECK(index.apply(components) == DecisionWindowIndex::Result::kMerged);
+  BOOST_CHECK(components.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Trim)
+{
+  DecisionWindowIndex index;
+  index.configure(1000);
+
+  index.record({ make_request(link0, 100, 200), make_request(link1, 100, 200) });
+
+  std::vector<daqdataformats::ComponentRequest> components{
+    make_request(link0, 150, 250), // overlaps the end of the recorded window
+    make_request(link1, 50, 150),  // overlaps the start of the recorded window
+  };
+  BOOST_CHECK(index.apply(components) == DecisionWindowIndex::Result::kTrimmed);
+  BOOST_REQUIRE_EQUAL(components.size(), 2);
+  BOOST_CHECK_EQUAL(components[0].window_begin, 200);
+  BOOST_CHECK_EQUAL(components[0].window_end, 250);
+  BOOST_CHECK_EQUAL(components[1].window_begin, 50);
+  BOOST_CHECK_EQUAL(components[1].window_end, 100);
+
+  // A link that's entirely covered is removed, leaving the others
+  components = { make_request(link0, 110, 190), make_request(link1, 300, 400) };
+  BOOST_CHECK(index.apply(components) == DecisionWindowIndex::Result::kTrimmed);
+  BOOST_REQUIRE_EQUAL(components.size(), 1);
+  BOOST_CHECK(components[0].component == link1);
+}
+
+BOOST_AUTO_TEST_CASE(Containing)
+{
+  DecisionWindowIndex index;
+  index.configure(1000);
+
+  index.record({ make_request(link0, 100, 200) });
+
+  // The request can't be split in two, so it's kept whole
+  std::vector<daqdataformats::ComponentRequest> components{ make_request(link0, 50, 250) };
+  BOOST_CHECK(index.apply(components) == DecisionWindowIndex::Result::kNew);
+  BOOST_CHECK_EQUAL(components[0].window_begin, 50);
+  BOOST_CHECK_EQUAL(components[0].window_end, 250);
+}
+
+BOOST_AUTO_TEST_CASE(Expiry)
+{
+  DecisionWindowIndex index;
+  index.configure(100);
+
+  index.record({ make_request(link0, 100, 200) });
+  BOOST_CHECK_EQUAL(index.get_n_windows(), 1);
+
+  // Starts more than 100 ticks after the recorded window ends, so the
+  // recorded window is forgotten
+  std::vector<daqdataformats::ComponentRequest> components{ make_request(link0, 400, 500) };
+  BOOST_CHECK(index.apply(components) == DecisionWindowIndex::Result::kNew);
+  BOOST_CHECK_EQUAL(index.get_n_windows(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+/**
+ * @file InterruptibleSource_test.cxx  InterruptibleSource class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/InterruptibleSource.hpp"
+#include "trigger/StopSignal.hpp"
+
+#include "appfwk/DAQSource.hpp"
+#include "appfwk/QueueRegistry.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE InterruptibleSource_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace dunedaq;
+using namespace dunedaq::trigger;
+
+using source_t = InterruptibleSource<int>;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+// The queue registry can only be configured once, so each test case uses
+// its own queue from the same configuration
+void
+configure_queues()
+{
+  static bool configured = false;
+  if (configured) {
+    return;
+  }
+  appfwk::QueueRegistry::get().configure({ { "data", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+                                           { "stop", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+                                           { "drain", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+                                           { "timeout", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } } });
+  configured = true;
+}
+
+void
+push(const std::string& queue, int value)
+{
+  appfwk::QueueRegistry::get().get_queue<int>(queue)->push(std::move(value), milliseconds(0));
+}
+
+milliseconds
+since(steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<milliseconds>(steady_clock::now() - start);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(DataWakesWaiter)
+{
+  configure_queues();
+  appfwk::DAQSource<int> queue("data");
+  StopSignal stop;
+  // With a long stop check interval, only the data arriving can end the wait early
+  source_t source(queue, stop, milliseconds(5000));
+
+  std::thread pusher([]() {
+    std::this_thread::sleep_for(milliseconds(50));
+    push("data", 7);
+  });
+  auto start = steady_clock::now();
+  int value = 0;
+  BOOST_CHECK(source.pop(value, milliseconds(10000)) == source_t::Status::kData);
+  auto waited = since(start);
+  pusher.join();
+
+  BOOST_CHECK_EQUAL(value, 7);
+  BOOST_CHECK_GE(waited.count(), 40);
+  BOOST_CHECK_LT(waited.count(), 2000);
+}
+
+BOOST_AUTO_TEST_CASE(StopLatency)
+{
+  configure_queues();
+  appfwk::DAQSource<int> queue("stop");
+  StopSignal stop;
+  source_t source(queue, stop);
+
+  std::thread stopper([&stop]() {
+    std::this_thread::sleep_for(milliseconds(50));
+    stop.request_stop();
+  });
+  auto start = steady_clock::now();
+  int value = 0;
+  BOOST_CHECK(!source.pop(value));
+  auto waited = since(start);
+  stopper.join();
+
+  // The stop is noticed within one stop check interval, not after a queue timeout
+  BOOST_CHECK_GE(waited.count(), 40);
+  BOOST_CHECK_LT(waited.count(), 50 + 2 * source_t::s_default_stop_check_interval.count());
+
+  // Once stopped, an empty queue doesn't block at all
+  start = steady_clock::now();
+  BOOST_CHECK(source.pop(value, milliseconds(10000)) == source_t::Status::kStopped);
+  BOOST_CHECK_LT(since(start).count(), source_t::s_default_stop_check_interval.count());
+}
+
+BOOST_AUTO_TEST_CASE(DrainAfterStop)
+{
+  configure_queues();
+  appfwk::DAQSource<int> queue("drain");
+  StopSignal stop;
+  source_t source(queue, stop);
+
+  for (int i = 0; i < 3; ++i) {
+    push("drain", i);
+  }
+  stop.request_stop();
+
+  int value = -1;
+  for (int i = 0; i < 3; ++i) {
+    BOOST_REQUIRE(source.pop(value));
+    BOOST_CHECK_EQUAL(value, i);
+  }
+  BOOST_CHECK(!source.pop(value));
+
+  stop.reset();
+  push("drain", 3);
+  BOOST_CHECK(source.pop(value, milliseconds(100)) == source_t::Status::kData);
+  BOOST_CHECK_EQUAL(value, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Timeout)
+{
+  configure_queues();
+  appfwk::DAQSource<int> queue("timeout");
+  StopSignal stop;
+  source_t source(queue, stop);
+
+  auto start = steady_clock::now();
+  int value = 0;
+  BOOST_CHECK(source.pop(value, milliseconds(35)) == source_t::Status::kTimeout);
+  BOOST_CHECK_GE(since(start).count(), 30);
+  BOOST_CHECK(!source.try_pop(value));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
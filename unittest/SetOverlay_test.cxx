@@ -0,0 +1,266 @@
+/**
+ * @file SetOverlay_test.cxx  Set overlay Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/Issues.hpp"
+#include "trigger/SetOverlay.hpp"
+#include "trigger/TASet.hpp"
+#include "trigger/TCSet.hpp"
+
+#include "serialization/Serialization.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE SetOverlay_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::SetOverlayView;
+using trigger::TASet;
+using trigger::TCSet;
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerCandidate;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+TASet
+make_taset(size_t n_tas)
+{
+  TASet set;
+  set.seqno = 42;
+  set.origin = daqdataformats::GeoID(daqdataformats::GeoID::SystemType::kDataSelection, 3, 7);
+  set.type = TASet::Type::kPayload;
+  set.start_time = 1000;
+  set.end_time = 2000;
+  for (size_t i = 0; i < n_tas; ++i) {
+    TriggerActivity ta;
+    ta.time_start = 1000 + 10 * i;
+    ta.time_end = 1005 + 10 * i;
+    ta.channel_start = i;
+    ta.adc_integral = 100 * i;
+    // A different number of TPs in each TA, including none
+    for (size_t j = 0; j < i; ++j) {
+      triggeralgs::TriggerPrimitive tp;
+      tp.time_start = ta.time_start + j;
+      tp.channel = 10 * i + j;
+      ta.inputs.push_back(tp);
+    }
+    set.objects.push_back(ta);
+  }
+  return set;
+}
+
+TCSet
+make_tcset(size_t n_tcs)
+{
+  TCSet set;
+  set.seqno = 7;
+  set.type = TCSet::Type::kPayload;
+  set.start_time = 5000;
+  set.end_time = 6000;
+  for (size_t i = 0; i < n_tcs; ++i) {
+    TriggerCandidate tc;
+    tc.time_start = 5000 + i;
+    tc.time_candidate = 5001 + i;
+    for (size_t j = 0; j < i + 1; ++j) {
+      detdataformats::trigger::TriggerActivityData ta;
+      ta.time_start = 5000 + i + j;
+      ta.channel_peak = j;
+      tc.inputs.push_back(ta);
+    }
+    set.objects.push_back(tc);
+  }
+  return set;
+}
+
+// An 8-byte aligned buffer holding the overlay of `set`
+template<class T>
+std::vector<uint64_t> // NOLINT(build/unsigned)
+write(const trigger::Set<T>& set, size_t& nbytes)
+{
+  nbytes = trigger::get_set_overlay_nbytes(set);
+  std::vector<uint64_t> buffer((nbytes + 7) / 8); // NOLINT(build/unsigned)
+  trigger::write_set_overlay(set, buffer.data());
+  return buffer;
+}
+
+template<class T>
+void
+check_set_header(const trigger::Set<T>& a, const trigger::Set<T>& b)
+{
+  BOOST_CHECK_EQUAL(a.seqno, b.seqno);
+  BOOST_CHECK(a.origin == b.origin);
+  BOOST_CHECK_EQUAL(a.type, b.type);
+  BOOST_CHECK_EQUAL(a.start_time, b.start_time);
+  BOOST_CHECK_EQUAL(a.end_time, b.end_time);
+  BOOST_CHECK_EQUAL(a.objects.size(), b.objects.size());
+}
+
+void
+check_tasets_equal(const TASet& a, const TASet& b)
+{
+  check_set_header(a, b);
+  for (size_t i = 0; i < std::min(a.objects.size(), b.objects.size()); ++i) {
+    BOOST_CHECK_EQUAL(a.objects[i].time_start, b.objects[i].time_start);
+    BOOST_CHECK_EQUAL(a.objects[i].time_end, b.objects[i].time_end);
+    BOOST_CHECK_EQUAL(a.objects[i].channel_start, b.objects[i].channel_start);
+    BOOST_CHECK_EQUAL(a.objects[i].adc_integral, b.objects[i].adc_integral);
+    BOOST_REQUIRE_EQUAL(a.objects[i].inputs.size(), b.objects[i].inputs.size());
+    for (size_t j = 0; j < a.objects[i].inputs.size(); ++j) {
+      BOOST_CHECK_EQUAL(a.objects[i].inputs[j].time_start, b.objects[i].inputs[j].time_start);
+      BOOST_CHECK_EQUAL(a.objects[i].inputs[j].channel, b.objects[i].inputs[j].channel);
+    }
+  }
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TASetInPlace)
+{
+  TASet set = make_taset(5);
+  size_t nbytes = 0;
+  auto buffer = write(set, nbytes);
+
+  SetOverlayView<TriggerActivity> view(buffer.data(), nbytes);
+  BOOST_CHECK_EQUAL(view.seqno(), set.seqno);
+  BOOST_CHECK(view.origin() == set.origin);
+  BOOST_CHECK_EQUAL(view.type(), set.type);
+  BOOST_CHECK_EQUAL(view.start_time(), set.start_time);
+  BOOST_CHECK_EQUAL(view.end_time(), set.end_time);
+  BOOST_REQUIRE_EQUAL(view.size(), set.objects.size());
+
+  // Each TA and its TPs can be read straight from the buffer
+  size_t i = 0;
+  for (auto const& ta : view) {
+    BOOST_CHECK_EQUAL(ta.data.time_start, set.objects[i].time_start);
+    BOOST_CHECK_EQUAL(ta.data.adc_integral, set.objects[i].adc_integral);
+    BOOST_REQUIRE_EQUAL(ta.n_inputs, set.objects[i].inputs.size());
+    for (size_t j = 0; j < ta.n_inputs; ++j) {
+      BOOST_CHECK_EQUAL(ta.inputs[j].channel, set.objects[i].inputs[j].channel);
+    }
+    ++i;
+  }
+  BOOST_CHECK_EQUAL(i, set.objects.size());
+  BOOST_CHECK_EQUAL(view.end() - view.begin(), set.objects.size());
+
+  check_tasets_equal(view.read(), set);
+}
+
+BOOST_AUTO_TEST_CASE(TCSetInPlace)
+{
+  TCSet set = make_tcset(4);
+  size_t nbytes = 0;
+  auto buffer = write(set, nbytes);
+
+  SetOverlayView<TriggerCandidate> view(buffer.data(), nbytes);
+  BOOST_REQUIRE_EQUAL(view.size(), set.objects.size());
+  for (size_t i = 0; i < view.size(); ++i) {
+    BOOST_CHECK_EQUAL(view[i].data.time_candidate, set.objects[i].time_candidate);
+    BOOST_REQUIRE_EQUAL(view[i].n_inputs, set.objects[i].inputs.size());
+    for (size_t j = 0; j < view[i].n_inputs; ++j) {
+      BOOST_CHECK_EQUAL(view[i].inputs[j].time_start, set.objects[i].inputs[j].time_start);
+      BOOST_CHECK_EQUAL(view[i].inputs[j].channel_peak, set.objects[i].inputs[j].channel_peak);
+    }
+  }
+
+  TCSet read = view.read();
+  check_set_header(read, set);
+  for (size_t i = 0; i < set.objects.size(); ++i) {
+    BOOST_CHECK_EQUAL(read.objects[i].time_start, set.objects[i].time_start);
+    BOOST_CHECK_EQUAL(read.objects[i].inputs.size(), set.objects[i].inputs.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EmptySet)
+{
+  TASet set = make_taset(0);
+  size_t nbytes = 0;
+  auto buffer = write(set, nbytes);
+  BOOST_CHECK_EQUAL(nbytes, sizeof(trigger::SetOverlayHeader));
+
+  SetOverlayView<TriggerActivity> view(buffer.data(), nbytes);
+  BOOST_CHECK(view.empty());
+  BOOST_CHECK(view.begin() == view.end());
+  check_tasets_equal(view.read(), set);
+}
+
+BOOST_AUTO_TEST_CASE(Unaligned)
+{
+  TASet set = make_taset(3);
+  size_t nbytes = 0;
+  auto buffer = write(set, nbytes);
+
+  // As the overlay would be inside a received message
+  std::vector<char> message(nbytes + 1);
+  std::memcpy(message.data() + 1, buffer.data(), nbytes);
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(message.data() + 1, nbytes), trigger::BadSetOverlay);
+  check_tasets_equal(trigger::read_set_overlay<TriggerActivity>(message.data() + 1, nbytes), set);
+}
+
+BOOST_AUTO_TEST_CASE(BadBuffers)
+{
+  TASet set = make_taset(3);
+  size_t nbytes = 0;
+  auto buffer = write(set, nbytes);
+
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(buffer.data(), nbytes - 8), trigger::BadSetOverlay);
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(buffer.data(), 8), trigger::BadSetOverlay);
+
+  auto bad = buffer;
+  reinterpret_cast<trigger::SetOverlayHeader*>(bad.data())->magic = 0; // NOLINT
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(bad.data(), nbytes), trigger::BadSetOverlay);
+
+  // The last object's offset points past the end of the buffer
+  bad = buffer;
+  bad[sizeof(trigger::SetOverlayHeader) / 8 + 2] = nbytes;
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(bad.data(), nbytes), trigger::BadSetOverlay);
+
+  // ...so far past that the object's end wraps around into the buffer
+  bad[sizeof(trigger::SetOverlayHeader) / 8 + 2] = -uint64_t(8); // NOLINT(build/unsigned)
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(bad.data(), nbytes), trigger::BadSetOverlay);
+
+  // ...or into the header
+  bad[sizeof(trigger::SetOverlayHeader) / 8 + 2] = 0;
+  BOOST_CHECK_THROW(SetOverlayView<TriggerActivity>(bad.data(), nbytes), trigger::BadSetOverlay);
+}
+
+BOOST_AUTO_TEST_CASE(Serialization)
+{
+  TASet set = make_taset(4);
+  auto bytes = serialization::serialize(set, serialization::kMsgPack);
+  check_tasets_equal(serialization::deserialize<TASet>(bytes), set);
+
+  TCSet tcset = make_tcset(2);
+  auto tc_bytes = serialization::serialize(tcset, serialization::kMsgPack);
+  check_set_header(serialization::deserialize<TCSet>(tc_bytes), tcset);
+}
+
+BOOST_AUTO_TEST_CASE(PerFieldEncoding)
+{
+  // Sets packed field by field, as before the overlay, can still be read
+  TASet set = make_taset(3);
+  msgpack::sbuffer buffer;
+  msgpack::packer<msgpack::sbuffer> packer(buffer);
+  packer.pack_array(6);
+  packer.pack(set.seqno);
+  packer.pack(set.origin);
+  packer.pack(set.type);
+  packer.pack(set.start_time);
+  packer.pack(set.end_time);
+  packer.pack(set.objects);
+
+  auto handle = msgpack::unpack(buffer.data(), buffer.size());
+  check_tasets_equal(handle.get().as<TASet>(), set);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
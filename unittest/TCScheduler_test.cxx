@@ -0,0 +1,207 @@
+/**
+ * @file TCScheduler_test.cxx  TCScheduler class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCScheduler.hpp"
+
+#include "triggeralgs/TriggerCandidate.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TCScheduler_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+using namespace dunedaq;
+using namespace std::chrono_literals;
+
+using trigger::TCScheduler;
+using tc_type_t = triggeralgs::TriggerCandidate::Type;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+triggeralgs::TriggerCandidate
+make_tc(tc_type_t type, triggeralgs::timestamp_t time)
+{
+  triggeralgs::TriggerCandidate tc;
+  tc.type = type;
+  tc.time_candidate = time;
+  tc.time_start = time;
+  tc.time_end = time;
+  return tc;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(PriorityOrder)
+{
+  std::map<tc_type_t, TCScheduler::TypeConfig> configs;
+  configs[tc_type_t::kSupernova].priority = 10;
+  configs[tc_type_t::kRandom].priority = -1;
+
+  TCScheduler scheduler;
+  scheduler.configure(configs, 10, 0ms);
+
+  auto now = TCScheduler::clock_t::now();
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kRandom, 1), now));
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kTiming, 2), now));
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kSupernova, 3), now));
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kTiming, 4), now));
+  BOOST_CHECK_EQUAL(scheduler.get_n_pending(), 4);
+
+  // Highest priority first, then FIFO within a priority level
+  std::vector<triggeralgs::timestamp_t> expected{ 3, 2, 4, 1 };
+  for (auto time : expected) {
+    triggeralgs::TriggerCandidate tc;
+    BOOST_REQUIRE(scheduler.next(tc, now));
+    BOOST_CHECK_EQUAL(tc.time_candidate, time);
+  }
+  triggeralgs::TriggerCandidate tc;
+  BOOST_CHECK(!scheduler.next(tc, now));
+  BOOST_CHECK_EQUAL(scheduler.get_n_pending(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Prescale)
+{
+  std::map<tc_type_t, TCScheduler::TypeConfig> configs;
+  configs[tc_type_t::kTiming].prescale = 3;
+
+  TCScheduler scheduler;
+  scheduler.configure(configs, 100, 0ms);
+
+  auto now = TCScheduler::clock_t::now();
+  size_t n_added = 0;
+  for (int i = 0; i < 9; ++i) {
+    n_added += scheduler.add(make_tc(tc_type_t::kTiming, i), now);
+  }
+  BOOST_CHECK_EQUAL(n_added, 3);
+  BOOST_CHECK_EQUAL(scheduler.get_counters()[tc_type_t::kTiming].dropped, 6);
+}
+
+BOOST_AUTO_TEST_CASE(RateLimit)
+{
+  std::map<tc_type_t, TCScheduler::TypeConfig> configs;
+  configs[tc_type_t::kRandom].rate_limit_hz = 10;
+  configs[tc_type_t::kRandom].burst = 2;
+
+  TCScheduler scheduler;
+  scheduler.configure(configs, 100, 0ms);
+
+  auto now = TCScheduler::clock_t::now();
+  // The bucket starts full, so the first `burst` candidates get through...
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kRandom, 1), now));
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kRandom, 2), now));
+  BOOST_CHECK(!scheduler.add(make_tc(tc_type_t::kRandom, 3), now));
+
+  // ...and then one more every 100ms
+  BOOST_CHECK(!scheduler.add(make_tc(tc_type_t::kRandom, 4), now + 50ms));
+  BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kRandom, 5), now + 150ms));
+  BOOST_CHECK(!scheduler.add(make_tc(tc_type_t::kRandom, 6), now + 160ms));
+
+  // Other types are unaffected
+  for (int i = 0; i < 10; ++i) {
+    BOOST_CHECK(scheduler.add(make_tc(tc_type_t::kTiming, i), now));
+  }
+
+  BOOST_CHECK_EQUAL(scheduler.get_counters()[tc_type_t::kRandom].dropped, 3);
+}
+
+BOOST_AUTO_TEST_CASE(ShedLowestPriority)
+{
+  std::map<tc_type_t, TCScheduler::TypeConfig> configs;
+  configs[tc_type_t::kSupernova].priority = 10;
+
+  TCScheduler scheduler;
+  scheduler.configure(configs, 2, 0ms);
+
+  auto now = TCScheduler::clock_t::now();
+  scheduler.add(make_tc(tc_type_t::kTiming, 1), now);
+  scheduler.add(make_tc(tc_type_t::kSupernova, 2), now);
+  scheduler.add(make_tc(tc_type_t::kTiming, 3), now);
+  scheduler.add(make_tc(tc_type_t::kSupernova, 4), now);
+
+  std::vector<triggeralgs::timestamp_t> shed_times;
+  size_t n_shed =
+    scheduler.shed_to_limit(now, [&](const triggeralgs::TriggerCandidate& tc) { shed_times.push_back(tc.time_candidate); });
+
+  BOOST_CHECK_EQUAL(n_shed, 2);
+  BOOST_CHECK_EQUAL(scheduler.get_n_pending(), 2);
+  BOOST_REQUIRE_EQUAL(shed_times.size(), 2);
+  BOOST_CHECK_EQUAL(shed_times[0], 1);
+  BOOST_CHECK_EQUAL(shed_times[1], 3);
+
+  auto counters = scheduler.get_counters();
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kTiming].dropped, 2);
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kSupernova].dropped, 0);
+}
+
+BOOST_AUTO_TEST_CASE(PendingTimeout)
+{
+  TCScheduler scheduler;
+  scheduler.configure({}, 10, 100ms);
+
+  auto now = TCScheduler::clock_t::now();
+  scheduler.add(make_tc(tc_type_t::kTiming, 1), now);
+  scheduler.add(make_tc(tc_type_t::kTiming, 2), now + 80ms);
+
+  // The first candidate has been held too long, so it is shed even though
+  // we're under the depth limit
+  BOOST_CHECK_EQUAL(scheduler.shed_to_limit(now + 150ms), 1);
+
+  triggeralgs::TriggerCandidate tc;
+  BOOST_REQUIRE(scheduler.next(tc, now + 150ms));
+  BOOST_CHECK_EQUAL(tc.time_candidate, 2);
+  scheduler.accepted(tc.type);
+
+  auto counters = scheduler.get_counters();
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kTiming].accepted, 1);
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kTiming].dropped, 1);
+}
+
+BOOST_AUTO_TEST_CASE(ExpiredAtNextIsShed)
+{
+  TCScheduler scheduler;
+  scheduler.configure({}, 10, 100ms);
+
+  auto now = TCScheduler::clock_t::now();
+  scheduler.add(make_tc(tc_type_t::kTiming, 1), now);
+  scheduler.add(make_tc(tc_type_t::kTiming, 2), now + 80ms);
+
+  // The first candidate timed out while pending, so next() sheds it, with
+  // the same callback and accounting as shed(), and returns the second
+  std::vector<triggeralgs::timestamp_t> shed_times;
+  triggeralgs::TriggerCandidate tc;
+  BOOST_REQUIRE(scheduler.next(
+    tc, now + 150ms, [&](const triggeralgs::TriggerCandidate& shed_tc) { shed_times.push_back(shed_tc.time_candidate); }));
+  BOOST_CHECK_EQUAL(tc.time_candidate, 2);
+  BOOST_REQUIRE_EQUAL(shed_times.size(), 1);
+  BOOST_CHECK_EQUAL(shed_times[0], 1);
+  BOOST_CHECK_EQUAL(scheduler.get_counters()[tc_type_t::kTiming].dropped, 1);
+}
+
+BOOST_AUTO_TEST_CASE(MergedCounter)
+{
+  TCScheduler scheduler;
+  scheduler.configure({}, 10, 0ms);
+
+  scheduler.add(make_tc(tc_type_t::kTiming, 1));
+  triggeralgs::TriggerCandidate tc;
+  BOOST_REQUIRE(scheduler.next(tc));
+  scheduler.merged(tc.type);
+
+  auto counters = scheduler.get_counters();
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kTiming].merged, 1);
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kTiming].accepted, 0);
+  BOOST_CHECK_EQUAL(counters[tc_type_t::kTiming].dropped, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+/**
+ * @file TPFile_test.cxx  Binary TP file Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/Issues.hpp"
+#include "trigger/TPFile.hpp"
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPFile_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::TPFileReader;
+using triggeralgs::TriggerPrimitive;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+std::string
+temp_filename(const std::string& name)
+{
+  return "/tmp/TPFile_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+std::vector<TriggerPrimitive>
+make_tps(const std::vector<triggeralgs::timestamp_t>& times)
+{
+  std::vector<TriggerPrimitive> tps;
+  for (auto time : times) {
+    TriggerPrimitive tp;
+    tp.time_start = time;
+    tp.time_peak = time + 1;
+    tp.channel = time % 7;
+    tps.push_back(tp);
+  }
+  return tps;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ReadText)
+{
+  std::istringstream text("100 10 105 42 500 30 1 1\n200 20 210 43 600 40 1 1\n300 bad");
+  TriggerPrimitive tp;
+  BOOST_REQUIRE(trigger::read_tp_text(text, tp));
+  BOOST_CHECK_EQUAL(tp.time_start, 100);
+  BOOST_CHECK_EQUAL(tp.time_over_threshold, 10);
+  BOOST_CHECK_EQUAL(tp.time_peak, 105);
+  BOOST_CHECK_EQUAL(tp.channel, 42);
+  BOOST_CHECK_EQUAL(tp.adc_integral, 500);
+  BOOST_CHECK_EQUAL(tp.adc_peak, 30);
+  BOOST_REQUIRE(trigger::read_tp_text(text, tp));
+  BOOST_CHECK_EQUAL(tp.time_start, 200);
+  BOOST_CHECK(!trigger::read_tp_text(text, tp));
+}
+
+BOOST_AUTO_TEST_CASE(WriteAndRead)
+{
+  auto filename = temp_filename("write_and_read");
+  auto tps = make_tps({ 1000, 1005, 1005, 1250, 1900, 4000 });
+  trigger::write_tp_file(filename, tps);
+
+  BOOST_CHECK(TPFileReader::is_tp_file(filename));
+  {
+    TPFileReader reader(filename);
+    BOOST_REQUIRE_EQUAL(reader.size(), tps.size());
+    for (size_t i = 0; i < tps.size(); ++i) {
+      BOOST_CHECK_EQUAL(reader.begin()[i].time_start, tps[i].time_start);
+      BOOST_CHECK_EQUAL(reader.begin()[i].time_peak, tps[i].time_peak);
+      BOOST_CHECK_EQUAL(reader.begin()[i].channel, tps[i].channel);
+    }
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(EmptyFile)
+{
+  auto filename = temp_filename("empty");
+  trigger::write_tp_file(filename, {});
+  {
+    TPFileReader reader(filename);
+    BOOST_CHECK(reader.empty());
+    BOOST_CHECK(reader.begin() == reader.end());
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BadFiles)
+{
+  // Unsorted TPs can't be written
+  auto filename = temp_filename("bad");
+  BOOST_CHECK_THROW(trigger::write_tp_file(filename, make_tps({ 10, 5 })), trigger::BadTPFile);
+
+  // A text file isn't a binary TP file
+  {
+    std::ofstream text(filename);
+    text << "100 10 105 42 500 30 1 1\n200 20 210 43 600 40 1 1\n300 30 310 44 700 50 1 1\n";
+  }
+  BOOST_CHECK(!TPFileReader::is_tp_file(filename));
+  BOOST_CHECK_THROW(TPFileReader reader(filename), trigger::BadTPFile);
+
+  // A truncated file is caught before any TPs are read
+  trigger::write_tp_file(filename, make_tps({ 1, 2, 3 }));
+  BOOST_REQUIRE_EQUAL(truncate(filename.c_str(), sizeof(trigger::TPFileHeader) + sizeof(TriggerPrimitive)), 0);
+  BOOST_CHECK_THROW(TPFileReader reader(filename), trigger::BadTPFile);
+
+  // So is a TP count whose size in bytes doesn't fit in 64 bits
+  trigger::write_tp_file(filename, make_tps({ 1, 2, 3 }));
+  {
+    trigger::TPFileHeader header;
+    header.tp_size = sizeof(TriggerPrimitive);
+    header.n_tps = std::numeric_limits<uint64_t>::max() / sizeof(TriggerPrimitive) + 1; // NOLINT(build/unsigned)
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+  }
+  BOOST_CHECK_THROW(TPFileReader reader(filename), trigger::BadTPFile);
+
+  std::remove(filename.c_str());
+  BOOST_CHECK_THROW(TPFileReader reader(filename), trigger::BadTPFile);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,208 @@
+/**
+ * @file TPGenerator_test.cxx  TPGenerator class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPGenerator.hpp"
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPGenerator_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::TPGenerator;
+using triggeralgs::timestamp_t;
+using triggeralgs::TriggerPrimitive;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+// One second at the default clock
+constexpr timestamp_t one_second = 50000000;
+
+std::vector<TriggerPrimitive>
+generate(const TPGenerator::Config& config, timestamp_t start, timestamp_t end, timestamp_t window)
+{
+  TPGenerator generator;
+  generator.configure(config, start);
+  std::vector<TriggerPrimitive> tps;
+  for (timestamp_t t = start + window; t <= end; t += window) {
+    size_t n_before = tps.size();
+    generator.generate(t, tps);
+    for (size_t i = n_before; i < tps.size(); ++i) {
+      BOOST_REQUIRE_GE(tps[i].time_start, t - window);
+      BOOST_REQUIRE_LT(tps[i].time_start, t);
+    }
+  }
+  return tps;
+}
+
+bool
+is_sorted(const std::vector<TriggerPrimitive>& tps)
+{
+  return std::is_sorted(tps.begin(), tps.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return a.time_start < b.time_start;
+  });
+}
+
+void
+sort_fully(std::vector<TriggerPrimitive>& tps)
+{
+  std::sort(tps.begin(), tps.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return std::tie(a.time_start, a.channel, a.adc_peak) < std::tie(b.time_start, b.channel, b.adc_peak);
+  });
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(NoiseRate)
+{
+  TPGenerator::Config config;
+  config.first_channel = 1000;
+  config.n_channels = 500;
+  config.noise_rate_hz = 1000;
+
+  auto tps = generate(config, 0, one_second, one_second / 100);
+
+  // 500 kHz for a second, so the Poisson fluctuation is about 0.14%
+  BOOST_CHECK_CLOSE(static_cast<double>(tps.size()), 500000., 1.);
+  BOOST_CHECK(is_sorted(tps));
+  for (auto const& tp : tps) {
+    BOOST_REQUIRE_GE(tp.channel, 1000);
+    BOOST_REQUIRE_LT(tp.channel, 1500);
+  }
+
+  TPGenerator generator;
+  generator.configure(config, 0);
+  BOOST_CHECK_CLOSE(generator.get_expected_n_tps(one_second), 500000., 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(Reproducible)
+{
+  TPGenerator::Config config;
+  config.n_channels = 100;
+  config.noise_rate_hz = 1000;
+  config.track_rate_hz = 50;
+  config.track_length_channels = 20;
+  config.burst_rate_hz = 10;
+  config.burst_n_tps = 100;
+  config.burst_n_channels = 10;
+  config.burst_duration = one_second / 10;
+  config.seed = 12;
+
+  // The same TPs, however the time is split into windows
+  auto a = generate(config, 1000, 1000 + one_second, one_second / 10);
+  auto b = generate(config, 1000, 1000 + one_second, one_second / 1000);
+  BOOST_CHECK(is_sorted(a));
+  BOOST_CHECK(is_sorted(b));
+  sort_fully(a);
+  sort_fully(b);
+  BOOST_REQUIRE_EQUAL(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(a[i].time_start, b[i].time_start);
+    BOOST_REQUIRE_EQUAL(a[i].channel, b[i].channel);
+    BOOST_REQUIRE_EQUAL(a[i].adc_peak, b[i].adc_peak);
+  }
+
+  // ...but different TPs with a different seed
+  config.seed = 13;
+  auto c = generate(config, 1000, 1000 + one_second, one_second / 10);
+  BOOST_CHECK(c.size() != a.size() || c.front().time_start != a.front().time_start);
+}
+
+BOOST_AUTO_TEST_CASE(Tracks)
+{
+  TPGenerator::Config config;
+  config.n_channels = 1000;
+  config.noise_rate_hz = 0;
+  config.track_rate_hz = 20;
+  config.track_length_channels = 50;
+  config.track_max_ticks_per_channel = 10;
+
+  auto tps = generate(config, 0, one_second, one_second / 50);
+  BOOST_REQUIRE(!tps.empty());
+  BOOST_CHECK(is_sorted(tps));
+
+  // Tracks are whole, apart from any that started too close to the end
+  size_t n_tracks = tps.size() / 50;
+  BOOST_CHECK_GE(n_tracks, 5);
+  BOOST_CHECK_LE(n_tracks, 40);
+  for (auto const& tp : tps) {
+    BOOST_CHECK_GE(tp.adc_peak, 100);
+  }
+
+  // The first track's TPs are on 50 consecutive channels
+  TPGenerator generator;
+  generator.configure(config, 0);
+  std::vector<TriggerPrimitive> first;
+  for (timestamp_t t = one_second / 50; first.size() < 50 && t <= 10 * one_second; t += one_second / 50) {
+    generator.generate(t, first);
+  }
+  BOOST_REQUIRE_GE(first.size(), 50);
+  first.resize(50);
+  std::sort(first.begin(), first.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return a.channel < b.channel;
+  });
+  for (size_t i = 1; i < first.size(); ++i) {
+    BOOST_CHECK_EQUAL(first[i].channel, first[0].channel + i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Bursts)
+{
+  TPGenerator::Config config;
+  config.first_channel = 5000;
+  config.n_channels = 1000;
+  config.noise_rate_hz = 0;
+  config.burst_rate_hz = 1;
+  config.burst_n_tps = 2000;
+  config.burst_n_channels = 100;
+  config.burst_duration = one_second / 100;
+
+  // Long enough that we're sure to get some bursts, and that the last one is over
+  TPGenerator generator;
+  generator.configure(config, 0);
+  std::vector<TriggerPrimitive> tps;
+  generator.generate(20 * one_second, tps);
+
+  BOOST_REQUIRE(!tps.empty());
+  BOOST_CHECK(is_sorted(tps));
+  for (auto const& tp : tps) {
+    BOOST_REQUIRE_GE(tp.channel, 5000);
+    BOOST_REQUIRE_LT(tp.channel, 6000);
+    // Burst TPs are low-ADC
+    BOOST_REQUIRE_LT(tp.adc_peak, 52);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LargeTimestamps)
+{
+  TPGenerator::Config config;
+  config.n_channels = 100;
+  config.noise_rate_hz = 10000;
+
+  // Far beyond where doubles can hold a timestamp to the tick, the TPs are
+  // the same as from a small start time, just shifted
+  timestamp_t large_start = (timestamp_t(1) << 62) + 12345;
+  auto small = generate(config, 1000, 1000 + one_second / 10, one_second / 100);
+  auto large = generate(config, large_start, large_start + one_second / 10, one_second / 100);
+  BOOST_REQUIRE(!small.empty());
+  BOOST_REQUIRE_EQUAL(small.size(), large.size());
+  for (size_t i = 0; i < small.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(large[i].time_start - large_start, small[i].time_start - 1000);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+/**
+ * @file TPSliceColumns_test.cxx  TPSliceColumns and TimeSliceInputBuffer column filling Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPSliceColumns.hpp"
+#include "trigger/TimeSliceInputBuffer.hpp"
+
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPSliceColumns_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+bool
+is_aligned(const void* p)
+{
+  return reinterpret_cast<std::uintptr_t>(p) % trigger::TPSliceColumns::s_alignment == 0;
+}
+
+triggeralgs::TriggerPrimitive
+make_tp(triggeralgs::timestamp_t time_start, uint32_t channel) // NOLINT(build/unsigned)
+{
+  triggeralgs::TriggerPrimitive tp;
+  tp.time_start = time_start;
+  tp.time_peak = time_start + 1;
+  tp.time_over_threshold = 2;
+  tp.channel = channel;
+  tp.adc_integral = channel * 10;
+  tp.adc_peak = 3;
+  return tp;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(AssignAndReuse)
+{
+  std::vector<triggeralgs::TriggerPrimitive> tps;
+  for (uint32_t i = 0; i < 100; ++i) { // NOLINT(build/unsigned)
+    tps.push_back(make_tp(1000 + i, i));
+  }
+
+  trigger::TPSliceColumns columns;
+  columns.assign(tps.data(), tps.data() + tps.size());
+  BOOST_REQUIRE_EQUAL(columns.size(), tps.size());
+  BOOST_CHECK(is_aligned(columns.time_start()));
+  BOOST_CHECK(is_aligned(columns.channel()));
+  BOOST_CHECK(is_aligned(columns.adc_integral()));
+  BOOST_CHECK(is_aligned(columns.adc_peak()));
+  for (size_t i = 0; i < tps.size(); ++i) {
+    BOOST_CHECK_EQUAL(columns.time_start()[i], tps[i].time_start);
+    BOOST_CHECK_EQUAL(columns.time_peak()[i], tps[i].time_peak);
+    BOOST_CHECK_EQUAL(columns.channel()[i], tps[i].channel);
+    BOOST_CHECK_EQUAL(columns.adc_integral()[i], tps[i].adc_integral);
+  }
+
+  // A smaller slice reuses the same storage
+  const auto* time_start = columns.time_start();
+  columns.clear();
+  BOOST_CHECK(columns.empty());
+  columns.assign(tps.data(), tps.data() + 10);
+  BOOST_CHECK_EQUAL(columns.size(), 10);
+  BOOST_CHECK_EQUAL(columns.time_start(), time_start);
+}
+
+BOOST_AUTO_TEST_CASE(FilledByFlush)
+{
+  const std::string name = "test", algorithm = "none";
+  trigger::TimeSliceInputBuffer<triggeralgs::TriggerPrimitive> buffer(name, algorithm);
+
+  // Two sets covering the same time slice, each time ordered, but interleaved
+  trigger::Set<triggeralgs::TriggerPrimitive> a, b;
+  a.start_time = b.start_time = 1000;
+  a.end_time = b.end_time = 2000;
+  a.objects = { make_tp(1000, 1), make_tp(1020, 2), make_tp(1040, 3) };
+  b.objects = { make_tp(1010, 4), make_tp(1030, 5) };
+
+  std::vector<triggeralgs::TriggerPrimitive> time_slice;
+  trigger::TPSliceColumns columns;
+  daqdataformats::timestamp_t start_time, end_time;
+  BOOST_CHECK(!buffer.buffer(a, time_slice, start_time, end_time, &columns));
+  BOOST_CHECK(!buffer.buffer(b, time_slice, start_time, end_time, &columns));
+  BOOST_CHECK(buffer.flush(time_slice, start_time, end_time, &columns));
+
+  BOOST_REQUIRE_EQUAL(time_slice.size(), 5);
+  BOOST_REQUIRE_EQUAL(columns.size(), 5);
+  std::vector<uint32_t> expected_channels{ 1, 4, 2, 5, 3 }; // NOLINT(build/unsigned)
+  for (size_t i = 0; i < time_slice.size(); ++i) {
+    BOOST_CHECK_EQUAL(columns.time_start()[i], time_slice[i].time_start);
+    BOOST_CHECK_EQUAL(columns.channel()[i], expected_channels[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SelectedFields)
+{
+  std::vector<triggeralgs::TriggerPrimitive> tps;
+  for (uint32_t i = 0; i < 10; ++i) { // NOLINT(build/unsigned)
+    tps.push_back(make_tp(1000 + i, i));
+  }
+
+  // Only the selected columns are filled
+  trigger::TPSliceColumns columns(trigger::TPSliceColumns::kTimeStart | trigger::TPSliceColumns::kChannel);
+  columns.assign(tps.data(), tps.data() + tps.size());
+  BOOST_CHECK_EQUAL(columns.size(), tps.size());
+  BOOST_CHECK_EQUAL(columns.time_start()[9], 1009);
+  BOOST_CHECK_EQUAL(columns.channel()[9], 9);
+}
+
+BOOST_AUTO_TEST_CASE(MergedByFlush)
+{
+  const std::string name = "test", algorithm = "none";
+  trigger::TimeSliceInputBuffer<triggeralgs::TriggerPrimitive> buffer(name, algorithm);
+
+  // Several time ordered sets for the same slice, and one that isn't ordered
+  std::vector<triggeralgs::TriggerPrimitive> all;
+  daqdataformats::timestamp_t start_time, end_time;
+  std::vector<triggeralgs::TriggerPrimitive> time_slice;
+  trigger::TPSliceColumns columns(trigger::TPSliceColumns::kTimeStart | trigger::TPSliceColumns::kChannel);
+  for (uint32_t set = 0; set < 5; ++set) { // NOLINT(build/unsigned)
+    trigger::Set<triggeralgs::TriggerPrimitive> x;
+    x.start_time = 1000;
+    x.end_time = 2000;
+    for (uint32_t i = 0; i < 20; ++i) { // NOLINT(build/unsigned)
+      x.objects.push_back(make_tp(1000 + (i * 7 + set * 3) % 40 + (set == 4 ? 0 : i * 40), set * 100 + i));
+    }
+    if (set != 4) {
+      std::sort(x.objects.begin(), x.objects.end(), [](auto& a, auto& b) { return a.time_start < b.time_start; });
+    }
+    all.insert(all.end(), x.objects.begin(), x.objects.end());
+    BOOST_CHECK(!buffer.buffer(x, time_slice, start_time, end_time, &columns));
+  }
+  BOOST_CHECK(buffer.flush(time_slice, start_time, end_time, &columns));
+
+  BOOST_REQUIRE_EQUAL(time_slice.size(), all.size());
+  BOOST_REQUIRE_EQUAL(columns.size(), all.size());
+  BOOST_CHECK(std::is_sorted(
+    time_slice.begin(), time_slice.end(), [](auto& a, auto& b) { return a.time_start < b.time_start; }));
+  std::multiset<uint32_t> expected_channels, channels; // NOLINT(build/unsigned)
+  for (size_t i = 0; i < time_slice.size(); ++i) {
+    expected_channels.insert(all[i].channel);
+    channels.insert(time_slice[i].channel);
+    BOOST_CHECK_EQUAL(columns.time_start()[i], time_slice[i].time_start);
+    BOOST_CHECK_EQUAL(columns.channel()[i], time_slice[i].channel);
+  }
+  BOOST_CHECK(channels == expected_channels);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,262 @@
+/**
+ * @file TapFile_test.cxx  Tap file Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/Issues.hpp"
+#include "trigger/TapFile.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TapFile_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::TapFileReader;
+using trigger::TapFileWriter;
+using trigger::TapRecordHeader;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+std::string
+temp_prefix(const std::string& name)
+{
+  return "/tmp/TapFile_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+// A record whose contents depend on its start time, so we can check we read back the right one
+std::string
+payload(triggeralgs::timestamp_t time)
+{
+  return "record " + std::to_string(time) + std::string(time % 5, 'x');
+}
+
+void
+write_records(TapFileWriter& writer, const std::vector<triggeralgs::timestamp_t>& times)
+{
+  for (auto time : times) {
+    auto data = payload(time);
+    writer.write(time, time + 10, data.data(), data.size());
+  }
+}
+
+std::vector<triggeralgs::timestamp_t>
+read_times(TapFileReader& reader)
+{
+  std::vector<triggeralgs::timestamp_t> times;
+  TapRecordHeader header;
+  std::vector<char> data;
+  while (reader.next(header, data)) {
+    BOOST_CHECK_EQUAL(header.end_time, header.start_time + 10);
+    BOOST_CHECK_EQUAL(std::string(data.begin(), data.end()), payload(header.start_time));
+    times.push_back(header.start_time);
+  }
+  return times;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(WriteAndRead)
+{
+  auto prefix = temp_prefix("write_and_read");
+  std::vector<triggeralgs::timestamp_t> times{ 1000, 1005, 1005, 1250, 1900, 4000 };
+  {
+    TapFileWriter writer(prefix, 1 << 20, 0, 100);
+    write_records(writer, times);
+    writer.close();
+    BOOST_CHECK_EQUAL(writer.get_files_written(), 1);
+  }
+
+  auto filename = TapFileWriter::file_name(prefix, 0);
+  {
+    TapFileReader reader(filename);
+    BOOST_CHECK(reader.has_index());
+    BOOST_CHECK(read_times(reader) == times);
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Seek)
+{
+  auto prefix = temp_prefix("seek");
+  std::vector<triggeralgs::timestamp_t> times{ 1000, 1005, 1005, 1250, 1900, 4000 };
+  {
+    TapFileWriter writer(prefix, 1 << 20, 0, 100);
+    write_records(writer, times);
+  }
+
+  auto filename = TapFileWriter::file_name(prefix, 0);
+  {
+    TapFileReader reader(filename);
+    // Each seek lands on the first record of the last indexed stride at or before the time
+    reader.seek(1260);
+    BOOST_CHECK(read_times(reader) == std::vector<triggeralgs::timestamp_t>({ 1250, 1900, 4000 }));
+    reader.seek(3999);
+    BOOST_CHECK(read_times(reader) == std::vector<triggeralgs::timestamp_t>({ 1900, 4000 }));
+    reader.seek(1050);
+    BOOST_CHECK(read_times(reader) == std::vector<triggeralgs::timestamp_t>({ 1000, 1005, 1005, 1250, 1900, 4000 }));
+    reader.seek(0);
+    BOOST_CHECK(read_times(reader) == times);
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RollFiles)
+{
+  auto prefix = temp_prefix("roll");
+  std::vector<triggeralgs::timestamp_t> times;
+  for (triggeralgs::timestamp_t t = 0; t < 100; ++t) {
+    times.push_back(t * 10);
+  }
+  // Room for about ten records per file, and only the newest three files are kept
+  size_t record_bytes = sizeof(TapRecordHeader) + payload(990).size();
+  size_t n_files = 0;
+  {
+    TapFileWriter writer(prefix, sizeof(trigger::TapFileHeader) + 10 * record_bytes, 3, 100);
+    write_records(writer, times);
+    writer.close();
+    n_files = writer.get_files_written();
+  }
+  BOOST_REQUIRE_GT(n_files, 3);
+
+  std::vector<triggeralgs::timestamp_t> read;
+  for (size_t i = 0; i < n_files; ++i) {
+    auto filename = TapFileWriter::file_name(prefix, i);
+    if (i + 3 < n_files) {
+      BOOST_CHECK(!std::ifstream(filename));
+      continue;
+    }
+    {
+      TapFileReader reader(filename);
+      auto file_times = read_times(reader);
+      read.insert(read.end(), file_times.begin(), file_times.end());
+    }
+    std::remove(filename.c_str());
+  }
+  // The records in the kept files are the last ones written, in order
+  BOOST_REQUIRE(!read.empty());
+  BOOST_CHECK(std::equal(read.begin(), read.end(), times.end() - read.size()));
+}
+
+BOOST_AUTO_TEST_CASE(UncleanClose)
+{
+  auto prefix = temp_prefix("unclean");
+  auto filename = TapFileWriter::file_name(prefix, 0);
+  std::vector<triggeralgs::timestamp_t> times{ 10, 20, 30 };
+  {
+    TapFileWriter writer(prefix, 1 << 20, 0, 100);
+    write_records(writer, times);
+  }
+
+  // Cut the footer and index off, and half of the last record, as if the writer had died
+  size_t records_end = sizeof(trigger::TapFileHeader);
+  for (auto time : times) {
+    records_end += sizeof(TapRecordHeader) + payload(time).size();
+  }
+  BOOST_REQUIRE_EQUAL(truncate(filename.c_str(), records_end - 3), 0);
+  {
+    TapFileReader reader(filename);
+    BOOST_CHECK(!reader.has_index());
+    BOOST_CHECK(read_times(reader) == std::vector<triggeralgs::timestamp_t>({ 10, 20 }));
+    // Without an index, seek goes back to the start
+    reader.seek(25);
+    BOOST_CHECK(read_times(reader) == std::vector<triggeralgs::timestamp_t>({ 10, 20 }));
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GarbageSizes)
+{
+  auto prefix = temp_prefix("garbage");
+  auto filename = TapFileWriter::file_name(prefix, 0);
+  std::vector<triggeralgs::timestamp_t> times{ 10, 20, 30 };
+  {
+    TapFileWriter writer(prefix, 1 << 20, 0, 100);
+    write_records(writer, times);
+  }
+
+  // Index and record sizes that would wrap around to fit the file if they were added to an offset
+  {
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    trigger::TapFileFooter footer;
+    file.seekg(-static_cast<int>(sizeof(footer)), std::ios::end);
+    file.read(reinterpret_cast<char*>(&footer), sizeof(footer)); // NOLINT
+    footer.n_index_entries += uint64_t(1) << 60;                   // NOLINT(build/unsigned)
+    file.seekp(-static_cast<int>(sizeof(footer)), std::ios::end);
+    file.write(reinterpret_cast<const char*>(&footer), sizeof(footer)); // NOLINT
+
+    TapRecordHeader header;
+    file.seekg(sizeof(trigger::TapFileHeader));
+    file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+    // The first record's end would wrap around to offset 5
+    header.size = uint64_t(0) - sizeof(trigger::TapFileHeader) - sizeof(header) + 5; // NOLINT(build/unsigned)
+    file.seekp(sizeof(trigger::TapFileHeader));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+  }
+  {
+    TapFileReader reader(filename);
+    BOOST_CHECK(!reader.has_index());
+    BOOST_CHECK(read_times(reader).empty());
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Versions)
+{
+  auto prefix = temp_prefix("versions");
+  auto filename = TapFileWriter::file_name(prefix, 0);
+  std::vector<triggeralgs::timestamp_t> times{ 10, 20, 30 };
+  {
+    TapFileWriter writer(prefix, 1 << 20, 0, 100);
+    write_records(writer, times);
+  }
+
+  auto set_version = [&](uint32_t version) { // NOLINT(build/unsigned)
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    trigger::TapFileHeader header;
+    header.version = version;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+  };
+
+  // Older files are still read, since only the encoding of the records changed
+  set_version(trigger::TapFileHeader::s_min_version);
+  {
+    TapFileReader reader(filename);
+    BOOST_CHECK(read_times(reader) == times);
+  }
+  set_version(trigger::TapFileHeader::s_version + 1);
+  BOOST_CHECK_THROW(TapFileReader reader(filename), trigger::BadTapFile);
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BadFiles)
+{
+  auto filename = temp_prefix("bad.tap");
+  {
+    std::ofstream text(filename);
+    text << "100 10 105 42 500 30 1 1\n200 20 210 43 600 40 1 1\n";
+  }
+  BOOST_CHECK_THROW(TapFileReader reader(filename), trigger::BadTapFile);
+
+  std::remove(filename.c_str());
+  BOOST_CHECK_THROW(TapFileReader reader(filename), trigger::BadTapFile);
+
+  // Nowhere to write to
+  TapFileWriter writer("/nonexistent/dir/tap", 1 << 20, 0, 100);
+  BOOST_CHECK_THROW(write_records(writer, { 1 }), trigger::BadTapFile);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
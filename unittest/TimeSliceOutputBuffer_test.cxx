@@ -0,0 +1,203 @@
+/**
+ * @file TimeSliceOutputBuffer_test.cxx  TimeSliceOutputBuffer class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TimeSliceOutputBuffer.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TimeSliceOutputBuffer_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::AdaptiveBufferTime;
+using trigger::TimeSliceOutputBuffer;
+using triggeralgs::TriggerActivity;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const std::string s_name = "test";
+const std::string s_algorithm = "TestAlgorithm";
+
+TriggerActivity
+make_ta(triggeralgs::timestamp_t time)
+{
+  TriggerActivity ta;
+  ta.time_start = time;
+  ta.time_end = time;
+  return ta;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(FixedBufferTime)
+{
+  TimeSliceOutputBuffer<TriggerActivity> buffer(s_name, s_algorithm, 50, 100);
+
+  // Nothing is ready until the largest time is more than the buffer time past the end of the first window
+  BOOST_CHECK_EQUAL(buffer.buffer({ make_ta(1010), make_ta(1090) }), 0);
+  BOOST_CHECK(!buffer.ready());
+  BOOST_CHECK_EQUAL(buffer.buffer({ make_ta(1150) }), 0);
+  BOOST_CHECK(!buffer.ready());
+  BOOST_CHECK_EQUAL(buffer.buffer({ make_ta(1151) }), 0);
+  BOOST_REQUIRE(buffer.ready());
+
+  std::vector<TriggerActivity> time_slice;
+  daqdataformats::timestamp_t start_time, end_time;
+  buffer.flush(time_slice, start_time, end_time);
+  BOOST_CHECK_EQUAL(start_time, 1000);
+  BOOST_CHECK_EQUAL(end_time, 1100);
+  BOOST_CHECK_EQUAL(time_slice.size(), 2);
+  BOOST_CHECK(!buffer.ready());
+
+  // The first window has gone, so anything in it is too late
+  BOOST_CHECK_EQUAL(buffer.buffer({ make_ta(1050), make_ta(1099), make_ta(1160) }), 2);
+  BOOST_CHECK_EQUAL(buffer.get_buffer_time(), 50);
+}
+
+BOOST_AUTO_TEST_CASE(Advance)
+{
+  TimeSliceOutputBuffer<TriggerActivity> buffer(s_name, s_algorithm, 50, 100);
+
+  buffer.buffer({ make_ta(1010) });
+  BOOST_CHECK(!buffer.ready());
+
+  // A heartbeat completes the window without any later TA arriving
+  buffer.advance(1150);
+  BOOST_CHECK(!buffer.ready());
+  buffer.advance(1151);
+  BOOST_REQUIRE(buffer.ready());
+
+  std::vector<TriggerActivity> time_slice;
+  daqdataformats::timestamp_t start_time, end_time;
+  buffer.flush(time_slice, start_time, end_time);
+  BOOST_CHECK_EQUAL(start_time, 1000);
+  BOOST_CHECK_EQUAL(time_slice.size(), 1);
+  BOOST_CHECK(buffer.empty());
+
+  // Going backwards does nothing
+  buffer.advance(1000);
+  buffer.buffer({ make_ta(1200) });
+  BOOST_CHECK(!buffer.ready());
+}
+
+BOOST_AUTO_TEST_CASE(AdvanceWhenEmpty)
+{
+  TimeSliceOutputBuffer<TriggerActivity> buffer(s_name, s_algorithm, 50, 100);
+
+  buffer.buffer({ make_ta(1010) });
+  buffer.advance(1151);
+  BOOST_REQUIRE(buffer.ready());
+  std::vector<TriggerActivity> time_slice;
+  daqdataformats::timestamp_t start_time, end_time;
+  buffer.flush(time_slice, start_time, end_time);
+  BOOST_CHECK_EQUAL(buffer.get_next_window_start(), 1100);
+
+  // With nothing buffered, heartbeats move the next window on, so TAs for
+  // windows that were complete before the heartbeat are now too late
+  buffer.advance(5000);
+  BOOST_CHECK_EQUAL(buffer.get_next_window_start(), 4900);
+  BOOST_CHECK_EQUAL(buffer.buffer({ make_ta(4000), make_ta(4899), make_ta(4900) }), 2);
+  BOOST_CHECK_EQUAL(buffer.get_next_window_start(), 4900);
+}
+
+BOOST_AUTO_TEST_CASE(ChangeWindowTime)
+{
+  TimeSliceOutputBuffer<TriggerActivity> buffer(s_name, s_algorithm, 0, 100);
+
+  buffer.buffer({ make_ta(1010), make_ta(1120), make_ta(1150) });
+  buffer.advance(1101);
+  BOOST_REQUIRE(buffer.ready());
+  std::vector<TriggerActivity> time_slice;
+  daqdataformats::timestamp_t start_time, end_time;
+  buffer.flush(time_slice, start_time, end_time);
+  BOOST_CHECK_EQUAL(end_time, 1100);
+
+  // Changing the window time with TAs still buffered keeps them. The next
+  // window starts where the last one ended, and ends on the new alignment
+  buffer.set_window_time(40);
+  buffer.advance(1200);
+  BOOST_REQUIRE(buffer.ready());
+  time_slice.clear();
+  buffer.flush(time_slice, start_time, end_time);
+  BOOST_CHECK_EQUAL(start_time, 1100);
+  BOOST_CHECK_EQUAL(end_time, 1120);
+  BOOST_CHECK_EQUAL(time_slice.size(), 1);
+
+  time_slice.clear();
+  buffer.flush(time_slice, start_time, end_time);
+  BOOST_CHECK_EQUAL(start_time, 1120);
+  BOOST_CHECK_EQUAL(end_time, 1160);
+  BOOST_CHECK_EQUAL(time_slice.size(), 1);
+  BOOST_CHECK(buffer.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Adaptive)
+{
+  TimeSliceOutputBuffer<TriggerActivity> buffer(s_name, s_algorithm, 0, 100);
+
+  AdaptiveBufferTime adaptive;
+  adaptive.enabled = true;
+  adaptive.percentile = 0.9;
+  adaptive.margin = 5;
+  adaptive.update_interval = 100;
+  buffer.set_adaptive(adaptive);
+
+  // Every tenth TA is 190 ticks behind the one before it, the others are in
+  // order. The 90th percentile of the lateness is then zero...
+  triggeralgs::timestamp_t time = 100000;
+  for (int i = 0; i < 100; ++i) {
+    time += 10;
+    buffer.buffer({ make_ta(i % 10 == 9 ? time - 200 : time) });
+  }
+  BOOST_CHECK_EQUAL(buffer.get_buffer_time(), 5);
+
+  // ...but if every fifth one is late, it covers them
+  for (int i = 0; i < 100; ++i) {
+    time += 10;
+    buffer.buffer({ make_ta(i % 5 == 4 ? time - 200 : time) });
+  }
+  BOOST_CHECK_EQUAL(buffer.get_buffer_time(), 195);
+}
+
+BOOST_AUTO_TEST_CASE(AdaptiveLimits)
+{
+  TimeSliceOutputBuffer<TriggerActivity> buffer(s_name, s_algorithm, 0, 100);
+
+  AdaptiveBufferTime adaptive;
+  adaptive.enabled = true;
+  adaptive.percentile = 1.0;
+  adaptive.min_buffer_time = 20;
+  adaptive.max_buffer_time = 150;
+  adaptive.update_interval = 10;
+  buffer.set_adaptive(adaptive);
+  // The starting value is brought within the limits straight away
+  BOOST_CHECK_EQUAL(buffer.get_buffer_time(), 20);
+
+  triggeralgs::timestamp_t time = 100000;
+  for (int i = 0; i < 10; ++i) {
+    time += 10;
+    buffer.buffer({ make_ta(i == 5 ? time - 1000 : time) });
+  }
+  BOOST_CHECK_EQUAL(buffer.get_buffer_time(), 150);
+
+  for (int i = 0; i < 10; ++i) {
+    time += 10;
+    buffer.buffer({ make_ta(time) });
+  }
+  BOOST_CHECK_EQUAL(buffer.get_buffer_time(), 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
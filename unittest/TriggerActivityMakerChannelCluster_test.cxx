@@ -0,0 +1,175 @@
+/**
+ * @file TriggerActivityMakerChannelCluster_test.cxx  Channel clustering TA maker Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerActivityMakerChannelCluster.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TriggerActivityMakerChannelCluster_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::TriggerActivityMakerChannelCluster;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+triggeralgs::TriggerPrimitive
+make_tp(triggeralgs::timestamp_t time, uint32_t channel, uint16_t adc_peak = 10) // NOLINT(build/unsigned)
+{
+  triggeralgs::TriggerPrimitive tp;
+  tp.time_start = time;
+  tp.time_peak = time + 2;
+  tp.time_over_threshold = 5;
+  tp.channel = channel;
+  tp.adc_integral = 100;
+  tp.adc_peak = adc_peak;
+  return tp;
+}
+
+nlohmann::json
+make_config()
+{
+  nlohmann::json config;
+  config["time_window"] = 20;
+  config["channel_tolerance"] = 1;
+  config["min_tps"] = 3;
+  return config;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TrackAndNoise)
+{
+  TriggerActivityMakerChannelCluster maker;
+  maker.configure(make_config());
+
+  std::vector<triggeralgs::TriggerActivity> out;
+  // A track crossing channels 100-109, with isolated noise hits in between
+  for (uint32_t i = 0; i < 10; ++i) { // NOLINT(build/unsigned)
+    maker(make_tp(1000 + 10 * i, 100 + i, i == 4 ? 50 : 10), out);
+    maker(make_tp(1005 + 10 * i, 1000 + 50 * i), out);
+  }
+  maker.flush(2000, out);
+
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  auto const& ta = out[0];
+  BOOST_CHECK_EQUAL(ta.inputs.size(), 10);
+  BOOST_CHECK_EQUAL(ta.channel_start, 100);
+  BOOST_CHECK_EQUAL(ta.channel_end, 109);
+  BOOST_CHECK_EQUAL(ta.channel_peak, 104);
+  BOOST_CHECK_EQUAL(ta.time_start, 1000);
+  BOOST_CHECK_EQUAL(ta.time_end, 1095);
+  BOOST_CHECK_EQUAL(ta.adc_integral, 1000);
+  BOOST_CHECK_EQUAL(ta.adc_peak, 50);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ChannelGroups)
+{
+  // The same TPs either side of a plane boundary, with and without the channel map
+  std::vector<triggeralgs::TriggerPrimitive> tps{
+    make_tp(1000, 798), make_tp(1001, 799), make_tp(1002, 800), make_tp(1003, 801)
+  };
+
+  for (bool use_groups : { false, true }) {
+    nlohmann::json config = make_config();
+    if (use_groups) {
+      config["channel_groups"] = { { 0, 799 }, { 800, 1599 } };
+    }
+    TriggerActivityMakerChannelCluster maker;
+    maker.configure(config);
+
+    std::vector<triggeralgs::TriggerActivity> out;
+    for (auto const& tp : tps) {
+      maker(tp, out);
+    }
+    maker.flush(2000, out);
+    // Split in two, each cluster is too small to make a TA
+    BOOST_CHECK_EQUAL(out.size(), use_groups ? 0 : 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Merge)
+{
+  TriggerActivityMakerChannelCluster maker;
+  maker.configure(make_config());
+
+  std::vector<triggeralgs::TriggerActivity> out;
+  // Two branches that start apart and meet on channel 205
+  maker(make_tp(1000, 200), out);
+  maker(make_tp(1000, 210), out);
+  maker(make_tp(1005, 201), out);
+  maker(make_tp(1005, 209), out);
+  maker(make_tp(1010, 202), out);
+  maker(make_tp(1010, 208), out);
+  maker(make_tp(1015, 203), out);
+  maker(make_tp(1015, 207), out);
+  maker(make_tp(1020, 204), out);
+  maker(make_tp(1020, 206), out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 2);
+  maker(make_tp(1025, 205), out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 1);
+
+  // Channels from either branch lead to the merged cluster
+  maker(make_tp(1030, 207), out);
+  maker(make_tp(1030, 203), out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 1);
+
+  maker.flush(2000, out);
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  BOOST_CHECK_EQUAL(out[0].inputs.size(), 13);
+  BOOST_CHECK_EQUAL(out[0].channel_start, 200);
+  BOOST_CHECK_EQUAL(out[0].channel_end, 210);
+}
+
+BOOST_AUTO_TEST_CASE(BoundedActiveClusters)
+{
+  nlohmann::json config = make_config();
+  config["max_active_clusters"] = 2;
+  config["min_tps"] = 1;
+  TriggerActivityMakerChannelCluster maker;
+  maker.configure(config);
+
+  std::vector<triggeralgs::TriggerActivity> out;
+  maker(make_tp(1000, 100), out);
+  maker(make_tp(1001, 200), out);
+  BOOST_CHECK(out.empty());
+  // A third cluster forces the quietest one to close early
+  maker(make_tp(1002, 300), out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 2);
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  BOOST_CHECK_EQUAL(out[0].channel_peak, 100);
+}
+
+BOOST_AUTO_TEST_CASE(TimeWindow)
+{
+  TriggerActivityMakerChannelCluster maker;
+  maker.configure(make_config());
+
+  std::vector<triggeralgs::TriggerActivity> out;
+  maker(make_tp(1000, 100), out);
+  maker(make_tp(1010, 101), out);
+  // Adjacent in channel, but too late to join
+  maker(make_tp(1040, 102), out);
+  maker(make_tp(1045, 103), out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 1);
+
+  // A heartbeat closes clusters that can no longer grow, but not the others
+  maker.flush(1060, out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 1);
+  maker.flush(1066, out);
+  BOOST_CHECK_EQUAL(maker.get_n_active_clusters(), 0);
+  BOOST_CHECK(out.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+/**
+ * @file TriggerActivityMakerComposite_test.cxx  TriggerActivityMakerComposite class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerActivityMakerComposite.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TriggerActivityMakerComposite_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq;
+
+using trigger::TriggerActivityMakerComposite;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+// Emits one TA, tagged with `m_algorithm`, for every `m_group` TPs
+class GroupingMaker : public triggeralgs::TriggerActivityMaker
+{
+public:
+  GroupingMaker(size_t group, triggeralgs::TriggerActivity::Algorithm algorithm)
+    : m_group(group)
+    , m_algorithm(algorithm)
+  {}
+
+  void operator()(const triggeralgs::TriggerPrimitive& tp, std::vector<triggeralgs::TriggerActivity>& out) override
+  {
+    if (++m_n_tps % m_group == 0) {
+      triggeralgs::TriggerActivity ta;
+      ta.time_start = tp.time_start;
+      ta.algorithm = m_algorithm;
+      out.push_back(ta);
+    }
+  }
+
+  void flush(triggeralgs::timestamp_t /*until*/, std::vector<triggeralgs::TriggerActivity>& /*out*/) override
+  {
+    ++m_n_flushes;
+  }
+
+  size_t m_group;
+  triggeralgs::TriggerActivity::Algorithm m_algorithm;
+  size_t m_n_tps{ 0 };
+  size_t m_n_flushes{ 0 };
+};
+
+std::vector<triggeralgs::TriggerPrimitive>
+make_slice(size_t n)
+{
+  std::vector<triggeralgs::TriggerPrimitive> slice(n);
+  for (size_t i = 0; i < n; ++i) {
+    slice[i].time_start = 10 * i;
+  }
+  return slice;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(RunsAllMakers)
+{
+  for (bool parallel : { false, true }) {
+    auto a = std::make_shared<GroupingMaker>(2, triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow);
+    auto b = std::make_shared<GroupingMaker>(5, triggeralgs::TriggerActivity::Algorithm::kSupernova);
+    TriggerActivityMakerComposite composite({ a, b }, parallel);
+    BOOST_CHECK_EQUAL(composite.get_n_makers(), 2);
+
+    auto slice = make_slice(10);
+    std::vector<triggeralgs::TriggerActivity> out;
+    composite(slice.data(), slice.data() + slice.size(), out);
+
+    // Every maker saw every TP, and outputs come in the order the makers were added
+    BOOST_CHECK_EQUAL(a->m_n_tps, 10);
+    BOOST_CHECK_EQUAL(b->m_n_tps, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 5 + 2);
+    for (size_t i = 0; i < 5; ++i) {
+      BOOST_CHECK(out[i].algorithm == triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow);
+    }
+    BOOST_CHECK(out[5].algorithm == triggeralgs::TriggerActivity::Algorithm::kSupernova);
+    BOOST_CHECK_EQUAL(out[6].time_start, 90);
+
+    composite.flush(1000, out);
+    BOOST_CHECK_EQUAL(a->m_n_flushes, 1);
+    BOOST_CHECK_EQUAL(b->m_n_flushes, 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ReusesPoolThreads)
+{
+  auto a = std::make_shared<GroupingMaker>(1, triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow);
+  auto b = std::make_shared<GroupingMaker>(1, triggeralgs::TriggerActivity::Algorithm::kSupernova);
+  auto c = std::make_shared<GroupingMaker>(1, triggeralgs::TriggerActivity::Algorithm::kPrescale);
+  TriggerActivityMakerComposite composite({ a, b, c }, true);
+
+  // The same pool threads run every slice
+  auto slice = make_slice(3);
+  for (size_t i = 0; i < 100; ++i) {
+    std::vector<triggeralgs::TriggerActivity> out;
+    composite(slice.data(), slice.data() + slice.size(), out);
+    BOOST_REQUIRE_EQUAL(out.size(), 9);
+    BOOST_CHECK(out[3].algorithm == triggeralgs::TriggerActivity::Algorithm::kSupernova);
+    BOOST_CHECK(out[8].algorithm == triggeralgs::TriggerActivity::Algorithm::kPrescale);
+  }
+  BOOST_CHECK_EQUAL(c->m_n_tps, 300);
+}
+
+BOOST_AUTO_TEST_CASE(RethrowsFromPoolThread)
+{
+  // Throws when it sees a TP
+  class ThrowingMaker : public triggeralgs::TriggerActivityMaker
+  {
+  public:
+    void operator()(const triggeralgs::TriggerPrimitive& /*tp*/,
+                    std::vector<triggeralgs::TriggerActivity>& /*out*/) override
+    {
+      throw std::runtime_error("ThrowingMaker");
+    }
+  };
+
+  auto a = std::make_shared<GroupingMaker>(1, triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow);
+  TriggerActivityMakerComposite composite({ a, std::make_shared<ThrowingMaker>() }, true);
+  auto slice = make_slice(2);
+  std::vector<triggeralgs::TriggerActivity> out;
+  BOOST_CHECK_THROW(composite(slice.data(), slice.data() + slice.size(), out), std::runtime_error);
+
+  // The pool is still usable afterwards
+  BOOST_CHECK_THROW(composite(slice.data(), slice.data() + slice.size(), out), std::runtime_error);
+  BOOST_CHECK_EQUAL(a->m_n_tps, 4);
+}
+
+BOOST_AUTO_TEST_CASE(RoutesOutputs)
+{
+  for (bool parallel : { false, true }) {
+    auto a = std::make_shared<GroupingMaker>(2, triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow);
+    auto b = std::make_shared<GroupingMaker>(5, triggeralgs::TriggerActivity::Algorithm::kSupernova);
+    auto c = std::make_shared<GroupingMaker>(10, triggeralgs::TriggerActivity::Algorithm::kUnknown);
+    TriggerActivityMakerComposite composite({ a, b, c }, parallel, { 0, 1, 1 });
+    BOOST_CHECK_EQUAL(composite.get_n_routes(), 1);
+
+    // Only route 0 goes into the output vector
+    auto slice = make_slice(10);
+    std::vector<triggeralgs::TriggerActivity> out;
+    composite(slice.data(), slice.data() + slice.size(), out);
+    BOOST_CHECK_EQUAL(out.size(), 5);
+
+    std::vector<triggeralgs::TriggerActivity> routed;
+    composite.take_outputs(1, routed);
+    BOOST_REQUIRE_EQUAL(routed.size(), 2 + 1);
+    BOOST_CHECK(routed[0].algorithm == triggeralgs::TriggerActivity::Algorithm::kSupernova);
+    BOOST_CHECK(routed[2].algorithm == triggeralgs::TriggerActivity::Algorithm::kUnknown);
+
+    // Taking forgets them
+    routed.clear();
+    composite.take_outputs(1, routed);
+    BOOST_CHECK(routed.empty());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Registered)
+{
+  // The module looks the composite up like any plugin, so it gets its batch entry point
+  TriggerActivityMakerComposite composite({}, false);
+  triggeralgs::TriggerActivityMaker& base = composite;
+  auto processor =
+    trigger::find_slice_processor<triggeralgs::TriggerActivityMaker, triggeralgs::TriggerPrimitive, triggeralgs::TriggerActivity>(
+      base);
+  BOOST_CHECK(processor != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
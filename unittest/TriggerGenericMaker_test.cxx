@@ -0,0 +1,319 @@
+/**
+ * @file TriggerGenericMaker_test.cxx  TriggerGenericMaker class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerGenericMaker.hpp"
+
+#include "trigger/TASet.hpp"
+#include "trigger/TPSet.hpp"
+#include "trigger/TriggerActivityMakerComposite.hpp"
+
+#include "appfwk/QueueRegistry.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TriggerGenericMaker_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::trigger;
+
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerPrimitive;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+// Makes one TA per TP, with the maker's tag in adc_integral, so that the
+// test can tell which maker made each TA
+class TagActivityMaker : public triggeralgs::TriggerActivityMaker
+{
+public:
+  explicit TagActivityMaker(uint64_t tag) // NOLINT(build/unsigned)
+    : m_tag(tag)
+  {}
+
+  void operator()(const TriggerPrimitive& tp, std::vector<TriggerActivity>& output) override
+  {
+    TriggerActivity ta;
+    ta.time_start = tp.time_start;
+    ta.time_end = tp.time_start;
+    ta.adc_integral = m_tag;
+    ta.inputs.push_back(tp);
+    output.push_back(ta);
+  }
+
+private:
+  uint64_t m_tag; // NOLINT(build/unsigned)
+};
+
+class TagTAMaker
+  : public TriggerGenericMaker<Set<TriggerPrimitive>, Set<TriggerActivity>, triggeralgs::TriggerActivityMaker>
+{
+public:
+  explicit TagTAMaker(const std::string& name)
+    : TriggerGenericMaker(name)
+  {}
+
+  size_t tardy_count() const { return get_tardy_count(); }
+
+private:
+  std::shared_ptr<triggeralgs::TriggerActivityMaker> make_maker(const nlohmann::json& obj) override
+  {
+    auto tag = obj.at("tag").get<uint64_t>(); // NOLINT(build/unsigned)
+    set_algorithm_name("Tag" + std::to_string(tag));
+    set_windowing(obj.at("window_time").get<daqdataformats::timestamp_t>(), 0);
+    return std::make_shared<TagActivityMaker>(tag);
+  }
+};
+
+// Sends the TAs of a tag 1 maker to the main output, and those of a tag 2
+// maker to the "other" output
+class RoutedTAMaker
+  : public TriggerGenericMaker<Set<TriggerPrimitive>, Set<TriggerActivity>, triggeralgs::TriggerActivityMaker>
+{
+public:
+  explicit RoutedTAMaker(const std::string& name)
+    : TriggerGenericMaker(name)
+  {}
+
+private:
+  std::shared_ptr<triggeralgs::TriggerActivityMaker> make_maker(const nlohmann::json& obj) override
+  {
+    set_algorithm_name("Routed");
+    set_windowing(obj.at("window_time").get<daqdataformats::timestamp_t>(), 0);
+    set_output_queues({ obj.at("other").get<std::string>() });
+    return std::make_shared<TriggerActivityMakerComposite>(
+      std::vector<std::shared_ptr<triggeralgs::TriggerActivityMaker>>{ std::make_shared<TagActivityMaker>(1),
+                                                                       std::make_shared<TagActivityMaker>(2) },
+      false,
+      std::vector<size_t>{ 0, 1 });
+  }
+};
+
+// The queue registry can only be configured once, so configure the queues
+// for all the test cases together
+void
+configure_queues()
+{
+  static bool configured = false;
+  if (configured) {
+    return;
+  }
+  appfwk::QueueRegistry::get().configure(
+    { { "tpsets", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 1000 } },
+      { "tasets", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 1000 } },
+      { "other_tasets", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 1000 } } });
+  configured = true;
+}
+
+std::unique_ptr<TagTAMaker>
+make_module(uint64_t tag, daqdataformats::timestamp_t window_time) // NOLINT(build/unsigned)
+{
+  configure_queues();
+  auto module = std::make_unique<TagTAMaker>("tam");
+  module->init({ { "qinfos",
+                   { { { "name", "input" }, { "inst", "tpsets" }, { "dir", "input" } },
+                     { { "name", "output" }, { "inst", "tasets" }, { "dir", "output" } } } } });
+  module->execute_command("conf", { { "tag", tag }, { "window_time", window_time } });
+  return module;
+}
+
+// A TPSet holding one TP at each time in [begin, end), `step` apart
+void
+push_tps(daqdataformats::timestamp_t begin, daqdataformats::timestamp_t end, daqdataformats::timestamp_t step)
+{
+  auto queue = appfwk::QueueRegistry::get().get_queue<TPSet>("tpsets");
+  for (auto time = begin; time < end; time += step) {
+    TPSet tpset;
+    tpset.type = TPSet::Type::kPayload;
+    tpset.start_time = time;
+    tpset.end_time = time + step;
+    TriggerPrimitive tp;
+    tp.time_start = time;
+    tpset.objects.push_back(tp);
+    queue->push(std::move(tpset), std::chrono::milliseconds(1000));
+  }
+}
+
+void
+push_heartbeat(daqdataformats::timestamp_t time)
+{
+  TPSet heartbeat;
+  heartbeat.type = TPSet::Type::kHeartbeat;
+  heartbeat.start_time = time;
+  heartbeat.end_time = time;
+  appfwk::QueueRegistry::get().get_queue<TPSet>("tpsets")->push(std::move(heartbeat), std::chrono::milliseconds(1000));
+}
+
+// Pop TASets until `n_heartbeats` heartbeats have been forwarded, or, if
+// that's zero, until the queue stays empty
+void
+pop_tasets(std::vector<TASet>& tasets, size_t n_heartbeats = 0, const std::string& queue_name = "tasets")
+{
+  auto queue = appfwk::QueueRegistry::get().get_queue<TASet>(queue_name);
+  while (true) {
+    TASet taset;
+    try {
+      queue->pop(taset, std::chrono::milliseconds(n_heartbeats ? 5000 : 100));
+    } catch (const appfwk::QueueTimeoutExpired&) {
+      BOOST_REQUIRE_EQUAL(n_heartbeats, 0);
+      return;
+    }
+    bool heartbeat = taset.type == TASet::Type::kHeartbeat;
+    tasets.push_back(std::move(taset));
+    if (heartbeat && n_heartbeats != 0 && --n_heartbeats == 0) {
+      return;
+    }
+  }
+}
+
+// Check that the payload TASets are time ordered, don't overlap, and hold
+// every TA exactly once, inside its window. None may start before a
+// heartbeat that was sent before it
+void
+check_windows(const std::vector<TASet>& tasets, size_t n_tas)
+{
+  size_t n_found = 0;
+  daqdataformats::timestamp_t prev_end = 0, heartbeat_time = 0;
+  for (auto const& taset : tasets) {
+    if (taset.type == TASet::Type::kHeartbeat) {
+      BOOST_CHECK_GE(taset.end_time, heartbeat_time);
+      heartbeat_time = taset.end_time;
+    }
+    if (taset.type != TASet::Type::kPayload) {
+      continue;
+    }
+    BOOST_CHECK_GE(taset.start_time, heartbeat_time);
+    BOOST_CHECK_GE(taset.start_time, prev_end);
+    BOOST_CHECK_LT(taset.start_time, taset.end_time);
+    prev_end = taset.end_time;
+    for (auto const& ta : taset.objects) {
+      BOOST_CHECK_GE(ta.time_start, taset.start_time);
+      BOOST_CHECK_LE(ta.time_start, taset.end_time);
+    }
+    n_found += taset.objects.size();
+  }
+  BOOST_CHECK_EQUAL(n_found, n_tas);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ReconfigureDuringRun)
+{
+  auto module = make_module(1, 100);
+  module->execute_command("start", nlohmann::json::object());
+
+  std::vector<TASet> tasets;
+  push_tps(1000, 1500, 10);
+  push_heartbeat(1500);
+  pop_tasets(tasets, 1);
+
+  // The new maker takes over at the next heartbeat after the reconfigure,
+  // so everything before that heartbeat still goes to the old one
+  module->execute_command("reconfigure", { { "tag", 2 }, { "window_time", 40 } });
+  push_tps(1500, 2000, 10);
+  push_heartbeat(2000);
+  push_tps(2000, 2500, 10);
+  push_heartbeat(2500);
+  pop_tasets(tasets, 2);
+
+  module->execute_command("stop", nlohmann::json::object());
+  pop_tasets(tasets);
+
+  check_windows(tasets, 150);
+  BOOST_CHECK_EQUAL(module->tardy_count(), 0);
+  for (auto const& taset : tasets) {
+    if (taset.type != TASet::Type::kPayload) {
+      continue;
+    }
+    // The window time changes when the new maker is swapped in, but windows
+    // that were already being buffered are kept, not dropped or overlapped
+    BOOST_CHECK_LE(taset.end_time - taset.start_time, taset.start_time >= 2000 ? 40 : 100);
+    for (auto const& ta : taset.objects) {
+      BOOST_CHECK_EQUAL(ta.adc_integral, ta.time_start < 2000 ? 1 : 2);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RepeatedReconfigure)
+{
+  auto module = make_module(1, 100);
+  module->execute_command("start", nlohmann::json::object());
+
+  // Reconfigure on the command thread while the worker thread is busy
+  std::atomic<bool> done{ false };
+  std::thread commands([&]() {
+    for (uint64_t tag = 2; !done.load(); ++tag) { // NOLINT(build/unsigned)
+      module->execute_command("reconfigure", { { "tag", tag }, { "window_time", 100 } });
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  std::vector<TASet> tasets;
+  for (daqdataformats::timestamp_t time = 1000; time < 11000; time += 500) {
+    push_tps(time, time + 500, 10);
+    push_heartbeat(time + 500);
+    pop_tasets(tasets, 1);
+  }
+  done = true;
+  commands.join();
+
+  module->execute_command("stop", nlohmann::json::object());
+  pop_tasets(tasets);
+
+  check_windows(tasets, 1000);
+  BOOST_CHECK_EQUAL(module->tardy_count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(RoutedOutputQueue)
+{
+  configure_queues();
+  RoutedTAMaker module("rtam");
+  module.init({ { "qinfos",
+                  { { { "name", "input" }, { "inst", "tpsets" }, { "dir", "input" } },
+                    { { "name", "output" }, { "inst", "tasets" }, { "dir", "output" } },
+                    { { "name", "other_output" }, { "inst", "other_tasets" }, { "dir", "output" } } } } });
+
+  // Only the module's own queues can be named
+  BOOST_CHECK_THROW(module.execute_command("conf", { { "window_time", 100 }, { "other", "tasets" } }),
+                    UnknownOutputQueue);
+  module.execute_command("conf", { { "window_time", 100 }, { "other", "other_output" } });
+  module.execute_command("start", nlohmann::json::object());
+
+  push_tps(1000, 1500, 10);
+  push_heartbeat(1500);
+  std::vector<TASet> main_tasets, other_tasets;
+  pop_tasets(main_tasets, 1);
+  pop_tasets(other_tasets, 1, "other_tasets");
+
+  module.execute_command("stop", nlohmann::json::object());
+  pop_tasets(main_tasets);
+  pop_tasets(other_tasets, 0, "other_tasets");
+
+  // Each queue has its own complete windows, heartbeats and sequence numbers
+  for (auto* tasets : { &main_tasets, &other_tasets }) {
+    check_windows(*tasets, 50);
+    for (size_t i = 0; i < tasets->size(); ++i) {
+      BOOST_CHECK_EQUAL((*tasets)[i].seqno, i);
+      for (auto const& ta : (*tasets)[i].objects) {
+        BOOST_CHECK_EQUAL(ta.adc_integral, tasets == &main_tasets ? 1 : 2);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
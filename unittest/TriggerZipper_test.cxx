@@ -72,12 +72,40 @@ struct TPSetSrc
     ++tpset.seqno;
     tpset.origin.region_id = 0;
     tpset.origin.element_id = element_id;
+    tpset.type = trigger::TPSet::Type::kPayload;
     tpset.start_time = datatime;
     tpset.end_time = datatime + dt;
     return tpset;
   }
+
+  trigger::TPSet heartbeat(timestamp_t datatime)
+  {
+    trigger::TPSet hb = (*this)(datatime);
+    hb.type = trigger::TPSet::Type::kHeartbeat;
+    hb.end_time = datatime;
+    return hb;
+  }
 };
 
+// The queue registry can only be configured once, so configure the queues
+// for all the test cases together
+static void
+configure_queues()
+{
+  static bool configured = false;
+  if (configured) {
+    return;
+  }
+  appfwk::QueueRegistry::get().configure(
+    { { "source", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+      { "sink", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+      { "hb_source", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+      { "hb_sink", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+      { "quiet_source", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
+      { "quiet_sink", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } } });
+  configured = true;
+}
+
 static void
 pop_must_timeout(tpset_queue_ptr out)
 {
@@ -106,11 +134,9 @@ push0(tpset_queue_ptr in, trigger::TPSet&& tpset)
 
 BOOST_AUTO_TEST_CASE(ZipperScenario1)
 {
+  configure_queues();
   auto& qr = appfwk::QueueRegistry::get();
 
-  qr.configure({ { "source", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } },
-                 { "sink", appfwk::QueueConfig{ appfwk::QueueConfig::kStdDeQueue, 10 } } });
-
   auto in = qr.get_queue<trigger::TPSet>("source");
   auto out = qr.get_queue<trigger::TPSet>("sink");
 
@@ -156,4 +182,110 @@ BOOST_AUTO_TEST_CASE(ZipperScenario1)
   zip.reset(nullptr);
 }
 
+BOOST_AUTO_TEST_CASE(ZipperCoalescesHeartbeats)
+{
+  configure_queues();
+  auto& qr = appfwk::QueueRegistry::get();
+
+  auto in = qr.get_queue<trigger::TPSet>("hb_source");
+  auto out = qr.get_queue<trigger::TPSet>("hb_sink");
+
+  auto zip = std::make_unique<trigger::TPZipper>("zs2");
+
+  zip->set_input("hb_source");
+  zip->set_output("hb_sink");
+
+  // Lossless, so that the output doesn't depend on timing
+  trigger::TPZipper::cfg_t cfg{ 2, 0, 1, 20 };
+  cfg.coalesce_heartbeats = true;
+  nlohmann::json jcfg = cfg, jempty;
+  zip->do_configure(jcfg);
+
+  TPSetSrc s1{ 1 }, s2{ 2 };
+
+  zip->do_start(jempty);
+
+  push0(in, s1.heartbeat(10));
+  push0(in, s2.heartbeat(12));
+  push0(in, s1(20));
+  push0(in, s2(22));
+
+  // Both streams have heartbeated, so a heartbeat goes out for the earlier of the two
+  auto got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kHeartbeat);
+  BOOST_CHECK_EQUAL(got.start_time, 10);
+
+  push0(in, s1.heartbeat(30));
+  push0(in, s2.heartbeat(32));
+
+  got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kPayload);
+  BOOST_CHECK_EQUAL(got.start_time, 20);
+  got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kPayload);
+  BOOST_CHECK_EQUAL(got.start_time, 22);
+
+  // The zipper is waiting for more from stream 2 before it passes on stream
+  // 1's heartbeat at 30
+  pop_must_timeout(out);
+
+  zip->do_stop(jempty); // triggers a flush
+
+  // Stream 2's heartbeat at 12 is the limit until its heartbeat at 32 comes out
+  got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kHeartbeat);
+  BOOST_CHECK_EQUAL(got.start_time, 12);
+  BOOST_CHECK_EQUAL(got.end_time, 12);
+  got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kHeartbeat);
+  BOOST_CHECK_EQUAL(got.start_time, 30);
+  pop_must_timeout(out);
+
+  zip.reset(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(ZipperCoalescesWithSilentStream)
+{
+  configure_queues();
+  auto& qr = appfwk::QueueRegistry::get();
+
+  auto in = qr.get_queue<trigger::TPSet>("quiet_source");
+  auto out = qr.get_queue<trigger::TPSet>("quiet_sink");
+
+  auto zip = std::make_unique<trigger::TPZipper>("zs3");
+
+  zip->set_input("quiet_source");
+  zip->set_output("quiet_sink");
+
+  trigger::TPZipper::cfg_t cfg{ 2, 50, 1, 20 };
+  cfg.coalesce_heartbeats = true;
+  nlohmann::json jcfg = cfg, jempty;
+  zip->do_configure(jcfg);
+
+  // Stream 2 never sends anything, so once max_latency has passed, stream
+  // 1's heartbeats alone move the watermark on
+  TPSetSrc s1{ 1 };
+
+  zip->do_start(jempty);
+
+  push0(in, s1.heartbeat(10));
+  auto got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kHeartbeat);
+  BOOST_CHECK_EQUAL(got.start_time, 10);
+
+  push0(in, s1(20));
+  push0(in, s1.heartbeat(30));
+  got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kPayload);
+  BOOST_CHECK_EQUAL(got.start_time, 20);
+  got = pop_must_succeed(out);
+  BOOST_CHECK(got.type == trigger::TPSet::Type::kHeartbeat);
+  BOOST_CHECK_EQUAL(got.start_time, 30);
+
+  zip->do_stop(jempty);
+  pop_must_timeout(out);
+
+  zip.reset(nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()